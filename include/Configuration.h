@@ -114,6 +114,14 @@ struct CONFIG_T {
         bool Retain;
         uint32_t PublishInterval;
         bool CleanSession;
+        uint8_t PayloadMode;
+
+        struct {
+            bool Enabled;
+            uint32_t MaxAge;
+            float Deadband;
+            float DeadbandAbsolute;
+        } OnChange;
 
         struct {
             char Topic[MQTT_MAX_TOPIC_STRLEN + 1];
@@ -142,6 +150,11 @@ struct CONFIG_T {
     struct {
         uint64_t Serial;
         uint32_t PollInterval;
+        struct {
+            bool Enabled;
+            uint32_t MinInterval;
+            uint32_t MaxInterval;
+        } AdaptivePoll;
         struct {
             uint8_t PaLevel;
         } Nrf;
@@ -152,6 +165,11 @@ struct CONFIG_T {
         } Cmt;
     } Dtu;
 
+    struct {
+        bool Enabled;
+        uint32_t Interval;
+    } History;
+
     struct {
         char Password[WIFI_MAX_PASSWORD_STRLEN + 1];
         bool AllowReadonly;
@@ -1,14 +1,19 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "Configuration.h"
+#include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
-#include <mutex>
+#include <atomic>
 
 class DatastoreClass {
 public:
     DatastoreClass();
     void init(Scheduler& scheduler);
 
+    // Recalculates all totals with the next iteration, e.g. after the inverter settings changed
+    void forceUpdate();
+
     // Sum of yield total of all enabled inverters, a inverter which is just disabled at night is also included
     float getTotalAcYieldTotalEnabled();
 
@@ -60,26 +65,59 @@ public:
 private:
     void loop();
 
+    // Values of one inverter which are part of the totals. They are only
+    // calculated again if the statistics generation or the state changed.
+    struct InverterState_t {
+        uint64_t serial = 0;
+        const INVERTER_CONFIG_T* config = nullptr;
+        bool valid = false;
+
+        uint32_t generation = 0;
+        bool pollEnabled = false;
+        bool reachable = false;
+        bool configPollEnabled = false;
+        bool addToTotal = false;
+
+        bool producing = false;
+        float acYieldTotal = 0;
+        float acYieldDay = 0;
+        float acPower = 0;
+        float dcPower = 0;
+        float dcPowerIrradiation = 0;
+        float dcIrradiationInstalled = 0;
+        uint8_t acYieldTotalDigits = 0;
+        uint8_t acYieldDayDigits = 0;
+        uint8_t acPowerDigits = 0;
+        uint8_t dcPowerDigits = 0;
+    };
+
+    // Returns true if the state of the inverter changed
+    bool updateInverter(InverterState_t& state, InverterAbstract* inv);
+
+    void updateTotals();
+
     Task _loopTask;
 
-    std::mutex _mutex;
-
-    float _totalAcYieldTotalEnabled = 0;
-    float _totalAcYieldDayEnabled = 0;
-    float _totalAcPowerEnabled = 0;
-    float _totalDcPowerEnabled = 0;
-    float _totalDcPowerIrradiation = 0;
-    float _totalDcIrradiationInstalled = 0;
-    float _totalDcIrradiation = 0;
-    uint32_t _totalAcYieldTotalDigits = 0;
-    uint32_t _totalAcYieldDayDigits = 0;
-    uint32_t _totalAcPowerDigits = 0;
-    uint32_t _totalDcPowerDigits = 0;
-    bool _isAtLeastOneReachable = false;
-    bool _isAtLeastOneProducing = false;
-    bool _isAllEnabledProducing = false;
-    bool _isAllEnabledReachable = false;
-    bool _isAtLeastOnePollEnabled = false;
+    InverterState_t _inverters[INV_MAX_COUNT];
+    uint8_t _inverterCount = 0;
+    std::atomic<bool> _forceUpdate = { true };
+
+    std::atomic<float> _totalAcYieldTotalEnabled = { 0 };
+    std::atomic<float> _totalAcYieldDayEnabled = { 0 };
+    std::atomic<float> _totalAcPowerEnabled = { 0 };
+    std::atomic<float> _totalDcPowerEnabled = { 0 };
+    std::atomic<float> _totalDcPowerIrradiation = { 0 };
+    std::atomic<float> _totalDcIrradiationInstalled = { 0 };
+    std::atomic<float> _totalDcIrradiation = { 0 };
+    std::atomic<uint32_t> _totalAcYieldTotalDigits = { 0 };
+    std::atomic<uint32_t> _totalAcYieldDayDigits = { 0 };
+    std::atomic<uint32_t> _totalAcPowerDigits = { 0 };
+    std::atomic<uint32_t> _totalDcPowerDigits = { 0 };
+    std::atomic<bool> _isAtLeastOneReachable = { false };
+    std::atomic<bool> _isAtLeastOneProducing = { false };
+    std::atomic<bool> _isAllEnabledProducing = { false };
+    std::atomic<bool> _isAllEnabledReachable = { false };
+    std::atomic<bool> _isAtLeastOnePollEnabled = { false };
 };
 
 extern DatastoreClass Datastore;
@@ -1,11 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "SparklineBuffer.h"
 #include <TaskSchedulerDeclarations.h>
 #include <U8g2lib.h>
-#include <array>
 
-#define MAX_DATAPOINTS 128
+#define MAX_DATAPOINTS SPARKLINE_CAPACITY
 
 class DisplayGraphicDiagramClass {
 public:
@@ -16,6 +16,9 @@ public:
 
     void updatePeriod();
 
+    // Power history of the diagram, one base bucket per data point
+    SparklineBuffer& getSeries();
+
 private:
     void averageLoop();
     void dataPointLoop();
@@ -26,11 +29,13 @@ private:
     Task _dataPointTask;
 
     U8G2* _display = nullptr;
-    std::array<float, MAX_DATAPOINTS> _graphValues = {};
-    uint8_t _graphValuesCount = 0;
+    SparklineBuffer _series;
+    uint32_t _dataPointInterval = 0;
 
     uint8_t _chartWidth = MAX_DATAPOINTS;
 
     float _iRunningAverage = 0;
+    float _iRunningMin = 0;
+    float _iRunningMax = 0;
     uint16_t _iRunningAverageCnt = 0;
 };
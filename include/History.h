@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Configuration.h"
+#include <LittleFS.h>
+#include <TaskSchedulerDeclarations.h>
+#include <ctime>
+#include <mutex>
+
+#define HISTORY_PATH "/history"
+#define HISTORY_DAILY_FILE HISTORY_PATH "/daily.hst"
+
+// Days of samples and hourly rollups kept in the segments (one file per day)
+#define HISTORY_SEGMENT_DAYS 31
+
+// Days kept in the daily rollup file
+#define HISTORY_DAILY_DAYS 366
+
+// Bytes of the filesystem which are always kept free for the configuration and
+// other files. config.json is written as a new file before the old one is
+// removed, therefore this has to cover twice its size plus some blocks.
+#define HISTORY_FS_RESERVE (48 * 1024)
+
+// Encoded samples of one inverter which are kept in RAM until they are written as one block
+#define HISTORY_BLOCK_SIZE 512
+
+#define SECONDS_PER_HOUR 3600
+#define SECONDS_PER_DAY 86400
+
+enum HistoryBlockType_t : uint8_t {
+    HISTORY_BLOCK_SAMPLES = 1,
+    HISTORY_BLOCK_HOURLY,
+};
+
+// Every block of a segment starts with this header, followed by length bytes of payload
+struct __attribute__((packed)) HistoryBlockHeader_t {
+    uint8_t type;
+    uint8_t channels; // DC channels per sample
+    uint16_t length;
+    uint32_t start; // UTC timestamp of the first sample or the hour
+    uint64_t serial;
+};
+
+// Payload of a HISTORY_BLOCK_HOURLY block
+struct __attribute__((packed)) HistoryHourly_t {
+    uint32_t acPowerAvg; // 0.1 W
+    uint32_t acPowerMax; // 0.1 W
+    uint32_t energy; // Wh
+};
+
+// Record of the daily rollup file
+struct __attribute__((packed)) HistoryDaily_t {
+    uint32_t day; // days since epoch (UTC)
+    uint64_t serial;
+    uint32_t acPowerMax; // 0.1 W
+    uint32_t energy; // Wh
+};
+
+// Decoded sample. Samples are stored as varint coded differences to the
+// previous sample of the block, the first one to zero.
+struct HistorySample_t {
+    uint32_t time;
+    int32_t acPower; // 0.1 W
+    int32_t yieldTotal; // Wh
+    int32_t dcPower[INV_MAX_CHAN_COUNT]; // 0.1 W
+};
+
+class HistoryClass {
+public:
+    HistoryClass();
+    void init(Scheduler& scheduler);
+
+    // Copies the samples of the inverter which were not written to flash yet, returns false if there are none
+    bool getPendingBlock(const uint64_t serial, HistoryBlockHeader_t& header, uint8_t* data);
+
+    // Rollup of the current hour of the inverter, returns false if there are no samples
+    bool getPendingHourly(const uint64_t serial, uint32_t& start, HistoryHourly_t& hourly);
+
+    static String getSegmentPath(const uint32_t day);
+
+    // Returns the number of bytes written or 0 if the buffer is too small
+    static size_t encodeSample(uint8_t* buffer, const size_t size, const HistorySample_t& sample, const HistorySample_t& previous, const uint8_t channels);
+
+    // Decodes the sample following the previous one, returns the number of bytes read or 0 if the data is incomplete
+    static size_t decodeSample(const uint8_t* buffer, const size_t len, HistorySample_t& sample, const uint8_t channels);
+
+protected:
+    void loop();
+
+    // Current UTC time, replaced by the tests
+    virtual time_t getTime() const;
+
+private:
+    struct Buffer_t {
+        uint64_t serial = 0;
+        HistoryBlockHeader_t header = {};
+        uint8_t data[HISTORY_BLOCK_SIZE];
+        HistorySample_t last = {};
+
+        // rollup of the current hour
+        uint32_t hour = 0;
+        uint64_t acPowerSum = 0;
+        uint32_t count = 0;
+        int32_t acPowerMax = 0;
+        int32_t firstYield = 0;
+        int32_t lastYield = 0;
+    };
+
+    void addSample(Buffer_t& buffer, const HistorySample_t& sample, const uint8_t channels);
+    static HistoryHourly_t getHourly(const Buffer_t& buffer);
+
+    // Writes the samples and rollups of all buffers whose hour or inverter
+    // changed. The blocks of all inverters are written with one append per
+    // segment, which rewrites the last flash block of the segment only once.
+    void writeFinished(const uint32_t hour);
+
+    // Aggregates the hourly rollups of a finished day into the daily rollup file
+    void writeDaily(const uint32_t day);
+
+    // Writes the daily rollups of all days which were missed while the device was off
+    void writeMissingDaily(const uint32_t today);
+
+    // Removes segments and daily rollups which are older than their retention
+    void rotate(const uint32_t today);
+
+    bool appendBlock(const HistoryBlockHeader_t& header, const void* payload);
+    size_t writeBlock(File& file, const HistoryBlockHeader_t& header, const void* payload);
+
+    // Removes the oldest segments until the bytes can be written without
+    // touching HISTORY_FS_RESERVE. The segment of keepDay is never removed.
+    // Returns false if there is still not enough space.
+    bool reserveSpace(const size_t bytes, const uint32_t keepDay);
+
+    Task _loopTask;
+
+    std::mutex _mutex;
+
+    Buffer_t _buffers[INV_MAX_COUNT];
+
+    uint32_t _lastSlot = 0;
+    uint32_t _day = 0;
+
+    // Bytes appended to flash since boot
+    uint32_t _bytesWritten = 0;
+};
+
+extern HistoryClass History;
@@ -6,6 +6,9 @@
 
 #define INVERTER_UPDATE_SETTINGS_INTERVAL 60000l
 
+#define HOYMILES_TASK_STACK_SIZE 6144
+#define HOYMILES_TASK_PRIORITY 2 // above loopTask to handle radio events in time
+
 class InverterSettingsClass {
 public:
     InverterSettingsClass();
@@ -13,10 +16,10 @@ public:
 
 private:
     void settingsLoop();
-    void hoyLoop();
+    static void hoyTask(void* pvParameters);
 
     Task _settingsTask;
-    Task _hoyTask;
+    TaskHandle_t _hoyTaskHandle = nullptr;
 };
 
 extern InverterSettingsClass InverterSettings;
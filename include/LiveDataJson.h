@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <Hoymiles.h>
+#include <vector>
+
+// Last value of a field sent with the delta protocol, scaled by its digits
+struct WsLiveDeltaField_t {
+    uint16_t id;
+    uint8_t digits;
+    int32_t value;
+};
+
+struct WsLiveDeltaState_t {
+    uint64_t serial = 0;
+    std::vector<WsLiveDeltaField_t> fields;
+};
+
+// Live data of a single inverter as sent by the websockets and /api/livedata/status
+class LiveDataJson {
+public:
+    static void generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
+    static void generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv, JsonObject* fieldIds = nullptr);
+    static void generateInverterRadioJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
+
+    // Only the fields which changed since the state was updated the last time.
+    // Reset the serial of the state to send all fields again.
+    static void generateInverterDeltaJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv, WsLiveDeltaState_t& state);
+
+    // Compact numeric id of a field used by the delta protocol
+    static uint16_t getFieldId(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+
+private:
+    static void addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const StatisticsSnapshot& snapshot, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic = "", JsonObject* fieldIds = nullptr);
+};
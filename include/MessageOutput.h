@@ -5,11 +5,20 @@
 #include <TaskSchedulerDeclarations.h>
 #include <Print.h>
 #include <freertos/task.h>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
-#include <unordered_map>
-#include <queue>
-#include <memory>
+
+// number of complete log records kept until all outputs consumed them
+#define MESSAGE_OUTPUT_RECORD_COUNT 32
+
+// maximum length of one log record, longer lines are split into several records
+#define MESSAGE_OUTPUT_RECORD_SIZE 256
+
+// number of tasks which can write an incomplete line at the same time
+#define MESSAGE_OUTPUT_PARTIAL_COUNT 4
 
 class MessageOutputClass : public Print {
 public:
@@ -17,6 +26,7 @@ public:
     void init(Scheduler& scheduler);
     size_t write(uint8_t c) override;
     size_t write(const uint8_t* buffer, size_t size) override;
+    void flush() override;
     void register_ws_output(AsyncWebSocket* output);
 
     static int log_vprintf(const char *fmt, va_list arguments);
@@ -28,11 +38,55 @@ private:
 
     using message_t = std::vector<uint8_t>;
 
-    // we keep a buffer for every task and only write complete lines to the
-    // serial output and then move them to be pushed through the websocket.
-    // this way we prevent mangling of messages from different contexts.
-    std::unordered_map<TaskHandle_t, message_t> _task_messages;
-    std::queue<message_t> _lines;
+    // complete lines (or parts of too long lines) are stored in a ring of
+    // preallocated records. writers reserve a record with a compare and swap
+    // of the head and never wait: if the ring is full, the record is dropped
+    // and counted. a record is readable once its sequence number was set.
+    struct record_t {
+        std::atomic<uint32_t> seq;
+        uint16_t len;
+        uint8_t data[MESSAGE_OUTPUT_RECORD_SIZE];
+    };
+    std::array<record_t, MESSAGE_OUTPUT_RECORD_COUNT> _records;
+    std::atomic<uint32_t> _head { 0 };
+    std::atomic<uint32_t> _overruns { 0 };
+    uint32_t _reported_overruns = 0;
+
+    bool pushRecord(const uint8_t* data, const size_t len);
+
+    // adds a complete record to the ring. until the scheduler runs loop() the
+    // serial port is written by the writer itself, as long as it gets the lock
+    // of the serial port without waiting.
+    void writeRecord(const uint8_t* data, const size_t len, const bool fromIsr);
+
+    // set by the first run of loop(), afterwards all outputs are written by loop()
+    std::atomic<bool> _loopRunning { false };
+
+    // every output reads the records independently from its own cursor
+    enum consumer_t {
+        CONSUMER_SERIAL = 0,
+        CONSUMER_SYSLOG,
+        CONSUMER_WEBSOCKET,
+        CONSUMER_COUNT,
+    };
+    std::array<std::atomic<uint32_t>, CONSUMER_COUNT> _cursors = {};
+
+    // returns the next record of the consumer or nullptr if there is none
+    const record_t* peekRecord(const consumer_t consumer) const;
+    void popRecord(const consumer_t consumer);
+
+    // we keep a buffer for every task which writes an incomplete line and
+    // only publish complete lines. this way we prevent mangling of messages
+    // from different contexts. a buffer is claimed by a compare and swap of
+    // its owner and released as soon as the line is complete.
+    struct partial_t {
+        std::atomic<TaskHandle_t> owner;
+        size_t len;
+        uint8_t data[MESSAGE_OUTPUT_RECORD_SIZE];
+    };
+    std::array<partial_t, MESSAGE_OUTPUT_PARTIAL_COUNT> _partials;
+
+    partial_t* getPartial(const TaskHandle_t task, const bool claim);
 
     // we chunk the websocket output to circumvent issues with TCP delayed ACKs:
     // if the websocket client (Windows in particular) is using delayed ACKs,
@@ -43,17 +97,21 @@ private:
     // "motivate" the client to send out ACKs immediately as the TCP packets are
     // "large", or we will wait long enough for the TCP stack to send out the
     // ACK anyways.
-    void send_ws_chunk(message_t&& line);
+    void send_ws_chunk(const uint8_t* data, const size_t len);
     static constexpr size_t WS_CHUNK_SIZE_BYTES = 512;
     static constexpr uint32_t WS_CHUNK_INTERVAL_MS = 250;
     std::shared_ptr<message_t> _ws_chunk = nullptr;
     uint32_t _last_ws_chunk_sent = 0;
 
-    AsyncWebSocket* _ws = nullptr;
+    std::atomic<AsyncWebSocket*> _ws { nullptr };
+
+    // protects the serial port and the serial cursor
+    std::mutex _serialLock;
 
-    std::mutex _msgLock;
+    void serialWrite(const uint8_t* data, const size_t len);
 
-    void serialWrite(message_t const& m);
+    // writes all records of the serial cursor to the serial port, _serialLock must be held
+    void drainSerial();
 };
 
 extern MessageOutputClass MessageOutput;
@@ -5,6 +5,7 @@
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
 #include <TimeoutHelper.h>
+#include <vector>
 
 // mqtt discovery device classes
 enum DeviceClassType {
@@ -71,24 +72,39 @@ public:
 
 private:
     void loop();
-    static void publish(const String& subtopic, const String& payload);
-    static void publish(const String& subtopic, const JsonDocument& doc);
+
+    // Publishes the next part (DTU, inverter or one channel of an inverter) of
+    // the discovery, returns false if everything was published
+    bool publishNextStep();
+
+    void publishDtuConfig();
+    void publishInverterConfig(std::shared_ptr<InverterAbstract> inv);
+
+    // Publishes the fields of the n-th channel of the inverter, returns false if there is no such channel
+    bool publishChannelConfig(std::shared_ptr<InverterAbstract> inv, const uint8_t index);
+
+    // Publishes only if the payload differs from the last one published to the topic
+    void publish(const String& subtopic, const String& payload);
+    void publish(const String& subtopic, const JsonDocument& doc);
 
     static void addCommonMetadata(JsonDocument& doc, const String& unit_of_measure, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
 
     // Binary Sensor
-    static void publishBinarySensor(JsonDocument& doc, const String& root_device, const String& unique_id_prefix, const String& name, const String& state_topic, const String& payload_on, const String& payload_off, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
-    static void publishDtuBinarySensor(const String& name, const String& state_topic, const String& payload_on, const String& payload_off, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
-    static void publishInverterBinarySensor(std::shared_ptr<InverterAbstract> inv, const String& name, const String& state_topic, const String& payload_on, const String& payload_off, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
+    void publishBinarySensor(JsonDocument& doc, const String& root_device, const String& unique_id_prefix, const String& name, const String& state_topic, const String& payload_on, const String& payload_off, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
+    void publishDtuBinarySensor(const String& name, const String& state_topic, const String& payload_on, const String& payload_off, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
+    void publishInverterBinarySensor(std::shared_ptr<InverterAbstract> inv, const String& name, const String& state_topic, const String& payload_on, const String& payload_off, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
 
     // Sensor
-    static void publishSensor(JsonDocument& doc, const String& root_device, const String& unique_id_prefix, const String& name, const String& state_topic, const String& unit_of_measure, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
-    static void publishDtuSensor(const String& name, const String& state_topic, const String& unit_of_measure, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
-    static void publishInverterSensor(std::shared_ptr<InverterAbstract> inv, const String& name, const String& state_topic, const String& unit_of_measure, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
+    void publishSensor(JsonDocument& doc, const String& root_device, const String& unique_id_prefix, const String& name, const String& state_topic, const String& unit_of_measure, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
+    void publishDtuSensor(const String& name, const String& state_topic, const String& unit_of_measure, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
+    void publishInverterSensor(std::shared_ptr<InverterAbstract> inv, const String& name, const String& state_topic, const String& unit_of_measure, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
+
+    void publishInverterField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const byteAssign_fieldDeviceClass_t fieldType, const bool clear = false);
+    void publishInverterButton(std::shared_ptr<InverterAbstract> inv, const String& name, const String& state_topic, const String& payload, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
+    void publishInverterNumber(std::shared_ptr<InverterAbstract> inv, const String& name, const String& state_topic, const String& command_topic, const int16_t min, const int16_t max, float step, const String& unit_of_measure, const String& icon, const StateClassType state_class, const CategoryType category);
 
-    static void publishInverterField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const byteAssign_fieldDeviceClass_t fieldType, const bool clear = false);
-    static void publishInverterButton(std::shared_ptr<InverterAbstract> inv, const String& name, const String& state_topic, const String& payload, const String& icon, const DeviceClassType device_class, const StateClassType state_class, const CategoryType category);
-    static void publishInverterNumber(std::shared_ptr<InverterAbstract> inv, const String& name, const String& state_topic, const String& command_topic, const int16_t min, const int16_t max, float step, const String& unit_of_measure, const String& icon, const StateClassType state_class, const CategoryType category);
+    // Time in s after which Home Assistant marks the values of the inverter as unavailable
+    static uint32_t getExpireAfter(std::shared_ptr<InverterAbstract> inv);
 
     static void createInverterInfo(JsonDocument& doc, std::shared_ptr<InverterAbstract> inv);
     static void createDtuInfo(JsonDocument& doc);
@@ -103,6 +119,19 @@ private:
 
     bool _wasConnected = false;
     bool _updateForced = false;
+
+    // Position of the running discovery publish
+    struct PublishCursor_t {
+        bool active = false;
+        bool dtu = false;
+        uint8_t inverter = 0;
+        // 0 = entries of the inverter itself, n = fields of the n-th channel
+        uint8_t channel = 0;
+    };
+    PublishCursor_t _cursor;
+
+    // Hash of the topic and hash of the last payload published to it, sorted by the topic hash
+    std::vector<std::pair<uint32_t, uint32_t>> _publishedHashes;
 };
 
 extern MqttHandleHassClass MqttHandleHass;
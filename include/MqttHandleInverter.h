@@ -2,11 +2,21 @@
 #pragma once
 
 #include "Configuration.h"
+#include "MqttPublishBatch.h"
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
 #include <espMqttClient.h>
 #include <frozen/map.h>
 #include <frozen/string.h>
+#include <set>
+#include <vector>
+
+enum MqttPayloadMode_t {
+    PayloadTopics,
+    PayloadJson,
+    PayloadTopicsAndJson,
+    PayloadMode_Max,
+};
 
 class MqttHandleInverterClass {
 public:
@@ -14,17 +24,115 @@ public:
     void init(Scheduler& scheduler);
 
     static String getTopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+    static String getSubtopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+
+    // Topic and Home Assistant value template of a field within the JSON document of the inverter
+    static String getJsonTopic(std::shared_ptr<InverterAbstract> inv);
+    static String getValueTemplate(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+
+    static bool isJsonEnabled();
 
     void subscribeTopics();
     void unsubscribeTopics();
 
 private:
+    struct ChannelTopic_t {
+        ChannelNum_t channel;
+        const char* subtopic;
+    };
+
+    struct FieldTopic_t {
+        ChannelType_t type;
+        ChannelNum_t channel;
+        FieldId_t fieldId;
+        const char* subtopic;
+
+        // Last published value, only used if publish on change is enabled
+        float lastValue;
+        uint32_t lastPublish;
+        bool published;
+    };
+
+    // Topics besides the statistics fields, same order as _statusSubtopics
+    enum StatusTopic_t : uint8_t {
+        STATUS_NAME = 0,
+        STATUS_TX_REQUEST,
+        STATUS_TX_RE_REQUEST,
+        STATUS_RX_SUCCESS,
+        STATUS_RX_FAIL_NOTHING,
+        STATUS_RX_FAIL_PARTIAL,
+        STATUS_RX_FAIL_CORRUPT,
+        STATUS_RSSI,
+        STATUS_BOOTLOADER_VERSION,
+        STATUS_FW_BUILD_VERSION,
+        STATUS_FW_BUILD_DATETIME,
+        STATUS_HW_PART_NUMBER,
+        STATUS_HW_VERSION,
+        STATUS_LIMIT_RELATIVE,
+        STATUS_LIMIT_ABSOLUTE,
+        STATUS_REACHABLE,
+        STATUS_PRODUCING,
+        STATUS_LAST_UPDATE,
+        STATUS_CNT
+    };
+
+    // Last published payload of a status topic, only used if publish on change is enabled
+    struct StatusValue_t {
+        uint32_t hash;
+        uint32_t lastPublish;
+        bool published;
+    };
+
+    // Topics of all published values of an inverter, built once per serial and prefix
+    struct InverterTopics_t {
+        uint64_t serial = 0;
+        String base;
+        std::vector<ChannelTopic_t> channelNames;
+        std::vector<FieldTopic_t> fields;
+
+        uint32_t lastPublishNames = 0;
+        bool namesPublished = false;
+
+        StatusValue_t status[STATUS_CNT] = {};
+    };
+
     void loop();
-    void publishField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+
+    // Adds all fields of the inverter to the batch
+    void publishFields(std::shared_ptr<InverterAbstract> inv, InverterTopics_t& topics);
+
+    // Adds only the fields which left their deadband or exceeded the max age
+    void publishChangedFields(std::shared_ptr<InverterAbstract> inv, InverterTopics_t& topics);
+
+    // Publishes all fields and channel names of the inverter as one JSON document
+    void publishJson(std::shared_ptr<InverterAbstract> inv, const InverterTopics_t& topics);
+
+    // Adds a status topic to the batch. If publish on change is enabled it is skipped
+    // as long as the hash is the same as the published one and the max age is not exceeded.
+    void addStatus(InverterTopics_t& topics, const StatusTopic_t id, const char* payload, const uint32_t hash);
+    void addStatus(InverterTopics_t& topics, const StatusTopic_t id, const char* payload);
+    void addStatusf(InverterTopics_t& topics, const StatusTopic_t id, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+    static bool isOutsideDeadband(const float value, const float lastValue, const uint8_t digits, const float relDeadband, const float absDeadband);
+
+    // Forces the next publish of all values if publish on change is enabled
+    void resetPublishedValues();
+
+    InverterTopics_t& getTopics(const uint8_t pos, std::shared_ptr<InverterAbstract> inv);
+
+    // Returns a copy of the sub topic which stays valid (sub topics are shared by all inverters)
+    const char* intern(const String& subtopic);
 
     Task _loopTask;
 
     uint32_t _lastPublishStats[INV_MAX_COUNT] = { 0 };
+    bool _wasConnected = false;
+
+    String _topicPrefix;
+    InverterTopics_t _topics[INV_MAX_COUNT];
+    std::set<String> _subtopics;
+
+    MqttPublishBatch _batch;
 
     FieldId_t _publishFields[14] = {
         FLD_UDC,
@@ -43,6 +151,8 @@ private:
         FLD_Q
     };
 
+    static const char* const _statusSubtopics[STATUS_CNT];
+
     enum class Topic : unsigned {
         LimitPersistentRelative,
         LimitPersistentAbsolute,
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <WString.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Maximum number of messages collected before they are sent
+#define MQTT_BATCH_MAX_MESSAGES 64
+
+// Size of the buffer holding the payloads of all collected messages
+#define MQTT_BATCH_PAYLOAD_SIZE 1536
+
+// Collects messages which are sent to the broker with a single lock of the
+// MQTT client. The topic of each message consists of a base (e.g. prefix
+// and serial) and a sub topic. Both are referenced, not copied, and have to
+// be valid until publish() was called. Payloads are copied into a fixed
+// buffer, therefore collecting messages does not allocate memory.
+class MqttPublishBatch {
+public:
+    // Receives the collected messages when the batch is sent
+    using PublishCallback = std::function<void(const MqttPublishBatch& batch)>;
+
+    explicit MqttPublishBatch(PublishCallback callback);
+
+    void add(const char* base, const char* subtopic, const char* payload);
+    void addf(const char* base, const char* subtopic, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+    // Sends all collected messages and clears the batch
+    void publish();
+
+    size_t size() const;
+    const char* getBase(const size_t index) const;
+    const char* getSubtopic(const size_t index) const;
+    const char* getPayload(const size_t index) const;
+
+    // Writes base and sub topic of the message into the buffer, returns the length of the complete topic
+    size_t getTopic(const size_t index, char* buffer, const size_t size) const;
+
+private:
+    // Sends the batch if a message with the given payload length does not fit anymore
+    void reserve(const size_t len);
+
+    PublishCallback _callback;
+
+    struct Message_t {
+        const char* base;
+        const char* subtopic;
+        uint16_t payload;
+    };
+
+    std::array<Message_t, MQTT_BATCH_MAX_MESSAGES> _messages;
+    size_t _count = 0;
+
+    char _payload[MQTT_BATCH_PAYLOAD_SIZE];
+    size_t _payloadLen = 0;
+};
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "MqttPublishBatch.h"
 #include "NetworkSettings.h"
 #include <MqttSubscribeParser.h>
 #include <Ticker.h>
@@ -15,8 +16,16 @@ public:
     void init();
     void performReconnect();
     bool getConnected();
+
+    // Returns true if the broker still had the session of the client at the last connect
+    bool getSessionPresent() const;
     void publish(const String& subtopic, const String& payload);
-    void publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos = 0);
+
+    // Returns false if the client did not accept the message (no packet id)
+    bool publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos = 0);
+
+    // Publishes all messages of the batch with a single lock of the client
+    void publishBatch(const MqttPublishBatch& batch);
 
     void subscribe(const String& topic, const uint8_t qos, const OnMessageCallback& cb);
     void unsubscribe(const String& topic);
@@ -41,6 +50,7 @@ private:
     std::map<String, std::vector<uint8_t>> _fragments;
     MqttSubscribeParser _mqttSubscribeParser;
     std::mutex _clientLock;
+    bool _sessionPresent = false;
 };
 
 extern MqttSettingsClass MqttSettings;
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Configuration.h"
+#include <Hoymiles.h>
+
+// Size of the buffer which holds one metric line (including the HELP and TYPE
+// header of the family in front of the first line)
+#define PROMETHEUS_LINE_SIZE 384
+
+// Size of the precomputed serial, unit and name labels of one inverter
+#define PROMETHEUS_LABEL_SIZE 96
+
+// Renders the metrics of the DTU and all inverters in the Prometheus text format.
+// The metrics of the system are provided by the derived class.
+class PrometheusExporter {
+public:
+    virtual ~PrometheusExporter() = default;
+
+    // Position of the exporter within the metric families. The whole scrape
+    // is generated line by line from this state, therefore no output buffer
+    // is required independent of the number of inverters.
+    struct Scrape_t {
+        uint8_t family = 0;
+        uint8_t inverter = 0;
+        uint8_t type = 0;
+        uint8_t channel = 0;
+        uint8_t field = 0;
+        bool header = false;
+
+        char line[PROMETHEUS_LINE_SIZE];
+        size_t lineLen = 0;
+        size_t linePos = 0;
+    };
+
+    // Rebuilds the label prefixes of all inverters whose serial or name changed
+    void updateLabels();
+
+    // Copies the next part of the scrape into the buffer, returns 0 at the end
+    size_t fillChunk(Scrape_t& scrape, uint8_t* buffer, const size_t maxLen);
+
+protected:
+    enum MetricType_t {
+        NONE = 0,
+        GAUGE,
+        COUNTER,
+        HISTOGRAM,
+    };
+
+    enum MetricSource_t {
+        // One line without labels of the inverters
+        SYSTEM = 0,
+        // One line per inverter
+        INVERTER,
+        // Buckets and count of the radio histograms of every inverter
+        RADIO,
+        // One line per DC channel of every inverter
+        PANEL,
+        // One line per channel of every inverter which provides a matching field
+        FIELD,
+    };
+
+    // Order of the families in the output
+    enum MetricFamily_t {
+        FAMILY_BUILD = 0,
+        FAMILY_PLATFORM,
+        FAMILY_UPTIME,
+        FAMILY_HEAP_SIZE,
+        FAMILY_FREE_HEAP_SIZE,
+        FAMILY_BIGGEST_HEAP_BLOCK,
+        FAMILY_HEAP_MIN_FREE,
+        FAMILY_WIFI_RSSI,
+        FAMILY_WIFI_STATION,
+        FAMILY_LAST_UPDATE,
+        FAMILY_LIMIT_RELATIVE,
+        FAMILY_LIMIT_ABSOLUTE,
+        FAMILY_RADIO_RTT,
+        FAMILY_RADIO_RETRANSMITS,
+        FAMILY_RADIO_RSSI,
+        FAMILY_PANEL_INFO,
+        FAMILY_PANEL_MAX_POWER,
+        FAMILY_PANEL_YIELD_TOTAL_OFFSET,
+        // Families of the published statistics fields
+        FAMILY_FIELDS,
+    };
+
+    struct metric_family_t {
+        const char* name;
+        const char* help;
+        MetricType_t type;
+        MetricSource_t source;
+    };
+
+    static const metric_family_t _families[];
+
+    // Renders the line of a family with the source SYSTEM, returns -1 if there is none
+    virtual int printSystemMetric(char* line, const size_t size, const uint8_t family) = 0;
+
+private:
+    // Renders the next metric line into scrape.line, returns false at the end
+    bool nextLine(Scrape_t& scrape);
+
+    // Renders the line at the current channel and field position of the inverter, returns -1 if there is none left
+    int printNextInverterLine(Scrape_t& scrape, char* line, const size_t size, InverterAbstract* inv);
+
+    int printInverterMetric(char* line, const size_t size, const uint8_t family, const uint8_t idx, InverterAbstract* inv);
+    int printHistogramMetric(char* line, const size_t size, const uint8_t family, const uint8_t idx, InverterAbstract* inv, const CommandType type, const uint8_t index);
+    int printPanelMetric(char* line, const size_t size, const uint8_t family, const uint8_t idx, InverterAbstract* inv, const ChannelNum_t channel);
+    int printFieldMetric(char* line, const size_t size, const uint8_t family, const uint8_t idx, InverterAbstract* inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+
+    static const char* getMetricName(const ChannelType_t type, const FieldId_t fieldId);
+    static bool hasChannel(StatisticsParser* statistics, const ChannelType_t type, const ChannelNum_t channel);
+
+    const char* _metricTypes[4] = { 0, "gauge", "counter", "histogram" };
+
+    static const uint8_t _familyCount;
+
+    // Fields published for every channel, the metric type is part of the family
+    const FieldId_t _publishFields[14] = {
+        FLD_PAC, FLD_UAC, FLD_IAC, FLD_PDC, FLD_UDC, FLD_IDC, FLD_YD,
+        FLD_YT, FLD_F, FLD_T, FLD_PF, FLD_Q, FLD_EFF, FLD_IRR,
+    };
+
+    // serial="...",unit="...",name="..." of every inverter position
+    char _labels[INV_MAX_COUNT][PROMETHEUS_LABEL_SIZE] = {};
+    uint64_t _labelSerial[INV_MAX_COUNT] = {};
+    char _labelName[INV_MAX_COUNT][MAX_NAME_LENGTH] = {};
+};
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Configuration.h"
+#include <Hoymiles.h>
+#include <Print.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Rendered data also contains values which do not belong to the statistics
+// (data age, radio statistics, limit). Therefore buffers are rendered again
+// after this time (ms) even if the statistics did not change.
+#define RENDER_CACHE_MAX_AGE 1000
+
+enum class RenderFormat_t {
+    // Complete inverter data including totals and hints (websocket and /api/livedata/status?inv=)
+    LiveJson,
+    // Common inverter data used in the inverter list of /api/livedata/status
+    ListJson,
+};
+#define RENDER_FORMAT_CNT 2
+
+// Same type as AsyncWebSocketSharedBuffer, can be shared by any number of clients
+typedef std::shared_ptr<std::vector<uint8_t>> RenderBuffer_t;
+
+class RenderBufferPrint : public Print {
+public:
+    explicit RenderBufferPrint(std::vector<uint8_t>& buffer);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+private:
+    std::vector<uint8_t>& _buffer;
+};
+
+class RenderCacheClass {
+public:
+    // Writes the complete output to the given Print, returns false on failure
+    using RenderFunction = std::function<bool(Print& out)>;
+
+    // Returns the buffer of the inverter at the given position. It is only
+    // rendered again if the statistics generation changed or the buffer is
+    // older than RENDER_CACHE_MAX_AGE. Returns nullptr if rendering failed.
+    RenderBuffer_t get(const uint8_t pos, std::shared_ptr<InverterAbstract> inv, const RenderFormat_t format, const RenderFunction& render);
+
+    uint32_t getHits() const;
+    uint32_t getMisses() const;
+
+private:
+    struct Entry_t {
+        uint64_t serial = 0;
+        uint32_t generation = 0;
+        uint32_t renderTime = 0;
+        RenderBuffer_t buffer;
+    };
+
+    Entry_t _entries[INV_MAX_COUNT][RENDER_FORMAT_CNT];
+
+    std::mutex _mutex;
+
+    std::atomic<uint32_t> _hits = { 0 };
+    std::atomic<uint32_t> _misses = { 0 };
+};
+
+extern RenderCacheClass RenderCache;
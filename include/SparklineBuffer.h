@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+// Number of base buckets which are kept. Every level of the pyramid covers
+// the same time span with half the number of buckets of the level below.
+#define SPARKLINE_CAPACITY 128
+#define SPARKLINE_LEVELS 8
+
+struct SparklineBucket_t {
+    float min;
+    float max;
+    float avg;
+};
+
+// Ring buffer of min/max/avg buckets with a pyramid of coarser levels on top.
+// Appending is O(1) amortized and reading the series at any width only
+// touches at most two buckets per level and point, independent of how many
+// base buckets fall into a point. Peaks are kept as the max of the buckets.
+class SparklineBuffer {
+public:
+    void clear();
+
+    void append(const SparklineBucket_t& bucket);
+
+    // Number of base buckets which are available, at most SPARKLINE_CAPACITY
+    uint16_t size();
+
+    // Resamples the whole capacity into points buckets, the oldest bucket
+    // first. Returns the number of points which contain data, which is less
+    // than points as long as the buffer is not full.
+    uint16_t resample(SparklineBucket_t* out, const uint16_t points);
+
+private:
+    SparklineBucket_t& bucket(const uint8_t level, const uint32_t index);
+
+    std::mutex _mutex;
+
+    // All levels in one array, level k starts at 2 * CAPACITY - 2 * (CAPACITY >> k)
+    SparklineBucket_t _buckets[2 * SPARKLINE_CAPACITY - 1];
+
+    // Number of base buckets appended since the last clear
+    uint32_t _count = 0;
+};
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <ArduinoJson.h>
+#include <Histogram.h>
 #include <LittleFS.h>
 #include <cstdint>
 
@@ -14,4 +15,23 @@ public:
     static void removeAllFiles();
     static String generateMd5FromFile(String file);
     static void skipBom(File& f);
+
+    // 32 bit FNV-1a hash, pass the previous result as hash to continue it
+    static uint32_t fnv1a(const void* data, const size_t len, uint32_t hash = 2166136261U);
+
+    // Adds the upper limit of each bucket (the last bucket has no limit), the counts, the total and the sum
+    template <typename T, size_t N>
+    static void addHistogram(JsonObject obj, const Histogram<T, N>& histogram)
+    {
+        JsonArray limits = obj["limits"].to<JsonArray>();
+        JsonArray counts = obj["counts"].to<JsonArray>();
+        for (size_t i = 0; i < histogram.getBucketCount(); i++) {
+            if (i < histogram.getBucketCount() - 1) {
+                limits.add(histogram.getLimit(i));
+            }
+            counts.add(histogram.getCount(i));
+        }
+        obj["total"] = histogram.getTotal();
+        obj["sum"] = histogram.getSum();
+    }
 };
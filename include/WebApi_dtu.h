@@ -15,4 +15,7 @@ private:
 
     Task _applyDataTask;
     void applyDataTaskCb();
+
+    // Republish the Home Assistant discovery after the new settings were applied
+    bool _hassUpdate = false;
 };
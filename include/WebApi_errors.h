@@ -17,6 +17,8 @@ enum WebApiError {
     DtuInvalidPowerLevel,
     DtuInvalidCmtFrequency,
     DtuInvalidCmtCountry,
+    DtuInvalidPollRange,
+    DtuInvalidHistoryInterval,
 
     FileBase = 3000,
     FileNotDeleted,
@@ -63,6 +65,10 @@ enum WebApiError {
     MqttHassTopicCharacter,
     MqttLwtQos,
     MqttClientIdLength,
+    MqttOnChangeMaxAge,
+    MqttOnChangeDeadband,
+    MqttOnChangeDeadbandAbsolute,
+    MqttPayloadMode,
 
     NetworkBase = 8000,
     NetworkIpInvalid,
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "History.h"
+#include <ESPAsyncWebServer.h>
+#include <LittleFS.h>
+#include <TaskSchedulerDeclarations.h>
+
+// Size of the buffer which holds one row of the response
+#define HISTORY_LINE_SIZE 160
+
+class WebApiHistoryClass {
+public:
+    void init(AsyncWebServer& server, Scheduler& scheduler);
+
+private:
+    enum Resolution_t {
+        RESOLUTION_RAW = 0,
+        RESOLUTION_HOUR,
+        RESOLUTION_DAY,
+    };
+
+    enum Stage_t {
+        STAGE_HEADER = 0,
+        STAGE_FILES,
+        STAGE_PENDING,
+        STAGE_FOOTER,
+        STAGE_DONE,
+    };
+
+    // Position of the response within the stored history. The data is read
+    // from flash block by block while the response is sent, therefore the
+    // memory usage does not depend on the requested time range.
+    struct Query_t {
+        uint64_t serial = 0;
+        uint32_t from = 0;
+        uint32_t to = 0;
+        Resolution_t resolution = RESOLUTION_RAW;
+
+        Stage_t stage = STAGE_HEADER;
+        uint32_t day = 0;
+        File file;
+
+        // samples block which is currently decoded
+        HistoryBlockHeader_t header = {};
+        uint8_t data[HISTORY_BLOCK_SIZE];
+        size_t dataPos = 0;
+        bool inBlock = false;
+        HistorySample_t sample = {};
+
+        bool firstRow = true;
+        char line[HISTORY_LINE_SIZE];
+        size_t lineLen = 0;
+        size_t linePos = 0;
+    };
+
+    void onHistoryGet(AsyncWebServerRequest* request);
+
+    // Copies the next part of the response into the buffer, returns 0 at the end
+    size_t fillChunk(Query_t& query, uint8_t* buffer, const size_t maxLen);
+
+    // Renders the next row into query.line, returns false at the end
+    bool nextLine(Query_t& query);
+
+    // Reads the next block of the segments, returns false if there is none left
+    bool readSegmentBlock(Query_t& query);
+
+    int printSample(Query_t& query);
+    int printHourly(Query_t& query, const uint32_t start, const HistoryHourly_t& hourly);
+    int printDaily(Query_t& query, const HistoryDaily_t& daily);
+};
@@ -2,10 +2,13 @@
 #pragma once
 
 #include "Configuration.h"
+#include "LiveDataJson.h"
+#include "RenderCache.h"
 #include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
+#include <vector>
 
 class WebApiWsLiveClass {
 public:
@@ -14,17 +17,25 @@ public:
     void reload();
 
 private:
-    static void generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
-    static void generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
     static void generateCommonJsonResponse(JsonVariant& root);
 
-    static void addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic = "");
+    static bool renderLiveJson(Print& out, std::shared_ptr<InverterAbstract> inv);
+    static bool renderListJson(Print& out, std::shared_ptr<InverterAbstract> inv);
+    static void sendRenderBuffer(AsyncWebServerRequest* request, RenderBuffer_t buffer);
+
     static void addTotalField(JsonObject& root, const String& name, const float value, const String& unit, const uint8_t digits);
 
+    void sendSnapshot(AsyncWebSocketClient* client);
+
     void onLivedataStatus(AsyncWebServerRequest* request);
     void onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
 
     AsyncWebSocket _ws;
+
+    // Opt-in protocol which sends a snapshot on connect and afterwards only changed fields
+    AsyncWebSocket _wsDelta;
+    // Shared by all clients, reset when a client connects
+    WsLiveDeltaState_t _deltaState[INV_MAX_COUNT];
     AsyncAuthenticationMiddleware _simpleDigestAuth;
 
     uint32_t _lastPublishStats[INV_MAX_COUNT] = { 0 };
@@ -84,14 +84,25 @@
 #define MQTT_LWT_QOS 2U
 #define MQTT_PUBLISH_INTERVAL 5U
 #define MQTT_CLEAN_SESSION true
+#define MQTT_PAYLOAD_MODE 0U
+#define MQTT_ONCHANGE_ENABLED false
+#define MQTT_ONCHANGE_MAX_AGE 300U
+#define MQTT_ONCHANGE_DEADBAND 1.0
+#define MQTT_ONCHANGE_DEADBAND_ABSOLUTE 0.0
 
 #define DTU_SERIAL 0x99978563412U
 #define DTU_POLL_INTERVAL 5U
+#define DTU_ADAPTIVE_POLL false
+#define DTU_POLL_INTERVAL_MIN 5U
+#define DTU_POLL_INTERVAL_MAX 60U
 #define DTU_NRF_PA_LEVEL 0U
 #define DTU_CMT_PA_LEVEL 0
 #define DTU_CMT_FREQUENCY 865000000U
 #define DTU_CMT_COUNTRY_MODE 0U
 
+#define HISTORY_ENABLED false
+#define HISTORY_INTERVAL 300U
+
 #define MQTT_HASS_ENABLED false
 #define MQTT_HASS_EXPIRE true
 #define MQTT_HASS_RETAIN true
@@ -1,4 +1,7 @@
 #include "cmt_spi3.h"
+
+#ifdef ESP_PLATFORM
+
 #include <Arduino.h>
 #include <SpiManager.h>
 #include <driver/spi_master.h>
@@ -154,3 +157,33 @@ void cmt_spi3_read_fifo(uint8_t* buf, const uint16_t len)
     spi_device_release_bus(spi);
     SPI_PARAM_UNLOCK();
 }
+
+#else
+
+// There is no SPI bus in the native test environment, the chip is never detected
+
+#include <cstring>
+
+void cmt_spi3_init(const int8_t, const int8_t, const int8_t, const int8_t, const int32_t)
+{
+}
+
+void cmt_spi3_write(const uint8_t, const uint8_t)
+{
+}
+
+uint8_t cmt_spi3_read(const uint8_t)
+{
+    return 0xff;
+}
+
+void cmt_spi3_write_fifo(const uint8_t*, const uint16_t)
+{
+}
+
+void cmt_spi3_read_fifo(uint8_t* buf, const uint16_t len)
+{
+    memset(buf, 0xff, len);
+}
+
+#endif
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Histogram with fixed buckets. Bucket i counts all values <= limits[i],
+// the last bucket counts everything above the last limit. The limits are
+// referenced, not copied, and therefore need static storage duration.
+// Only one task may add values, any task may read them.
+template <typename T, size_t N>
+class Histogram {
+public:
+    explicit Histogram(const std::array<T, N - 1>& limits)
+        : _limits(limits)
+    {
+    }
+
+    void add(const T value)
+    {
+        size_t i = 0;
+        while (i < N - 1 && value > _limits[i]) {
+            i++;
+        }
+        _counts[i]++;
+        _total++;
+        _sum += value;
+    }
+
+    void reset()
+    {
+        _counts.fill(0);
+        _total = 0;
+        _sum = 0;
+    }
+
+    static constexpr size_t getBucketCount()
+    {
+        return N;
+    }
+
+    // Upper limit of the bucket (inclusive), not available for the last bucket
+    T getLimit(const size_t bucket) const
+    {
+        return _limits[bucket];
+    }
+
+    uint32_t getCount(const size_t bucket) const
+    {
+        return _counts[bucket];
+    }
+
+    uint32_t getTotal() const
+    {
+        return _total;
+    }
+
+    // Sum of all added values
+    int64_t getSum() const
+    {
+        return _sum;
+    }
+
+private:
+    const std::array<T, N - 1>& _limits;
+    std::array<uint32_t, N> _counts = {};
+    uint32_t _total = 0;
+    int64_t _sum = 0;
+};
@@ -29,6 +29,9 @@ void HoymilesClass::init()
     _pollInterval = 0;
     _radioNrf.reset(new HoymilesRadio_NRF());
     _radioCmt.reset(new HoymilesRadio_CMT());
+#ifdef HOYMILES_RADIO_SIM
+    _radioSim.reset(new HoymilesRadio_Sim());
+#endif
 }
 
 void HoymilesClass::initNRF(SPIClass* initialisedSpiBus, const uint8_t pinCE, const uint8_t pinIRQ)
@@ -41,142 +44,163 @@ void HoymilesClass::initCMT(const int8_t pin_sdio, const int8_t pin_clk, const i
     _radioCmt->init(pin_sdio, pin_clk, pin_cs, pin_fcs, pin_gpio2, pin_gpio3);
 }
 
+#ifdef HOYMILES_RADIO_SIM
+void HoymilesClass::initSim()
+{
+    _radioSim->init();
+}
+#endif
+
 void HoymilesClass::loop()
 {
     std::lock_guard<std::mutex> lock(_mutex);
     _radioNrf->loop();
     _radioCmt->loop();
-
-    if (getNumInverters() == 0 || millis() - _lastPoll <= (_pollInterval * 1000)) {
-        return;
+#ifdef HOYMILES_RADIO_SIM
+    _radioSim->loop();
+#endif
+
+    if (getNumInverters() > 0) {
+        // Every radio has its own scheduler, inverters on different radios are polled in parallel
+        for (HoymilesRadio* radio : getRadios()) {
+            std::shared_ptr<InverterAbstract> iv = radio->Scheduler()->getNextInverter(_inverters, _pollInterval * 1000);
+            if (iv != nullptr && pollInverter(iv.get())) {
+                radio->Scheduler()->setPolled();
+            }
+        }
     }
 
-    static uint8_t inverterPos = 0;
+    // Perform housekeeping of all inverters on day change
+    const int8_t currentWeekDay = Utils::getWeekDay();
+    static int8_t lastWeekDay = -1;
+    if (lastWeekDay == -1) {
+        lastWeekDay = currentWeekDay;
+    } else {
+        if (currentWeekDay != lastWeekDay) {
+
+            for (auto& inv : _inverters) {
+                inv->performDailyTask();
+            }
 
-    std::shared_ptr<InverterAbstract> iv = getInverterByPos(inverterPos);
-    if ((iv == nullptr) || ((iv != nullptr) && (!iv->getRadio()->isInitialized()))) {
-        if (++inverterPos >= getNumInverters()) {
-            inverterPos = 0;
+            lastWeekDay = currentWeekDay;
         }
     }
+}
+
+bool HoymilesClass::pollInverter(InverterAbstract* iv)
+{
+    if (iv->getZeroValuesIfUnreachable() && !iv->isReachable()) {
+        iv->Statistics()->zeroRuntimeData();
+    }
 
-    if (iv != nullptr && iv->getRadio()->isInitialized()) {
+    if (iv->getEnablePolling() || iv->getEnableCommands()) {
+        ESP_LOGI(TAG, "Fetch inverter: %s", iv->serialString().c_str());
 
-        if (iv->getZeroValuesIfUnreachable() && !iv->isReachable()) {
-            iv->Statistics()->zeroRuntimeData();
+        if (!iv->isReachable()) {
+            iv->sendChangeChannelRequest();
         }
 
-        if (iv->getEnablePolling() || iv->getEnableCommands()) {
-            ESP_LOGI(TAG, "Fetch inverter: %s", iv->serialString().c_str());
+        if (Utils::getTimeAvailable()) {
+            // Fetch statistics
+            iv->sendStatsRequest();
 
-            if (!iv->isReachable()) {
-                iv->sendChangeChannelRequest();
-            }
+            // Fetch event log
+            const bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
+            iv->sendAlarmLogRequest(force);
 
-            if (Utils::getTimeAvailable()) {
-                // Fetch statistics
-                iv->sendStatsRequest();
+            // Fetch limit
+            if (((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
+                    && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
+                ESP_LOGI(TAG, "Request SystemConfigPara");
+                iv->sendSystemConfigParaRequest();
+            }
 
-                // Fetch event log
-                const bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
-                iv->sendAlarmLogRequest(force);
+            // Fetch grid profile
+            if (iv->Statistics()->getLastUpdate() > 0 && (iv->GridProfile()->getLastUpdate() == 0 || !iv->GridProfile()->containsValidData())) {
+                iv->sendGridOnProFileParaRequest();
+            }
 
-                // Fetch limit
-                if (((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
-                        && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
-                    ESP_LOGI(TAG, "Request SystemConfigPara");
-                    iv->sendSystemConfigParaRequest();
-                }
+            // Fetch dev info (but first fetch stats)
+            if (iv->Statistics()->getLastUpdate() > 0) {
+                const bool invalidDevInfo = !iv->DevInfo()->containsValidData()
+                    && iv->DevInfo()->getLastUpdateAll() > 0
+                    && iv->DevInfo()->getLastUpdateSimple() > 0;
 
-                // Fetch grid profile
-                if (iv->Statistics()->getLastUpdate() > 0 && (iv->GridProfile()->getLastUpdate() == 0 || !iv->GridProfile()->containsValidData())) {
-                    iv->sendGridOnProFileParaRequest();
+                if (invalidDevInfo) {
+                    ESP_LOGW(TAG, "DevInfo: No Valid Data");
                 }
 
-                // Fetch dev info (but first fetch stats)
-                if (iv->Statistics()->getLastUpdate() > 0) {
-                    const bool invalidDevInfo = !iv->DevInfo()->containsValidData()
-                        && iv->DevInfo()->getLastUpdateAll() > 0
-                        && iv->DevInfo()->getLastUpdateSimple() > 0;
-
-                    if (invalidDevInfo) {
-                        ESP_LOGW(TAG, "DevInfo: No Valid Data");
-                    }
-
-                    if ((iv->DevInfo()->getLastUpdateAll() == 0)
-                        || (iv->DevInfo()->getLastUpdateSimple() == 0)
-                        || invalidDevInfo) {
-                        ESP_LOGI(TAG, "Request device info");
-                        iv->sendDevInfoRequest();
-                    }
+                if ((iv->DevInfo()->getLastUpdateAll() == 0)
+                    || (iv->DevInfo()->getLastUpdateSimple() == 0)
+                    || invalidDevInfo) {
+                    ESP_LOGI(TAG, "Request device info");
+                    iv->sendDevInfoRequest();
                 }
             }
-
-            // Set limit if required
-            if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
-                ESP_LOGI(TAG, "Resend ActivePowerControl");
-                iv->resendActivePowerControlRequest();
-            }
-
-            // Set power status if required
-            if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
-                ESP_LOGI(TAG, "Resend PowerCommand");
-                iv->resendPowerControlRequest();
-            }
-
-            ESP_LOGI(TAG, "Queue size - NRF: %" PRIu32 " CMT: %" PRIu32 "", _radioNrf->getQueueSize(), _radioCmt->getQueueSize());
-            _lastPoll = millis();
         }
 
-        if (++inverterPos >= getNumInverters()) {
-            inverterPos = 0;
+        // Set limit if required
+        if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
+            ESP_LOGI(TAG, "Resend ActivePowerControl");
+            iv->resendActivePowerControlRequest();
         }
-    }
-
-    // Perform housekeeping of all inverters on day change
-    const int8_t currentWeekDay = Utils::getWeekDay();
-    static int8_t lastWeekDay = -1;
-    if (lastWeekDay == -1) {
-        lastWeekDay = currentWeekDay;
-    } else {
-        if (currentWeekDay != lastWeekDay) {
-
-            for (auto& inv : _inverters) {
-                inv->performDailyTask();
-            }
 
-            lastWeekDay = currentWeekDay;
+        // Set power status if required
+        if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
+            ESP_LOGI(TAG, "Resend PowerCommand");
+            iv->resendPowerControlRequest();
         }
+
+#ifdef HOYMILES_RADIO_SIM
+        ESP_LOGI(TAG, "Queue size - NRF: %" PRIu32 " CMT: %" PRIu32 " SIM: %" PRIu32 "", _radioNrf->getQueueSize(), _radioCmt->getQueueSize(), _radioSim->getQueueSize());
+#else
+        ESP_LOGI(TAG, "Queue size - NRF: %" PRIu32 " CMT: %" PRIu32 "", _radioNrf->getQueueSize(), _radioCmt->getQueueSize());
+#endif
+        return true;
     }
+
+    return false;
 }
 
 std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, const uint64_t serial)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
     std::shared_ptr<InverterAbstract> i = nullptr;
+
+#ifdef HOYMILES_RADIO_SIM
+    // All inverters are served by the simulated radio if it was initialized
+    HoymilesRadio* radioSim = _radioSim->isInitialized() ? _radioSim.get() : nullptr;
+    HoymilesRadio* radioNrf = radioSim ? radioSim : _radioNrf.get();
+    HoymilesRadio* radioCmt = radioSim ? radioSim : _radioCmt.get();
+#else
+    HoymilesRadio* radioNrf = _radioNrf.get();
+    HoymilesRadio* radioCmt = _radioCmt.get();
+#endif
+
     if (HMT_4CH::isValidSerial(serial)) {
-        i = std::make_shared<HMT_4CH>(_radioCmt.get(), serial);
+        i = std::make_shared<HMT_4CH>(radioCmt, serial);
     } else if (HMT_6CH::isValidSerial(serial)) {
-        i = std::make_shared<HMT_6CH>(_radioCmt.get(), serial);
+        i = std::make_shared<HMT_6CH>(radioCmt, serial);
     } else if (HMS_4CH::isValidSerial(serial)) {
-        i = std::make_shared<HMS_4CH>(_radioCmt.get(), serial);
+        i = std::make_shared<HMS_4CH>(radioCmt, serial);
     } else if (HMS_2CH::isValidSerial(serial)) {
-        i = std::make_shared<HMS_2CH>(_radioCmt.get(), serial);
+        i = std::make_shared<HMS_2CH>(radioCmt, serial);
     } else if (HMS_1CH::isValidSerial(serial)) {
-        i = std::make_shared<HMS_1CH>(_radioCmt.get(), serial);
+        i = std::make_shared<HMS_1CH>(radioCmt, serial);
     } else if (HMS_1CHv2::isValidSerial(serial)) {
-        i = std::make_shared<HMS_1CHv2>(_radioCmt.get(), serial);
+        i = std::make_shared<HMS_1CHv2>(radioCmt, serial);
     } else if (HM_4CH::isValidSerial(serial)) {
-        i = std::make_shared<HM_4CH>(_radioNrf.get(), serial);
+        i = std::make_shared<HM_4CH>(radioNrf, serial);
     } else if (HM_2CH::isValidSerial(serial)) {
-        i = std::make_shared<HM_2CH>(_radioNrf.get(), serial);
+        i = std::make_shared<HM_2CH>(radioNrf, serial);
     } else if (HM_1CH::isValidSerial(serial)) {
-        i = std::make_shared<HM_1CH>(_radioNrf.get(), serial);
+        i = std::make_shared<HM_1CH>(radioNrf, serial);
     } else if (HERF_1CH::isValidSerial(serial)) {
-        i = std::make_shared<HERF_1CH>(_radioNrf.get(), serial);
+        i = std::make_shared<HERF_1CH>(radioNrf, serial);
     } else if (HERF_2CH::isValidSerial(serial)) {
-        i = std::make_shared<HERF_2CH>(_radioNrf.get(), serial);
+        i = std::make_shared<HERF_2CH>(radioNrf, serial);
     } else if (HERF_4CH::isValidSerial(serial)) {
-        i = std::make_shared<HERF_4CH>(_radioNrf.get(), serial);
+        i = std::make_shared<HERF_4CH>(radioNrf, serial);
     }
 
     if (i) {
@@ -235,6 +259,7 @@ void HoymilesClass::removeInverterBySerial(const uint64_t serial)
         if (_inverters[i]->serial() == serial) {
             std::lock_guard<std::mutex> lock(_mutex);
             _inverters[i]->getRadio()->removeCommands(_inverters[i].get());
+            _inverters[i]->getRadio()->Scheduler()->removeInverter(serial);
             _inverters.erase(_inverters.begin() + i);
             return;
         }
@@ -256,10 +281,69 @@ HoymilesRadio_CMT* HoymilesClass::getRadioCmt()
     return _radioCmt.get();
 }
 
+#ifdef HOYMILES_RADIO_SIM
+HoymilesRadio_Sim* HoymilesClass::getRadioSim()
+{
+    return _radioSim.get();
+}
+
+std::array<HoymilesRadio*, HOY_RADIO_COUNT> HoymilesClass::getRadios() const
+{
+    return { _radioNrf.get(), _radioCmt.get(), _radioSim.get() };
+}
+
+bool HoymilesClass::isAllRadioIdle() const
+{
+    return _radioNrf.get()->isIdle() && _radioCmt.get()->isIdle() && _radioSim.get()->isIdle();
+}
+#else
+std::array<HoymilesRadio*, HOY_RADIO_COUNT> HoymilesClass::getRadios() const
+{
+    return { _radioNrf.get(), _radioCmt.get() };
+}
+
 bool HoymilesClass::isAllRadioIdle() const
 {
     return _radioNrf.get()->isIdle() && _radioCmt.get()->isIdle();
 }
+#endif
+
+void HoymilesClass::setWakeupTask(const TaskHandle_t task)
+{
+    _wakeupTask = task;
+}
+
+void HoymilesClass::wakeup()
+{
+    if (_wakeupTask != nullptr) {
+        xTaskNotifyGive(_wakeupTask);
+    }
+}
+
+void ARDUINO_ISR_ATTR HoymilesClass::wakeupFromIsr()
+{
+    if (_wakeupTask != nullptr) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(_wakeupTask, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+}
+
+uint32_t HoymilesClass::getMaxSleep() const
+{
+    uint32_t sleep = HOY_MAX_SLEEP;
+    for (HoymilesRadio* radio : getRadios()) {
+        sleep = std::min(sleep, radio->getMaxSleep());
+    }
+
+    if (getNumInverters() > 0) {
+        for (HoymilesRadio* radio : getRadios()) {
+            sleep = std::min(sleep, radio->Scheduler()->getMaxSleep(_pollInterval * 1000));
+        }
+    }
+
+    return sleep;
+}
 
 uint32_t HoymilesClass::PollInterval() const
 {
@@ -270,3 +354,11 @@ void HoymilesClass::setPollInterval(const uint32_t interval)
 {
     _pollInterval = interval;
 }
+
+void HoymilesClass::setAdaptivePolling(const bool enabled, const uint32_t minInterval, const uint32_t maxInterval)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (HoymilesRadio* radio : getRadios()) {
+        radio->Scheduler()->setAdaptive(enabled, minInterval * 1000, maxInterval * 1000);
+    }
+}
@@ -4,20 +4,35 @@
 #include "HoymilesRadio_CMT.h"
 #include "HoymilesRadio_NRF.h"
 #include "inverters/InverterAbstract.h"
+#ifdef HOYMILES_RADIO_SIM
+#include "HoymilesRadio_Sim.h"
+#endif
 #include "types.h"
 #include <Print.h>
 #include <SPI.h>
+#include <array>
 #include <memory>
 #include <vector>
 
 #define HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL (2 * 60 * 1000) // 2 minutes
 #define HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION (4 * 60 * 1000) // at least 4 minutes between sending limit command and read request. Otherwise eventlog entry
 
+#define HOY_MAX_SLEEP 1000 // maximum time between two loop() calls if no event occurs
+
+#ifdef HOYMILES_RADIO_SIM
+#define HOY_RADIO_COUNT 3
+#else
+#define HOY_RADIO_COUNT 2
+#endif
+
 class HoymilesClass {
 public:
     void init();
     void initNRF(SPIClass* initialisedSpiBus, const uint8_t pinCE, const uint8_t pinIRQ);
     void initCMT(const int8_t pin_sdio, const int8_t pin_clk, const int8_t pin_cs, const int8_t pin_fcs, const int8_t pin_gpio2, const int8_t pin_gpio3);
+#ifdef HOYMILES_RADIO_SIM
+    void initSim();
+#endif
     void loop();
 
     std::shared_ptr<InverterAbstract> addInverter(const char* name, const uint64_t serial);
@@ -29,21 +44,45 @@ public:
 
     HoymilesRadio_NRF* getRadioNrf();
     HoymilesRadio_CMT* getRadioCmt();
+#ifdef HOYMILES_RADIO_SIM
+    HoymilesRadio_Sim* getRadioSim();
+#endif
 
     uint32_t PollInterval() const;
     void setPollInterval(const uint32_t interval);
 
+    // Per inverter poll interval between minInterval and maxInterval (seconds)
+    // depending on reachability, production, failure ratio and power changes
+    void setAdaptivePolling(const bool enabled, const uint32_t minInterval, const uint32_t maxInterval);
+
     bool isAllRadioIdle() const;
 
+    // Task which calls loop(). It gets notified by radio interrupts and new commands.
+    void setWakeupTask(const TaskHandle_t task);
+    void wakeup();
+    void ARDUINO_ISR_ATTR wakeupFromIsr();
+
+    // Maximum time in ms until loop() has to be called again if no event occurs
+    uint32_t getMaxSleep() const;
+
 private:
+    // Enqueues all required requests, returns false if polling and commands are disabled
+    bool pollInverter(InverterAbstract* iv);
+
+    std::array<HoymilesRadio*, HOY_RADIO_COUNT> getRadios() const;
+
     std::vector<std::shared_ptr<InverterAbstract>> _inverters;
     std::unique_ptr<HoymilesRadio_NRF> _radioNrf;
     std::unique_ptr<HoymilesRadio_CMT> _radioCmt;
+#ifdef HOYMILES_RADIO_SIM
+    std::unique_ptr<HoymilesRadio_Sim> _radioSim;
+#endif
 
     std::mutex _mutex;
 
     uint32_t _pollInterval = 0;
-    uint32_t _lastPoll = 0;
+
+    TaskHandle_t _wakeupTask = nullptr;
 };
 
 extern HoymilesClass Hoymiles;
@@ -10,6 +10,15 @@
 #undef TAG
 static const char* TAG = "hoymiles";
 
+// Upper bucket limits of the loop latency histogram in us
+static const std::array<uint32_t, RADIO_LATENCY_BUCKETS - 1> loopLatencyLimits = { 500, 1000, 2000, 5000, 10000, 20000, 50000 };
+
+HoymilesRadio::HoymilesRadio()
+    : _loopLatency(loopLatencyLimits)
+{
+    _pollScheduler.reset(new PollScheduler(this));
+}
+
 serial_u HoymilesRadio::DtuSerial() const
 {
     return _dtuSerial;
@@ -74,6 +83,7 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailNoAnswer++;
                 }
+                inv->addRequestStats(*cmd, false);
 
                 _commandQueue.pop();
                 _busyFlag = false;
@@ -84,6 +94,7 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailPartialAnswer++;
                 }
+                inv->addRequestStats(*cmd, false);
 
                 _commandQueue.pop();
                 _busyFlag = false;
@@ -94,6 +105,7 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailCorruptData++;
                 }
+                inv->addRequestStats(*cmd, false);
 
                 _commandQueue.pop();
                 _busyFlag = false;
@@ -113,6 +125,7 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxSuccess++;
                 }
+                inv->addRequestStats(*cmd, true);
 
                 _commandQueue.pop();
                 _busyFlag = false;
@@ -144,6 +157,39 @@ void HoymilesRadio::handleReceivedPackage()
     }
 }
 
+void HoymilesRadio::notifyCommandQueued()
+{
+    Hoymiles.wakeup();
+}
+
+uint32_t HoymilesRadio::getMaxSleep() const
+{
+    if (!_isInitialized) {
+        return UINT32_MAX;
+    }
+
+    if (_busyFlag) {
+        return _rxTimeout.remaining();
+    }
+
+    return isQueueEmpty() ? UINT32_MAX : 0;
+}
+
+const LatencyHistogram_t& HoymilesRadio::getLoopLatency() const
+{
+    return _loopLatency;
+}
+
+void HoymilesRadio::resetLoopLatency()
+{
+    _loopLatency.reset();
+}
+
+PollScheduler* HoymilesRadio::Scheduler()
+{
+    return _pollScheduler.get();
+}
+
 bool HoymilesRadio::isInitialized() const
 {
     return _isInitialized;
@@ -2,6 +2,8 @@
 #pragma once
 
 #include "Arduino.h"
+#include "Histogram.h"
+#include "PollScheduler.h"
 #include "commands/CommandAbstract.h"
 #include "queue/CommandQueue.h"
 #include "types.h"
@@ -18,8 +20,14 @@ static const char* TAG = "hoymiles";
 #define DEBUG_PRINT(fmt, args...) /* Don't do anything in release builds */
 #endif
 
+#define RADIO_LATENCY_BUCKETS 8
+
+typedef Histogram<uint32_t, RADIO_LATENCY_BUCKETS> LatencyHistogram_t;
+
 class HoymilesRadio {
 public:
+    HoymilesRadio();
+
     serial_u DtuSerial() const;
     virtual void setDtuSerial(const uint64_t serial);
 
@@ -28,6 +36,15 @@ public:
     uint32_t getQueueSize() const;
     bool isInitialized() const;
 
+    // Maximum time in ms until loop() has to be called again if no interrupt occurs
+    virtual uint32_t getMaxSleep() const;
+
+    // Time in us between receiving a fragment (interrupt) and processing it in loop()
+    const LatencyHistogram_t& getLoopLatency() const;
+    void resetLoopLatency();
+
+    PollScheduler* Scheduler();
+
     void removeCommands(InverterAbstract* inv);
     uint8_t countSimilarCommands(std::shared_ptr<CommandAbstract> cmd);
 
@@ -46,6 +63,7 @@ public:
             if (_commandQueue.countSimilarCommands(cmd) > 0) {
                 DEBUG_PRINT("    ... existing entry will be replaced");
                 _commandQueue.replaceEntries(cmd);
+                notifyCommandQueued();
                 return;
             }
             break;
@@ -65,6 +83,7 @@ public:
         // Push the command into the queue if we reach this position of the code
         DEBUG_PRINT("    ... new entry will be appended");
         _commandQueue.push(cmd);
+        notifyCommandQueued();
 
         DEBUG_PRINT("Queue size after: %ld", _commandQueue.size());
     }
@@ -83,6 +102,7 @@ protected:
     void sendRetransmitPacket(const uint8_t fragment_id);
     void sendLastPacketAgain();
     void handleReceivedPackage();
+    void notifyCommandQueued();
 
     serial_u _dtuSerial;
     CommandQueue _commandQueue;
@@ -90,4 +110,8 @@ protected:
     bool _busyFlag = false;
 
     TimeoutHelper _rxTimeout;
+
+    LatencyHistogram_t _loopLatency;
+
+    std::unique_ptr<PollScheduler> _pollScheduler;
 };
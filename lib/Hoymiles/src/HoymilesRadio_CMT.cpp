@@ -126,14 +126,16 @@ void HoymilesRadio_CMT::loop()
 
     if (!_gpio3_configured) {
         if (_radio->rxFifoAvailable()) { // read INT2, PKT_OK flag
+            _packetReceivedTime = micros();
             _packetReceived = true;
         }
     }
 
     if (_packetReceived) {
         ESP_LOGV(TAG, "Interrupt received");
+        _loopLatency.add(micros() - _packetReceivedTime);
         while (_radio->available()) {
-            if (_rxBuffer.size() > FRAGMENT_BUFFER_SIZE) {
+            if (_rxBuffer.full()) {
                 ESP_LOGE(TAG, "CMT2300A: Buffer full");
                 _radio->flush_rx();
                 continue;
@@ -154,8 +156,8 @@ void HoymilesRadio_CMT::loop()
 
     } else {
         // Perform package parsing only if no packages are received
-        if (!_rxBuffer.empty()) {
-            fragment_t f = _rxBuffer.back();
+        fragment_t f;
+        if (_rxBuffer.pop(f)) {
             if (checkFragmentCrc(f)) {
 
                 const serial_u dtuId = convertSerialToRadioId(_dtuSerial);
@@ -180,15 +182,30 @@ void HoymilesRadio_CMT::loop()
             } else {
                 ESP_LOGW(TAG, "Frame kaputt"); // ;-)
             }
-
-            // Remove paket from buffer even it was corrupted
-            _rxBuffer.pop();
         }
     }
 
     handleReceivedPackage();
 }
 
+uint32_t HoymilesRadio_CMT::getMaxSleep() const
+{
+    if (!_isInitialized) {
+        return UINT32_MAX;
+    }
+
+    if (!_rxBuffer.empty()) {
+        return 0;
+    }
+
+    // Without interrupt pin the rx fifo has to be polled
+    if (!_gpio3_configured) {
+        return 1;
+    }
+
+    return HoymilesRadio::getMaxSleep();
+}
+
 void HoymilesRadio_CMT::setPALevel(const int8_t paLevel)
 {
     if (!_isInitialized) {
@@ -261,7 +278,11 @@ void ARDUINO_ISR_ATTR HoymilesRadio_CMT::handleInt1()
 
 void ARDUINO_ISR_ATTR HoymilesRadio_CMT::handleInt2()
 {
+    if (!_packetReceived) {
+        _packetReceivedTime = micros();
+    }
     _packetReceived = true;
+    Hoymiles.wakeupFromIsr();
 }
 
 void HoymilesRadio_CMT::sendEsbPacket(CommandAbstract& cmd)
@@ -5,13 +5,13 @@
 #include "commands/CommandAbstract.h"
 #include "types.h"
 #include <Arduino.h>
+#include <SpscRingBuffer.h>
 #include <cmt2300wrapper.h>
 #include <memory>
-#include <queue>
 #include <vector>
 
-// number of fragments hold in buffer
-#define FRAGMENT_BUFFER_SIZE 30
+// number of fragments hold in buffer (power of two)
+#define FRAGMENT_BUFFER_SIZE 32
 
 #ifndef HOYMILES_CMT_WORK_FREQ
 #define HOYMILES_CMT_WORK_FREQ 865000000
@@ -43,6 +43,7 @@ class HoymilesRadio_CMT : public HoymilesRadio {
 public:
     void init(const int8_t pin_sdio, const int8_t pin_clk, const int8_t pin_cs, const int8_t pin_fcs, const int8_t pin_gpio2, const int8_t pin_gpio3);
     void loop();
+    virtual uint32_t getMaxSleep() const;
     void setPALevel(const int8_t paLevel);
     void setInverterTargetFrequency(const uint32_t frequency);
     uint32_t getInverterTargetFrequency() const;
@@ -75,12 +76,13 @@ private:
     std::unique_ptr<CMT2300A> _radio;
 
     volatile bool _packetReceived = false;
+    volatile uint32_t _packetReceivedTime = 0;
     volatile bool _packetSent = false;
 
     bool _gpio2_configured = false;
     bool _gpio3_configured = false;
 
-    std::queue<fragment_t> _rxBuffer;
+    SpscRingBuffer<fragment_t, FRAGMENT_BUFFER_SIZE> _rxBuffer;
     TimeoutHelper _txTimeout;
 
     uint32_t _inverterTargetFrequency = HOYMILES_CMT_WORK_FREQ;
@@ -47,15 +47,16 @@ void HoymilesRadio_NRF::loop()
         return;
     }
 
-    EVERY_N_MILLIS(4)
+    EVERY_N_MILLIS(NRF_RX_CHANNEL_SWITCH_INTERVAL)
     {
         switchRxCh();
     }
 
     if (_packetReceived) {
         ESP_LOGV(TAG, "Interrupt received");
+        _loopLatency.add(micros() - _packetReceivedTime);
         while (_radio->available()) {
-            if (_rxBuffer.size() > FRAGMENT_BUFFER_SIZE) {
+            if (_rxBuffer.full()) {
                 ESP_LOGE(TAG, "NRF: Buffer full");
                 _radio->flush_rx();
                 continue;
@@ -73,8 +74,8 @@ void HoymilesRadio_NRF::loop()
 
     } else {
         // Perform package parsing only if no packages are received
-        if (!_rxBuffer.empty()) {
-            fragment_t f = _rxBuffer.back();
+        fragment_t f;
+        if (_rxBuffer.pop(f)) {
             if (checkFragmentCrc(f)) {
                 std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(f);
 
@@ -91,9 +92,6 @@ void HoymilesRadio_NRF::loop()
             } else {
                 ESP_LOGW(TAG, "Frame kaputt");
             }
-
-            // Remove paket from buffer even it was corrupted
-            _rxBuffer.pop();
         }
     }
 
@@ -118,6 +116,19 @@ void HoymilesRadio_NRF::setDtuSerial(const uint64_t serial)
     openReadingPipe();
 }
 
+uint32_t HoymilesRadio_NRF::getMaxSleep() const
+{
+    if (!_isInitialized) {
+        return UINT32_MAX;
+    }
+
+    if (!_rxBuffer.empty()) {
+        return 0;
+    }
+
+    return std::min<uint32_t>(HoymilesRadio::getMaxSleep(), NRF_RX_CHANNEL_SWITCH_INTERVAL);
+}
+
 bool HoymilesRadio_NRF::isConnected() const
 {
     if (!_isInitialized) {
@@ -148,7 +159,11 @@ void HoymilesRadio_NRF::openWritingPipe(const serial_u serial)
 
 void ARDUINO_ISR_ATTR HoymilesRadio_NRF::handleIntr()
 {
+    if (!_packetReceived) {
+        _packetReceivedTime = micros();
+    }
     _packetReceived = true;
+    Hoymiles.wakeupFromIsr();
 }
 
 uint8_t HoymilesRadio_NRF::getRxNxtChannel()
@@ -4,12 +4,15 @@
 #include "HoymilesRadio.h"
 #include "commands/CommandAbstract.h"
 #include <RF24.h>
+#include <SpscRingBuffer.h>
 #include <memory>
 #include <nRF24L01.h>
-#include <queue>
 
-// number of fragments hold in buffer
-#define FRAGMENT_BUFFER_SIZE 30
+// number of fragments hold in buffer (power of two)
+#define FRAGMENT_BUFFER_SIZE 32
+
+// interval to switch the rx channel
+#define NRF_RX_CHANNEL_SWITCH_INTERVAL 4
 
 class HoymilesRadio_NRF : public HoymilesRadio {
 public:
@@ -18,6 +21,7 @@ public:
     void setPALevel(const rf24_pa_dbm_e paLevel);
 
     virtual void setDtuSerial(const uint64_t serial);
+    virtual uint32_t getMaxSleep() const;
 
     bool isConnected() const;
     bool isPVariant() const;
@@ -41,6 +45,7 @@ private:
     uint8_t _txChIdx = 0;
 
     volatile bool _packetReceived = false;
+    volatile uint32_t _packetReceivedTime = 0;
 
-    std::queue<fragment_t> _rxBuffer;
+    SpscRingBuffer<fragment_t, FRAGMENT_BUFFER_SIZE> _rxBuffer;
 };
\ No newline at end of file
@@ -0,0 +1,502 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#ifdef HOYMILES_RADIO_SIM
+
+#include "HoymilesRadio_Sim.h"
+#include "Hoymiles.h"
+#include "Utils.h"
+#include "crc.h"
+#include <algorithm>
+#include <esp_log.h>
+#include <math.h>
+
+#undef TAG
+static const char* TAG = "hoymiles";
+
+typedef struct {
+    uint16_t serialPrefix;
+    uint8_t hwPart[3];
+    uint16_t maxPower;
+} simModel_t;
+
+// Hardware part numbers as reported by the real devices (see DevInfoParser)
+static const simModel_t simModels[] = {
+    { 0x1121, { 0x10, 0x10, 0x40 }, 400 }, // HM-400-1T
+    { 0x1141, { 0x10, 0x11, 0x40 }, 800 }, // HM-800-2T
+    { 0x1161, { 0x10, 0x12, 0x30 }, 1500 }, // HM-1500-4T
+    { 0x1124, { 0x10, 0x20, 0x41 }, 400 }, // HMS-400-1T
+    { 0x1125, { 0x10, 0x20, 0x71 }, 500 }, // HMS-500-1T v2
+    { 0x1400, { 0x10, 0x20, 0x71 }, 500 }, // HMS-500-1T v2
+    { 0x1143, { 0x10, 0x21, 0x41 }, 800 }, // HMS-800-2T
+    { 0x1144, { 0x10, 0x21, 0x41 }, 800 }, // HMS-800-2T
+    { 0x1410, { 0x10, 0x21, 0x41 }, 800 }, // HMS-800-2T
+    { 0x1164, { 0x10, 0x22, 0x71 }, 2000 }, // HMS-2000-4T
+    { 0x1420, { 0x10, 0x22, 0x71 }, 2000 }, // HMS-2000-4T
+    { 0x1361, { 0x10, 0x32, 0x71 }, 2000 }, // HMT-2000-4T
+    { 0x1382, { 0x10, 0x33, 0x31 }, 2250 }, // HMT-2250-6T
+    { 0x2841, { 0xF1, 0x01, 0x10 }, 600 }, // HERF-600
+    { 0x2821, { 0xF1, 0x01, 0x14 }, 800 }, // HERF-800
+    { 0x2801, { 0xF1, 0x01, 0x24 }, 1600 }, // HERF-1600
+};
+
+static const simModel_t& getSimModel(const uint64_t serial)
+{
+    const uint16_t prefix = (serial >> 32) & 0xffff;
+    for (auto& model : simModels) {
+        if (model.serialPrefix == prefix) {
+            return model;
+        }
+    }
+    return simModels[0];
+}
+
+void HoymilesRadio_Sim::init()
+{
+    _dtuSerial.u64 = 0;
+
+    ESP_LOGW(TAG, "SIM: Simulated radio active, no RF communication will happen");
+    _isInitialized = true;
+}
+
+void HoymilesRadio_Sim::loop()
+{
+    if (!_isInitialized) {
+        return;
+    }
+
+    // "Receive" all fragments which are due
+    while (!_pending.empty() && static_cast<int32_t>(millis() - _pending.front().due) >= 0) {
+        if (!_rxBuffer.push(_pending.front().fragment)) {
+            ESP_LOGE(TAG, "SIM: Buffer full");
+            _pending.clear();
+            break;
+        }
+        _loopLatency.add((millis() - _pending.front().due) * 1000);
+        _pending.pop_front();
+    }
+
+    fragment_t f;
+    if (_rxBuffer.pop(f)) {
+        if (checkFragmentCrc(f)) {
+            std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(f);
+
+            if (nullptr != inv) {
+                // Save packet in inverter rx buffer
+                ESP_LOGD(TAG, "RX SIM --> %s | %" PRId8 " dBm",
+                    Utils::dumpArray(f.fragment, f.len).c_str(), f.rssi);
+
+                inv->addRxFragment(f.fragment, f.len, f.rssi);
+            } else {
+                ESP_LOGE(TAG, "Inverter Not found!");
+            }
+
+        } else {
+            ESP_LOGW(TAG, "Frame kaputt");
+        }
+    }
+
+    handleReceivedPackage();
+}
+
+uint32_t HoymilesRadio_Sim::getMaxSleep() const
+{
+    if (!_isInitialized) {
+        return UINT32_MAX;
+    }
+
+    if (!_rxBuffer.empty()) {
+        return 0;
+    }
+
+    uint32_t sleep = HoymilesRadio::getMaxSleep();
+    if (!_pending.empty()) {
+        const int32_t due = static_cast<int32_t>(_pending.front().due - millis());
+        sleep = std::min<uint32_t>(sleep, due > 0 ? due : 0);
+    }
+    return sleep;
+}
+
+void HoymilesRadio_Sim::setFragmentLoss(const uint8_t percent)
+{
+    _fragmentLoss = std::min<uint8_t>(percent, 100);
+}
+
+uint8_t HoymilesRadio_Sim::getFragmentLoss() const
+{
+    return _fragmentLoss;
+}
+
+void HoymilesRadio_Sim::setFragmentCorruption(const uint8_t percent)
+{
+    _fragmentCorruption = std::min<uint8_t>(percent, 100);
+}
+
+uint8_t HoymilesRadio_Sim::getFragmentCorruption() const
+{
+    return _fragmentCorruption;
+}
+
+void HoymilesRadio_Sim::setLatency(const uint32_t latency)
+{
+    _latency = latency;
+}
+
+uint32_t HoymilesRadio_Sim::getLatency() const
+{
+    return _latency;
+}
+
+void HoymilesRadio_Sim::setSeed(const uint32_t seed)
+{
+    // xorshift must not be seeded with zero
+    _randomState = seed != 0 ? seed : 1;
+}
+
+void HoymilesRadio_Sim::setRecordedPayload(const uint64_t serial, const uint8_t data_type, const uint8_t* payload, const uint8_t len)
+{
+    _recordedPayloads[std::make_pair(serial, data_type)].assign(payload, payload + len);
+}
+
+void HoymilesRadio_Sim::clearRecordedPayloads()
+{
+    _recordedPayloads.clear();
+}
+
+uint32_t HoymilesRadio_Sim::getTxCount() const
+{
+    return _txCount;
+}
+
+uint32_t HoymilesRadio_Sim::getFragmentsSent() const
+{
+    return _fragmentsSent;
+}
+
+uint32_t HoymilesRadio_Sim::getFragmentsDropped() const
+{
+    return _fragmentsDropped;
+}
+
+uint32_t HoymilesRadio_Sim::getFragmentsCorrupted() const
+{
+    return _fragmentsCorrupted;
+}
+
+uint32_t HoymilesRadio_Sim::random()
+{
+    // xorshift32
+    _randomState ^= _randomState << 13;
+    _randomState ^= _randomState >> 17;
+    _randomState ^= _randomState << 5;
+    return _randomState;
+}
+
+void HoymilesRadio_Sim::sendEsbPacket(CommandAbstract& cmd)
+{
+    cmd.incrementSendCount();
+
+    cmd.setRouterAddress(DtuSerial().u64);
+
+    ESP_LOGD(TAG, "TX %s SIM --> %s",
+        cmd.getCommandName().c_str(), cmd.dumpDataPayload().c_str());
+
+    _txCount++;
+
+    const uint8_t* request = cmd.getDataPayload();
+    auto inv = Hoymiles.getInverterBySerial(cmd.getTargetAddress());
+
+    if (nullptr != inv && crc8(request, cmd.getDataSize() - 1) == request[cmd.getDataSize() - 1]) {
+        switch (request[0]) {
+        case 0x15:
+            if ((request[9] & 0x7f) == 0) {
+                handleMultiDataRequest(inv.get(), request);
+            } else {
+                // Retransmit request of a single fragment
+                const uint8_t frameNo = request[9] & 0x7f;
+                if (frameNo <= _lastResponse.size()) {
+                    scheduleFragment(_lastResponse[frameNo - 1], millis() + _latency);
+                }
+            }
+            break;
+        case 0x51:
+            handleDevControlRequest(inv.get(), request);
+            break;
+        default:
+            // e.g. ChannelChangeCommand which never retrieves an answer
+            break;
+        }
+    }
+
+    _busyFlag = true;
+    _rxTimeout.set(cmd.getTimeout());
+}
+
+void HoymilesRadio_Sim::handleMultiDataRequest(InverterAbstract* inv, const uint8_t* request)
+{
+    const uint8_t dataType = request[10];
+    std::vector<uint8_t> payload;
+
+    auto recorded = _recordedPayloads.find(std::make_pair(inv->serial(), dataType));
+    if (recorded != _recordedPayloads.end()) {
+        payload = recorded->second;
+    } else {
+        switch (dataType) {
+        case 0x0b: // RealTimeRunData_Debug
+            createStatisticsPayload(inv, payload);
+            break;
+        case 0x01: // InverterDevInform_All
+            createDevInfoAllPayload(payload);
+            break;
+        case 0x00: // InverterDevInform_Simple
+            createDevInfoSimplePayload(inv, payload);
+            break;
+        case 0x05: // SystemConfigPara
+            createSystemConfigParaPayload(inv, payload);
+            break;
+        case 0x11: // AlarmData
+            payload.assign(2, 0x00); // Empty event log
+            break;
+        case 0x02: // GridOnProFilePara
+            createGridProfilePayload(payload);
+            break;
+        default:
+            ESP_LOGW(TAG, "SIM: Unsupported data type %02X", dataType);
+            return;
+        }
+    }
+
+    buildResponse(inv, request[0], payload);
+}
+
+void HoymilesRadio_Sim::handleDevControlRequest(InverterAbstract* inv, const uint8_t* request)
+{
+    SimInverterState_t& state = _state[inv->serial()];
+
+    switch (request[10]) {
+    case 0x00: // TurnOn
+        state.producing = true;
+        break;
+    case 0x01: // TurnOff
+        state.producing = false;
+        break;
+    case 0x0b: { // ActivePowerControl
+        const float limit = static_cast<float>((static_cast<uint16_t>(request[12]) << 8) | request[13]) / 10;
+        const uint16_t type = (static_cast<uint16_t>(request[14]) << 8) | request[15];
+        if (type == PowerLimitControlType::RelativNonPersistent || type == PowerLimitControlType::RelativPersistent) {
+            state.limitPercent = limit;
+        } else {
+            state.limitPercent = limit / getMaxPower(inv->serial()) * 100;
+        }
+        state.limitPercent = std::min<float>(state.limitPercent, 100);
+        break;
+    }
+    default:
+        break;
+    }
+
+    // Acknowledge the command with the same sub command
+    buildResponse(inv, request[0], std::vector<uint8_t> { request[10], request[11] });
+}
+
+void HoymilesRadio_Sim::createStatisticsPayload(InverterAbstract* inv, std::vector<uint8_t>& payload)
+{
+    SimInverterState_t& state = _state[inv->serial()];
+    const byteAssign_t* assignment = inv->getByteAssignment();
+    const uint8_t size = inv->getByteAssignmentSize();
+
+    uint8_t dcChannels = 0;
+    uint8_t payloadSize = 0;
+    for (uint8_t i = 0; i < size; i++) {
+        if (assignment[i].div == CMD_CALC) {
+            continue;
+        }
+        if (assignment[i].type == TYPE_DC && assignment[i].fieldId == FLD_PDC) {
+            dcChannels++;
+        }
+        payloadSize = std::max<uint8_t>(payloadSize, assignment[i].start + assignment[i].num);
+    }
+    payload.assign(payloadSize, 0x00);
+
+    // Slowly changing output with a period of one hour
+    const uint32_t now = millis();
+    const float sun = 0.5f + 0.3f * sinf(2 * M_PI * (now % 3600000) / 3600000.0f);
+    const float totalPower = state.producing ? getMaxPower(inv->serial()) * sun * state.limitPercent / 100 : 0;
+    const float channelPower = dcChannels > 0 ? totalPower / dcChannels : 0;
+    const float acPower = totalPower * 0.955f;
+
+    if (state.lastUpdate == 0) {
+        for (uint8_t ch = 0; ch < CH_CNT; ch++) {
+            state.yieldTotal[ch] = 100.0f + 10.0f * ch;
+        }
+    } else {
+        const float energy = channelPower * (now - state.lastUpdate) / 3600000.0f;
+        for (uint8_t ch = 0; ch < CH_CNT; ch++) {
+            state.yieldDay[ch] += energy;
+            state.yieldTotal[ch] += energy / 1000;
+        }
+    }
+    state.lastUpdate = now;
+
+    for (uint8_t i = 0; i < size; i++) {
+        const byteAssign_t& b = assignment[i];
+        if (b.div == CMD_CALC) {
+            continue;
+        }
+
+        const float voltage = state.producing ? 230.0f : 0;
+        float value = 0;
+        switch (b.fieldId) {
+        case FLD_UDC:
+            value = 32.0f + 4.0f * sun;
+            break;
+        case FLD_IDC:
+            value = channelPower / (32.0f + 4.0f * sun);
+            break;
+        case FLD_PDC:
+            value = channelPower;
+            break;
+        case FLD_YD:
+            value = state.yieldDay[b.ch];
+            break;
+        case FLD_YT:
+            value = state.yieldTotal[b.ch];
+            break;
+        case FLD_UAC:
+        case FLD_UAC_1N:
+        case FLD_UAC_2N:
+        case FLD_UAC_3N:
+            value = voltage;
+            break;
+        case FLD_UAC_12:
+        case FLD_UAC_23:
+        case FLD_UAC_31:
+            value = voltage * 1.732f;
+            break;
+        case FLD_IAC:
+            value = acPower / 230.0f;
+            break;
+        case FLD_IAC_1:
+        case FLD_IAC_2:
+        case FLD_IAC_3:
+            value = acPower / 3 / 230.0f;
+            break;
+        case FLD_PAC:
+            value = acPower;
+            break;
+        case FLD_F:
+            value = state.producing ? 50.0f : 0;
+            break;
+        case FLD_T:
+            value = 25.0f + 20.0f * sun;
+            break;
+        case FLD_PF:
+            value = state.producing ? 1.0f : 0;
+            break;
+        default:
+            // FLD_Q, FLD_EVT_LOG
+            break;
+        }
+
+        uint32_t raw = static_cast<uint32_t>(lroundf(value * b.div));
+        for (int8_t pos = b.num - 1; pos >= 0; pos--) {
+            payload[b.start + pos] = raw & 0xff;
+            raw >>= 8;
+        }
+    }
+}
+
+void HoymilesRadio_Sim::createDevInfoAllPayload(std::vector<uint8_t>& payload) const
+{
+    // Firmware 1.0.27 build at 2024-03-01 12:00, bootloader 0.1.0
+    payload = { 0x27, 0x1B, 0x07, 0xE8, 0x01, 0x2D, 0x04, 0xB0, 0x00, 0x64 };
+}
+
+void HoymilesRadio_Sim::createDevInfoSimplePayload(InverterAbstract* inv, std::vector<uint8_t>& payload) const
+{
+    const simModel_t& model = getSimModel(inv->serial());
+    payload = { 0x27, 0x1B, model.hwPart[0], model.hwPart[1], model.hwPart[2], 0x00, 0x01, 0x00 };
+}
+
+void HoymilesRadio_Sim::createSystemConfigParaPayload(InverterAbstract* inv, std::vector<uint8_t>& payload)
+{
+    const uint16_t limit = lroundf(_state[inv->serial()].limitPercent * 10);
+    payload.assign(SYSTEM_CONFIG_PARA_SIZE, 0x00);
+    payload[2] = limit >> 8;
+    payload[3] = limit & 0xff;
+}
+
+void HoymilesRadio_Sim::createGridProfilePayload(std::vector<uint8_t>& payload) const
+{
+    // DE_VDE4105_2018 without any section
+    payload = { 0x03, 0x00, 0x20, 0x00, 0xff, 0x00, 0x00, 0x00 };
+}
+
+void HoymilesRadio_Sim::buildResponse(InverterAbstract* inv, const uint8_t mainCmd, const std::vector<uint8_t>& payload)
+{
+    // Append CRC16 of the whole payload
+    std::vector<uint8_t> data = payload;
+    const uint16_t crc = crc16(data.data(), data.size());
+    data.push_back(crc >> 8);
+    data.push_back(crc & 0xff);
+
+    serial_u invSerial;
+    invSerial.u64 = inv->serial();
+
+    const uint8_t fragmentCount = (data.size() + SIM_FRAGMENT_DATA_SIZE - 1) / SIM_FRAGMENT_DATA_SIZE;
+    if (fragmentCount >= MAX_RF_FRAGMENT_COUNT) {
+        ESP_LOGE(TAG, "SIM: Response too large (%zu bytes)", data.size());
+        return;
+    }
+
+    _lastResponse.clear();
+    const uint32_t now = millis();
+    for (uint8_t i = 0; i < fragmentCount; i++) {
+        const uint8_t len = std::min<size_t>(SIM_FRAGMENT_DATA_SIZE, data.size() - i * SIM_FRAGMENT_DATA_SIZE);
+
+        fragment_t f = {};
+        f.fragment[0] = mainCmd | 0x80;
+        f.fragment[1] = invSerial.b[3];
+        f.fragment[2] = invSerial.b[2];
+        f.fragment[3] = invSerial.b[1];
+        f.fragment[4] = invSerial.b[0];
+        f.fragment[5] = _dtuSerial.b[3];
+        f.fragment[6] = _dtuSerial.b[2];
+        f.fragment[7] = _dtuSerial.b[1];
+        f.fragment[8] = _dtuSerial.b[0];
+        f.fragment[9] = (i + 1) | (i == fragmentCount - 1 ? 0x80 : 0x00);
+        memcpy(&f.fragment[10], &data[i * SIM_FRAGMENT_DATA_SIZE], len);
+        f.fragment[10 + len] = crc8(f.fragment, 10 + len);
+        f.len = 11 + len;
+        f.rssi = -50;
+
+        _lastResponse.push_back(f);
+        scheduleFragment(f, now + _latency + i * SIM_FRAGMENT_INTERVAL);
+    }
+}
+
+void HoymilesRadio_Sim::scheduleFragment(const fragment_t& fragment, const uint32_t due)
+{
+    if (random() % 100 < _fragmentLoss) {
+        _fragmentsDropped++;
+        return;
+    }
+
+    SimPendingFragment_t p = { fragment, due };
+    if (random() % 100 < _fragmentCorruption) {
+        // Flip one bit of the payload, the CRC8 will not match anymore
+        p.fragment.fragment[random() % (p.fragment.len - 1)] ^= 1 << (random() % 8);
+        _fragmentsCorrupted++;
+    }
+
+    _fragmentsSent++;
+    _pending.push_back(p);
+}
+
+uint16_t HoymilesRadio_Sim::getMaxPower(const uint64_t serial)
+{
+    return getSimModel(serial).maxPower;
+}
+
+#endif
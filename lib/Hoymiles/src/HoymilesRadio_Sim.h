@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "HoymilesRadio.h"
+#include "commands/CommandAbstract.h"
+#include "parser/StatisticsParser.h"
+#include "types.h"
+#include <SpscRingBuffer.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+// Simulated radio which answers all requests of the assigned inverters without
+// any RF hardware. Responses are synthesized from the byte assignment of the
+// inverter model (or replayed from recorded payloads) and pass through the same
+// fragment, CRC and retransmit handling as the NRF24 and CMT2300A radios.
+// Fragment loss, corruption and latency can be injected to reproduce error
+// paths deterministically.
+
+// number of fragments hold in buffer (power of two)
+#define SIM_FRAGMENT_BUFFER_SIZE 32
+
+// payload bytes per response fragment (same as the real inverters)
+#define SIM_FRAGMENT_DATA_SIZE 16
+
+// time between two fragments of one response
+#define SIM_FRAGMENT_INTERVAL 2
+
+struct SimInverterState_t {
+    float limitPercent = 100;
+    bool producing = true;
+    float yieldDay[CH_CNT] = {};
+    float yieldTotal[CH_CNT] = {};
+    uint32_t lastUpdate = 0;
+};
+
+struct SimPendingFragment_t {
+    fragment_t fragment;
+    uint32_t due;
+};
+
+class HoymilesRadio_Sim : public HoymilesRadio {
+public:
+    void init();
+    void loop();
+    virtual uint32_t getMaxSleep() const;
+
+    // Percentage (0-100) of fragments which will not be delivered
+    void setFragmentLoss(const uint8_t percent);
+    uint8_t getFragmentLoss() const;
+
+    // Percentage (0-100) of fragments which will be delivered with a wrong CRC8
+    void setFragmentCorruption(const uint8_t percent);
+    uint8_t getFragmentCorruption() const;
+
+    // Delay in ms between sending a request and receiving the first fragment
+    void setLatency(const uint32_t latency);
+    uint32_t getLatency() const;
+
+    // Seed of the pseudo random generator used for loss and corruption
+    void setSeed(const uint32_t seed);
+
+    // Answer the given multi data request (data_type) of an inverter with a
+    // recorded payload instead of a synthesized one. Payload without CRC16.
+    void setRecordedPayload(const uint64_t serial, const uint8_t data_type, const uint8_t* payload, const uint8_t len);
+    void clearRecordedPayloads();
+
+    uint32_t getTxCount() const;
+    uint32_t getFragmentsSent() const;
+    uint32_t getFragmentsDropped() const;
+    uint32_t getFragmentsCorrupted() const;
+
+private:
+    void sendEsbPacket(CommandAbstract& cmd);
+
+    void handleMultiDataRequest(InverterAbstract* inv, const uint8_t* request);
+    void handleDevControlRequest(InverterAbstract* inv, const uint8_t* request);
+
+    void createStatisticsPayload(InverterAbstract* inv, std::vector<uint8_t>& payload);
+    void createDevInfoAllPayload(std::vector<uint8_t>& payload) const;
+    void createDevInfoSimplePayload(InverterAbstract* inv, std::vector<uint8_t>& payload) const;
+    void createSystemConfigParaPayload(InverterAbstract* inv, std::vector<uint8_t>& payload);
+    void createGridProfilePayload(std::vector<uint8_t>& payload) const;
+
+    void buildResponse(InverterAbstract* inv, const uint8_t mainCmd, const std::vector<uint8_t>& payload);
+    void scheduleFragment(const fragment_t& fragment, const uint32_t due);
+
+    static uint16_t getMaxPower(const uint64_t serial);
+
+    uint32_t random();
+
+    uint8_t _fragmentLoss = 0;
+    uint8_t _fragmentCorruption = 0;
+    uint32_t _latency = 20;
+    uint32_t _randomState = 1;
+
+    uint32_t _txCount = 0;
+    uint32_t _fragmentsSent = 0;
+    uint32_t _fragmentsDropped = 0;
+    uint32_t _fragmentsCorrupted = 0;
+
+    // Fragments of the last response, used to answer retransmit requests
+    std::vector<fragment_t> _lastResponse;
+
+    std::deque<SimPendingFragment_t> _pending;
+    SpscRingBuffer<fragment_t, SIM_FRAGMENT_BUFFER_SIZE> _rxBuffer;
+
+    std::map<uint64_t, SimInverterState_t> _state;
+    std::map<std::pair<uint64_t, uint8_t>, std::vector<uint8_t>> _recordedPayloads;
+};
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "PollScheduler.h"
+#include "HoymilesRadio.h"
+#include "inverters/InverterAbstract.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <cmath>
+
+PollScheduler::PollScheduler(const HoymilesRadio* radio)
+    : _radio(radio)
+{
+}
+
+std::shared_ptr<InverterAbstract> PollScheduler::getNextInverter(const std::vector<std::shared_ptr<InverterAbstract>>& inverters, const uint32_t interval)
+{
+    if (!_radio->isInitialized() || millis() - _lastPoll <= interval) {
+        return nullptr;
+    }
+
+    const uint32_t now = millis();
+
+    std::shared_ptr<InverterAbstract> next = nullptr;
+    PollState_t* nextState = nullptr;
+    float nextUrgency = 0;
+    bool cycleComplete = true;
+
+    for (auto& iv : inverters) {
+        if (iv->getRadio() != _radio) {
+            continue;
+        }
+
+        PollState_t& state = _state[iv->serial()];
+        updateState(iv.get(), state);
+        cycleComplete = cycleComplete && state.inCycle;
+
+        // Inverters which were never polled come first
+        const uint32_t sincePoll = state.polled ? now - state.lastPoll : UINT32_MAX;
+        const uint32_t ivInterval = calcInterval(iv.get(), state);
+        if (sincePoll < ivInterval) {
+            continue;
+        }
+
+        const float urgency = ivInterval > 0 ? static_cast<float>(sincePoll) / ivInterval : sincePoll;
+        if (next == nullptr || urgency > nextUrgency) {
+            next = iv;
+            nextState = &state;
+            nextUrgency = urgency;
+        }
+    }
+
+    if (next == nullptr) {
+        // No inverter is due, check again after the next interval
+        _lastPoll = now;
+        return nullptr;
+    }
+
+    // Each inverter was polled since the start of the round
+    if (cycleComplete || !_cycleStarted) {
+        if (_cycleStarted) {
+            _cycleTime = now - _cycleStart;
+        }
+        for (auto& state : _state) {
+            state.second.inCycle = false;
+        }
+        _cycleStart = now;
+        _cycleStarted = true;
+    }
+
+    nextState->polled = true;
+    nextState->lastPoll = now;
+    nextState->inCycle = true;
+    return next;
+}
+
+void PollScheduler::setPolled()
+{
+    _lastPoll = millis();
+}
+
+uint32_t PollScheduler::getMaxSleep(const uint32_t interval) const
+{
+    if (!_radio->isInitialized()) {
+        return UINT32_MAX;
+    }
+
+    const uint32_t sinceLastPoll = millis() - _lastPoll;
+    return sinceLastPoll > interval ? 0 : interval - sinceLastPoll + 1;
+}
+
+uint32_t PollScheduler::getCycleTime() const
+{
+    return _cycleTime;
+}
+
+void PollScheduler::setAdaptive(const bool enabled, const uint32_t minInterval, const uint32_t maxInterval)
+{
+    _adaptive = enabled;
+    _minInterval = minInterval;
+    _maxInterval = std::max(minInterval, maxInterval);
+}
+
+bool PollScheduler::getAdaptive() const
+{
+    return _adaptive;
+}
+
+void PollScheduler::removeInverter(const uint64_t serial)
+{
+    _state.erase(serial);
+}
+
+void PollScheduler::updateState(InverterAbstract* iv, PollState_t& state) const
+{
+    StatisticsParser* statistics = iv->Statistics();
+    const uint32_t generation = statistics->getGeneration();
+    if (generation != state.generation) {
+        state.generation = generation;
+
+        // Ignore the initial values until the first response was received
+        if (statistics->getLastUpdate() > 0 && statistics->hasChannelFieldValue(TYPE_AC, CH0, FLD_PAC)) {
+            const float pac = statistics->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
+            if (state.hasPac) {
+                const float change = std::fabs(pac - state.pac) / std::max(std::fabs(state.pac), POLL_PAC_REFERENCE_MIN);
+                state.pacChange = (state.pacChange + change) / 2;
+            }
+            state.pac = pac;
+            state.hasPac = true;
+        }
+    }
+
+    const uint32_t txCount = iv->RadioStats.TxRequestData;
+    const uint32_t failCount = iv->RadioStats.RxFailNoAnswer
+        + iv->RadioStats.RxFailPartialAnswer
+        + iv->RadioStats.RxFailCorruptData;
+
+    if (txCount > state.txCount && failCount >= state.failCount) {
+        const float ratio = std::min(1.0f, static_cast<float>(failCount - state.failCount) / (txCount - state.txCount));
+        state.failureRatio = (state.failureRatio + ratio) / 2;
+    }
+
+    // The counters are also reset by resetRadioStats()
+    state.txCount = txCount;
+    state.failCount = failCount;
+}
+
+uint32_t PollScheduler::calcInterval(InverterAbstract* iv, const PollState_t& state) const
+{
+    if (!_adaptive) {
+        return 0;
+    }
+
+    if (!iv->isReachable()) {
+        return _maxInterval;
+    }
+
+    // Fetch the first data as fast as possible
+    if (iv->Statistics()->getLastUpdate() == 0) {
+        return _minInterval;
+    }
+
+    if (!iv->isProducing()) {
+        return _maxInterval;
+    }
+
+    // 0 = fast changing and reliable, 1 = stable or failing
+    float backoff = 1.0f - std::min(1.0f, state.pacChange / POLL_PAC_CHANGE_FAST);
+    backoff = std::max(backoff, state.failureRatio);
+
+    return _minInterval + static_cast<uint32_t>(backoff * (_maxInterval - _minInterval));
+}
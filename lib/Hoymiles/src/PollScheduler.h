@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Relative change of the AC power between two statistics updates which is
+// considered as fast change (polled with the minimum interval)
+#define POLL_PAC_CHANGE_FAST 0.1f
+
+// Lower limit of the reference power used to calculate the relative change (W)
+#define POLL_PAC_REFERENCE_MIN 10.0f
+
+class HoymilesRadio;
+class InverterAbstract;
+
+struct PollState_t {
+    bool polled = false;
+    uint32_t lastPoll = 0;
+
+    // Set if the inverter was polled in the current round
+    bool inCycle = false;
+
+    // Smoothed relative change of FLD_PAC per statistics update
+    uint32_t generation = 0;
+    bool hasPac = false;
+    float pac = 0;
+    float pacChange = 0;
+
+    // Smoothed ratio of failed requests
+    uint32_t txCount = 0;
+    uint32_t failCount = 0;
+    float failureRatio = 0;
+};
+
+// Poll scheduler of one radio. Every radio has its own poll timer so that
+// inverters on different radios are polled in parallel. Each time the poll
+// interval elapsed the most overdue inverter of the radio is polled. Without
+// adaptive polling all inverters are due at any time which results in round
+// robin. With adaptive polling each inverter gets its own interval between
+// the minimum and maximum interval. Unreachable, not producing and unstable
+// (failing) inverters back off to the maximum interval, inverters with a
+// fast changing AC power approach the minimum interval.
+class PollScheduler {
+public:
+    explicit PollScheduler(const HoymilesRadio* radio);
+
+    // Returns the next inverter of the radio if the poll interval (ms) elapsed, otherwise nullptr
+    std::shared_ptr<InverterAbstract> getNextInverter(const std::vector<std::shared_ptr<InverterAbstract>>& inverters, const uint32_t interval);
+
+    // Has to be called after the requests of the inverter were enqueued
+    void setPolled();
+
+    // Time in ms until the next inverter is due
+    uint32_t getMaxSleep(const uint32_t interval) const;
+
+    // Time in ms required for the last complete round over all inverters of the radio
+    uint32_t getCycleTime() const;
+
+    // Minimum and maximum interval in ms of each inverter if adaptive polling is enabled
+    void setAdaptive(const bool enabled, const uint32_t minInterval, const uint32_t maxInterval);
+    bool getAdaptive() const;
+
+    void removeInverter(const uint64_t serial);
+
+private:
+    void updateState(InverterAbstract* iv, PollState_t& state) const;
+    uint32_t calcInterval(InverterAbstract* iv, const PollState_t& state) const;
+
+    const HoymilesRadio* _radio;
+
+    uint32_t _lastPoll = 0;
+
+    bool _cycleStarted = false;
+    uint32_t _cycleStart = 0;
+    uint32_t _cycleTime = 0;
+
+    bool _adaptive = false;
+    uint32_t _minInterval = 0;
+    uint32_t _maxInterval = 0;
+
+    std::map<uint64_t, PollState_t> _state;
+};
@@ -18,4 +18,7 @@ public:
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
 
     virtual uint8_t getMaxResendCount() const;
+
+    // Commands pushed afterwards must not be sent before the inverter switched the channel
+    virtual CommandPriority getPriority() const { return CommandPriority::High; }
 };
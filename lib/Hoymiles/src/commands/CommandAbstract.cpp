@@ -108,6 +108,16 @@ uint8_t CommandAbstract::incrementSendCount()
     return _sendCount++;
 }
 
+uint8_t CommandAbstract::getBypassCount() const
+{
+    return _bypassCount;
+}
+
+void CommandAbstract::incrementBypassCount()
+{
+    _bypassCount++;
+}
+
 CommandAbstract* CommandAbstract::getRequestFrameCommand(const uint8_t frame_no)
 {
     return nullptr;
@@ -24,6 +24,33 @@ enum class QueueInsertType {
     ReplaceExistent,
 };
 
+enum class CommandPriority {
+    // Commands which change the state of the inverter (limit, power) and the
+    // channel change of HMS/HMT inverters which no command is allowed to bypass
+    High,
+
+    // Periodically polled data (statistics, alarms, limit)
+    Normal,
+
+    // Data which rarely changes (device info, grid profile)
+    Low,
+};
+
+// Groups of commands used for the radio statistics
+enum class CommandType {
+    RealTimeRunData = 0,
+    AlarmData,
+    DevInfo,
+    SystemConfigPara,
+    GridProfile,
+    // Commands which change the state of the inverter (limit, power, restart)
+    Control,
+    Other,
+};
+#define COMMAND_TYPE_CNT 7
+
+const char* const commandTypeNames[] = { "RealTimeRunData", "AlarmData", "DevInfo", "SystemConfigPara", "GridProfile", "Control", "Other" };
+
 class CommandAbstract {
 public:
     explicit CommandAbstract(InverterAbstract* inv, const uint64_t router_address = 0);
@@ -63,11 +90,21 @@ public:
     virtual QueueInsertType getQueueInsertType() const { return QueueInsertType::RemoveNewest; }
     virtual bool areSameParameter(CommandAbstract* other);
 
+    // Commands with a higher priority are inserted in front of commands with a lower priority
+    virtual CommandPriority getPriority() const { return CommandPriority::Normal; }
+
+    virtual CommandType getCommandType() const { return CommandType::Other; }
+
+    // Number of commands with a higher priority which were inserted in front of this command
+    uint8_t getBypassCount() const;
+    void incrementBypassCount();
+
 protected:
     uint8_t _payload[RF_LEN];
     uint8_t _payload_size;
     uint32_t _timeout;
     uint8_t _sendCount;
+    uint8_t _bypassCount = 0;
 
     uint64_t _targetAddress;
     uint64_t _routerAddress;
@@ -9,6 +9,9 @@ public:
 
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
 
+    virtual CommandPriority getPriority() const { return CommandPriority::High; }
+    virtual CommandType getCommandType() const { return CommandType::Control; }
+
 protected:
     void udpateCRC(const uint8_t len);
 };
@@ -10,4 +10,7 @@ public:
     virtual String getCommandName() const;
 
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
+
+    virtual CommandPriority getPriority() const { return CommandPriority::Low; }
+    virtual CommandType getCommandType() const { return CommandType::DevInfo; }
 };
@@ -6,4 +6,7 @@
 class ParaSetCommand : public CommandAbstract {
 public:
     explicit ParaSetCommand(InverterAbstract* inv, const uint64_t router_address = 0);
+
+    virtual CommandPriority getPriority() const { return CommandPriority::High; }
+    virtual CommandType getCommandType() const { return CommandType::Control; }
 };
@@ -9,6 +9,8 @@ public:
 
     virtual String getCommandName() const;
 
+    virtual CommandType getCommandType() const { return CommandType::SystemConfigPara; }
+
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
     virtual void gotTimeout();
 };
@@ -1,17 +1,69 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
- * Copyright (C) 2022 Thomas Basler and others
+ * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "crc.h"
+#include <array>
+
+// The lookup tables are generated at compile time from the polynoms.
+// Default are 256 entry tables (one lookup per byte). HOY_CRC_NIBBLE_TABLE
+// selects 16 entry tables (two lookups per byte) to save flash.
+#ifdef HOY_CRC_NIBBLE_TABLE
+#define CRC_TABLE_BITS 4
+#else
+#define CRC_TABLE_BITS 8
+#endif
+
+#define CRC_TABLE_SIZE (1 << CRC_TABLE_BITS)
+
+template <typename T, T poly>
+static constexpr std::array<T, CRC_TABLE_SIZE> generateMsbTable()
+{
+    // Shift the index through the upper bits of the register (MSB first)
+    constexpr uint8_t width = sizeof(T) * 8;
+    constexpr T topBit = static_cast<T>(1) << (width - 1);
+
+    std::array<T, CRC_TABLE_SIZE> table = {};
+    for (uint16_t i = 0; i < CRC_TABLE_SIZE; i++) {
+        T crc = static_cast<T>(i << (width - CRC_TABLE_BITS));
+        for (uint8_t b = 0; b < CRC_TABLE_BITS; b++) {
+            crc = (crc & topBit) ? static_cast<T>((crc << 1) ^ poly) : static_cast<T>(crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+template <typename T, T poly>
+static constexpr std::array<T, CRC_TABLE_SIZE> generateLsbTable()
+{
+    // Shift the index through the lower bits of the register (reflected, LSB first)
+    std::array<T, CRC_TABLE_SIZE> table = {};
+    for (uint16_t i = 0; i < CRC_TABLE_SIZE; i++) {
+        T crc = static_cast<T>(i);
+        for (uint8_t b = 0; b < CRC_TABLE_BITS; b++) {
+            crc = (crc & 0x0001) ? static_cast<T>((crc >> 1) ^ poly) : static_cast<T>(crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+static constexpr auto crc8Table = generateMsbTable<uint8_t, CRC8_POLY>();
+static constexpr auto crc16Table = generateLsbTable<uint16_t, CRC16_MODBUS_POLYNOM>();
+static constexpr auto crc16nrf24Table = generateMsbTable<uint16_t, CRC16_NRF24_POLYNOM>();
 
 uint8_t crc8(const uint8_t buf[], const uint8_t len)
 {
     uint8_t crc = CRC8_INIT;
     for (uint8_t i = 0; i < len; i++) {
         crc ^= buf[i];
-        for (uint8_t b = 0; b < 8; b++) {
-            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
-        }
+#ifdef HOY_CRC_NIBBLE_TABLE
+        crc = (crc << 4) ^ crc8Table[crc >> 4];
+        crc = (crc << 4) ^ crc8Table[crc >> 4];
+#else
+        crc = crc8Table[crc];
+#endif
     }
     return crc;
 }
@@ -19,32 +71,50 @@ uint8_t crc8(const uint8_t buf[], const uint8_t len)
 uint16_t crc16(const uint8_t buf[], const uint8_t len, const uint16_t start)
 {
     uint16_t crc = start;
-    uint8_t shift = 0;
 
     for (uint8_t i = 0; i < len; i++) {
-        crc = crc ^ buf[i];
-        for (uint8_t bit = 0; bit < 8; bit++) {
-            shift = (crc & 0x0001);
-            crc = crc >> 1;
-            if (shift != 0)
-                crc = crc ^ 0xA001;
-        }
+        crc ^= buf[i];
+#ifdef HOY_CRC_NIBBLE_TABLE
+        crc = (crc >> 4) ^ crc16Table[crc & 0x0f];
+        crc = (crc >> 4) ^ crc16Table[crc & 0x0f];
+#else
+        crc = (crc >> 8) ^ crc16Table[crc & 0xff];
+#endif
     }
     return crc;
 }
 
+static inline uint16_t crc16nrf24Bit(uint16_t crc, const uint8_t val, const uint8_t idx)
+{
+    crc ^= 0x8000 & (val << (8 + idx));
+    return (crc & 0x8000) ? ((crc << 1) ^ CRC16_NRF24_POLYNOM) : (crc << 1);
+}
+
 uint16_t crc16nrf24(const uint8_t buf[], const uint16_t lenBits, const uint16_t startBit, const uint16_t crcIn)
 {
     uint16_t crc = crcIn;
-    uint8_t idx, val = buf[(startBit >> 3)];
-
-    for (uint16_t bit = startBit; bit < lenBits; bit++) {
-        idx = bit & 0x07;
-        if (0 == idx)
-            val = buf[(bit >> 3)];
-        crc ^= 0x8000 & (val << (8 + idx));
-        crc = (crc & 0x8000) ? ((crc << 1) ^ CRC16_NRF24_POLYNOM) : (crc << 1);
+    uint16_t bit = startBit;
+
+    // Leading bits until the next byte boundary
+    for (; bit < lenBits && (bit & 0x07) != 0; bit++) {
+        crc = crc16nrf24Bit(crc, buf[bit >> 3], bit & 0x07);
+    }
+
+    // Complete bytes
+    for (; bit + 8 <= lenBits; bit += 8) {
+        crc ^= static_cast<uint16_t>(buf[bit >> 3]) << 8;
+#ifdef HOY_CRC_NIBBLE_TABLE
+        crc = (crc << 4) ^ crc16nrf24Table[crc >> 12];
+        crc = (crc << 4) ^ crc16nrf24Table[crc >> 12];
+#else
+        crc = (crc << 8) ^ crc16nrf24Table[crc >> 8];
+#endif
+    }
+
+    // Remaining bits of the last byte
+    for (; bit < lenBits; bit++) {
+        crc = crc16nrf24Bit(crc, buf[bit >> 3], bit & 0x07);
     }
 
     return crc;
-}
\ No newline at end of file
+}
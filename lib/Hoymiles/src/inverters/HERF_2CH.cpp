@@ -4,8 +4,9 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "HERF_2CH.h"
+#include "../parser/StatisticsDecoder.h"
 
-static const byteAssign_t byteAssignment[] = {
+static constexpr byteAssign_t byteAssignment[] = {
     { TYPE_DC, CH0, FLD_UDC, UNIT_V, 2, 2, 10, false, 1 },
     { TYPE_DC, CH0, FLD_IDC, UNIT_A, 6, 2, 100, false, 2 },
     { TYPE_DC, CH0, FLD_PDC, UNIT_W, 10, 2, 10, false, 1 },
@@ -62,3 +63,8 @@ uint8_t HERF_2CH::getByteAssignmentSize() const
 {
     return sizeof(byteAssignment) / sizeof(byteAssignment[0]);
 }
+
+StatisticsDecoder_t HERF_2CH::getStatisticsDecoder() const
+{
+    return &StatisticsDecoder<byteAssignment, sizeof(byteAssignment) / sizeof(byteAssignment[0])>::decode;
+}
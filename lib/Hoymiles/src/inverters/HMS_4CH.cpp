@@ -3,8 +3,9 @@
  * Copyright (C) 2023-2024 Thomas Basler and others
  */
 #include "HMS_4CH.h"
+#include "../parser/StatisticsDecoder.h"
 
-static const byteAssign_t byteAssignment[] = {
+static constexpr byteAssign_t byteAssignment[] = {
     { TYPE_DC, CH0, FLD_UDC, UNIT_V, 2, 2, 10, false, 1 },
     { TYPE_DC, CH0, FLD_IDC, UNIT_A, 6, 2, 100, false, 2 },
     { TYPE_DC, CH0, FLD_PDC, UNIT_W, 10, 2, 10, false, 1 },
@@ -82,3 +83,8 @@ bool HMS_4CH::supportsPowerDistributionLogic()
     // will limit the AC output instead of limiting the DC inputs.
     return DevInfo()->getFwBuildVersion() >= 10112U;
 }
+
+StatisticsDecoder_t HMS_4CH::getStatisticsDecoder() const
+{
+    return &StatisticsDecoder<byteAssignment, sizeof(byteAssignment) / sizeof(byteAssignment[0])>::decode;
+}
@@ -10,5 +10,6 @@ public:
     String typeName() const;
     const byteAssign_t* getByteAssignment() const;
     uint8_t getByteAssignmentSize() const;
+    StatisticsDecoder_t getStatisticsDecoder() const;
     bool supportsPowerDistributionLogic() final;
 };
@@ -20,6 +20,11 @@ bool HMT_Abstract::sendChangeChannelRequest()
         return false;
     }
 
+    // Channel is derived from the CMT configuration (not available e.g. for the simulated radio)
+    if (!Hoymiles.getRadioCmt()->isInitialized()) {
+        return false;
+    }
+
     auto cmdChannel = _radio->prepareCommand<ChannelChangeCommand>(this);
     cmdChannel->setCountryMode(Hoymiles.getRadioCmt()->getCountryMode());
     cmdChannel->setChannel(Hoymiles.getRadioCmt()->getChannelFromFrequency(Hoymiles.getRadioCmt()->getInverterTargetFrequency()));
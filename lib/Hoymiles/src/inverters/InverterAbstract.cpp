@@ -4,13 +4,29 @@
  */
 #include "InverterAbstract.h"
 #include "crc.h"
+#include <algorithm>
 #include <cstring>
 #include <esp_log.h>
+#include <utility>
 
 #undef TAG
 static const char* TAG = "hoymiles";
 
+// Upper bucket limits of the radio histograms
+static const std::array<uint32_t, RADIO_RTT_BUCKETS - 1> rttLimits = { 50, 100, 200, 500, 1000, 2000, 5000 };
+static const std::array<uint8_t, RADIO_RETRANSMIT_BUCKETS - 1> retransmitLimits = { 0, 1, 2, 3, 5 };
+static const std::array<int8_t, RADIO_RSSI_BUCKETS - 1> rssiLimits = { -90, -80, -70, -60, -50, -40 };
+
+template <size_t... I>
+static std::array<RttHistogram_t, sizeof...(I)> createRttHistograms(std::index_sequence<I...>)
+{
+    return { { ((void)I, RttHistogram_t(rttLimits))... } };
+}
+
 InverterAbstract::InverterAbstract(HoymilesRadio* radio, const uint64_t serial)
+    : _rttHistogram(createRttHistograms(std::make_index_sequence<COMMAND_TYPE_CNT>()))
+    , _retransmitHistogram(retransmitLimits)
+    , _rssiHistogram(rssiLimits)
 {
     _serial.u64 = serial;
     _radio = radio;
@@ -35,7 +51,7 @@ void InverterAbstract::init()
     // Not possible in constructor --> virtual function
     // Not possible in verifyAllFragments --> Because no data if nothing is ever received
     // It has to be executed because otherwise the getChannelCount method in stats always returns 0
-    _statisticsParser.get()->setByteAssignment(getByteAssignment(), getByteAssignmentSize());
+    _statisticsParser.get()->setByteAssignment(getByteAssignment(), getByteAssignmentSize(), getStatisticsDecoder());
 }
 
 uint64_t InverterAbstract::serial() const
@@ -63,6 +79,11 @@ const char* InverterAbstract::name() const
     return _name;
 }
 
+StatisticsDecoder_t InverterAbstract::getStatisticsDecoder() const
+{
+    return nullptr;
+}
+
 bool InverterAbstract::isProducing()
 {
     float totalAc = 0;
@@ -191,11 +212,14 @@ void InverterAbstract::clearRxFragmentBuffer()
     _rxFragmentMaxPacketId = 0;
     _rxFragmentLastPacketId = 0;
     _rxFragmentRetransmitCnt = 0;
+    _rxFragmentTxTime = millis();
+    _rxFragmentRxTime = 0;
 }
 
 void InverterAbstract::addRxFragment(const uint8_t fragment[], const uint8_t len, const int8_t rssi)
 {
     _lastRssi = rssi;
+    _rssiHistogram.add(rssi);
 
     if (len < 11) {
         ESP_LOGE(TAG, "(%s, %d) fragment too short", __FILE__, __LINE__);
@@ -226,6 +250,7 @@ void InverterAbstract::addRxFragment(const uint8_t fragment[], const uint8_t len
     _rxFragmentBuffer[fragmentId - 1].len = len - 11;
     _rxFragmentBuffer[fragmentId - 1].mainCmd = fragment[0];
     _rxFragmentBuffer[fragmentId - 1].wasReceived = true;
+    _rxFragmentRxTime = millis();
 
     if (fragmentId > _rxFragmentLastPacketId) {
         _rxFragmentLastPacketId = fragmentId;
@@ -300,4 +325,34 @@ void InverterAbstract::performDailyTask()
 void InverterAbstract::resetRadioStats()
 {
     RadioStats = {};
+
+    for (auto& histogram : _rttHistogram) {
+        histogram.reset();
+    }
+    _retransmitHistogram.reset();
+    _rssiHistogram.reset();
+}
+
+void InverterAbstract::addRequestStats(const CommandAbstract& cmd, const bool success)
+{
+    if (success && _rxFragmentRxTime > 0) {
+        _rttHistogram[static_cast<size_t>(cmd.getCommandType())].add(_rxFragmentRxTime - _rxFragmentTxTime);
+    }
+    // The counter is also incremented by the attempt which exceeds the limit
+    _retransmitHistogram.add(std::min(_rxFragmentRetransmitCnt, cmd.getMaxRetransmitCount()));
+}
+
+const RttHistogram_t& InverterAbstract::getRttHistogram(const CommandType type) const
+{
+    return _rttHistogram[static_cast<size_t>(type)];
+}
+
+const RetransmitHistogram_t& InverterAbstract::getRetransmitHistogram() const
+{
+    return _retransmitHistogram;
+}
+
+const RssiHistogram_t& InverterAbstract::getRssiHistogram() const
+{
+    return _rssiHistogram;
 }
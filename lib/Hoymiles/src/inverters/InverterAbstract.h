@@ -8,6 +8,7 @@
 #include "../parser/PowerCommandParser.h"
 #include "../parser/StatisticsParser.h"
 #include "../parser/SystemConfigParaParser.h"
+#include "Histogram.h"
 #include "HoymilesRadio.h"
 #include "types.h"
 #include <Arduino.h>
@@ -16,6 +17,19 @@
 
 #define MAX_NAME_LENGTH 32
 
+#define RADIO_RTT_BUCKETS 8
+#define RADIO_RETRANSMIT_BUCKETS 6
+#define RADIO_RSSI_BUCKETS 7
+
+// Time in ms between sending a request and receiving the last fragment of a complete answer
+typedef Histogram<uint32_t, RADIO_RTT_BUCKETS> RttHistogram_t;
+
+// Number of fragment re-requests per request
+typedef Histogram<uint8_t, RADIO_RETRANSMIT_BUCKETS> RetransmitHistogram_t;
+
+// RSSI in dBm of every received fragment
+typedef Histogram<int8_t, RADIO_RSSI_BUCKETS> RssiHistogram_t;
+
 enum {
     FRAGMENT_ALL_MISSING_RESEND = 255,
     FRAGMENT_ALL_MISSING_TIMEOUT = 254,
@@ -39,6 +53,8 @@ public:
     virtual String typeName() const = 0;
     virtual const byteAssign_t* getByteAssignment() const = 0;
     virtual uint8_t getByteAssignmentSize() const = 0;
+    // Decoder specialized for the byte assignment, nullptr uses the generic one
+    virtual StatisticsDecoder_t getStatisticsDecoder() const;
 
     bool isProducing();
     bool isReachable();
@@ -67,6 +83,9 @@ public:
     void addRxFragment(const uint8_t fragment[], const uint8_t len, const int8_t rssi);
     uint8_t verifyAllFragments(CommandAbstract& cmd);
 
+    // Adds the round trip time (only if successful) and the retransmits of the current request to the histograms
+    void addRequestStats(const CommandAbstract& cmd, const bool success);
+
     void performDailyTask();
 
     void resetRadioStats();
@@ -91,6 +110,10 @@ public:
         uint32_t RxFailCorruptData;
     } RadioStats = {};
 
+    const RttHistogram_t& getRttHistogram(const CommandType type) const;
+    const RetransmitHistogram_t& getRetransmitHistogram() const;
+    const RssiHistogram_t& getRssiHistogram() const;
+
     virtual bool sendStatsRequest() = 0;
     virtual bool sendAlarmLogRequest(const bool force = false) = 0;
     virtual bool sendDevInfoRequest() = 0;
@@ -126,6 +149,8 @@ private:
     uint8_t _rxFragmentMaxPacketId = 0;
     uint8_t _rxFragmentLastPacketId = 0;
     uint8_t _rxFragmentRetransmitCnt = 0;
+    uint32_t _rxFragmentTxTime = 0;
+    uint32_t _rxFragmentRxTime = 0;
 
     bool _enablePolling = true;
     bool _enableCommands = true;
@@ -138,6 +163,10 @@ private:
 
     int8_t _lastRssi = -127;
 
+    std::array<RttHistogram_t, COMMAND_TYPE_CNT> _rttHistogram;
+    RetransmitHistogram_t _retransmitHistogram;
+    RssiHistogram_t _rssiHistogram;
+
     std::unique_ptr<AlarmLogParser> _alarmLogParser;
     std::unique_ptr<DevInfoParser> _devInfoParser;
     std::unique_ptr<GridProfileParser> _gridProfileParser;
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+#include "StatisticsParser.h"
+#include <cstddef>
+#include <utility>
+
+// Position of a field in a byte assignment (or FIELD_INDEX_NONE). First entry wins like in the parser.
+constexpr uint8_t findStatisticsField(const byteAssign_t* assignment, const uint8_t size,
+    const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    for (uint8_t i = 0; i < size; i++) {
+        if (assignment[i].type == type && assignment[i].ch == channel && assignment[i].fieldId == fieldId) {
+            return i;
+        }
+    }
+    return FIELD_INDEX_NONE;
+}
+
+// Decoder for one constant byte assignment. Position, size, sign and divisor
+// of every field as well as the calculation functions and their inputs are
+// resolved by the compiler, so decoding a payload is one straight-line pass
+// without any lookups. The results are identical to the generic decoder of
+// StatisticsParser which is still used for all other purposes.
+template <const byteAssign_t* Assignment, uint8_t Size>
+class StatisticsDecoder {
+    static_assert(Size <= STATISTIC_FIELD_MAX, "Byte assignment too large");
+
+public:
+    static void decode(StatisticsParser* parser, const uint8_t* payload, const float* offsets, const bool applyOffsets, float* values)
+    {
+        decodeFields(payload, offsets, applyOffsets, values, std::make_index_sequence<Size>());
+
+        // The calculated values are based on the decoded ones
+        calcFields(parser, values, std::make_index_sequence<Size>());
+    }
+
+private:
+    static constexpr uint8_t fieldIndex(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+    {
+        return findStatisticsField(Assignment, Size, type, channel, fieldId);
+    }
+
+    // True if the entry is the first one of its channel, gives the channel order of the parser
+    static constexpr bool isFirstOfChannel(const size_t index)
+    {
+        for (size_t i = 0; i < index; i++) {
+            if (Assignment[i].type == Assignment[index].type && Assignment[i].ch == Assignment[index].ch) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <size_t... I>
+    static void decodeFields(const uint8_t* payload, const float* offsets, const bool applyOffsets, float* values, std::index_sequence<I...>)
+    {
+        (decodeField<I>(payload, offsets, applyOffsets, values), ...);
+    }
+
+    template <size_t I>
+    static void decodeField(const uint8_t* payload, const float* offsets, const bool applyOffsets, float* values)
+    {
+        constexpr byteAssign_t field = Assignment[I];
+        if constexpr (field.div != CMD_CALC) {
+            static_assert(field.num >= 1 && field.num <= 4, "Field size not supported");
+            static_assert(field.start + field.num <= STATISTIC_PACKET_SIZE, "Field exceeds the statistics packet");
+
+            const uint32_t val = readValue<field.start>(payload, std::make_index_sequence<field.num>());
+
+            float result;
+            if constexpr (field.isSigned && field.num == 2) {
+                result = static_cast<float>(static_cast<int16_t>(val));
+            } else if constexpr (field.isSigned && field.num == 4) {
+                result = static_cast<float>(static_cast<int32_t>(val));
+            } else {
+                result = static_cast<float>(val);
+            }
+
+            result /= static_cast<float>(field.div);
+
+            if (applyOffsets) {
+                result += offsets[I];
+            }
+            values[I] = result;
+        }
+    }
+
+    template <uint8_t Start, size_t... I>
+    static uint32_t readValue(const uint8_t* payload, std::index_sequence<I...>)
+    {
+        // Big endian
+        return ((static_cast<uint32_t>(payload[Start + I]) << (8 * (sizeof...(I) - 1 - I))) | ...);
+    }
+
+    template <size_t... I>
+    static void calcFields(StatisticsParser* parser, float* values, std::index_sequence<I...>)
+    {
+        (calcField<I>(parser, values), ...);
+    }
+
+    template <size_t I>
+    static void calcField(StatisticsParser* parser, float* values)
+    {
+        constexpr byteAssign_t field = Assignment[I];
+        if constexpr (field.div == CMD_CALC) {
+            constexpr ChannelNum_t channel = static_cast<ChannelNum_t>(field.num);
+
+            if constexpr (field.start == CALC_TOTAL_YT) {
+                values[I] = sum<TYPE_DC, FLD_YT>(values);
+            } else if constexpr (field.start == CALC_TOTAL_YD) {
+                values[I] = sum<TYPE_DC, FLD_YD>(values);
+            } else if constexpr (field.start == CALC_CH_UDC) {
+                values[I] = value<TYPE_DC, channel, FLD_UDC>(values);
+            } else if constexpr (field.start == CALC_TOTAL_PDC) {
+                values[I] = sum<TYPE_DC, FLD_PDC>(values);
+            } else if constexpr (field.start == CALC_TOTAL_EFF) {
+                const float acPower = sum<TYPE_AC, FLD_PAC>(values);
+                const float dcPower = sum<TYPE_DC, FLD_PDC>(values);
+                values[I] = dcPower > 0 ? acPower / dcPower * 100.0f : 0.0f;
+            } else if constexpr (field.start == CALC_CH_IRR) {
+                const uint16_t maxPower = parser->getStringMaxPower(channel);
+                values[I] = maxPower > 0 ? value<TYPE_DC, channel, FLD_PDC>(values) / maxPower * 100.0f : 0.0f;
+            } else if constexpr (field.start == CALC_TOTAL_IAC) {
+                float acCurrent = 0;
+                acCurrent += value<TYPE_AC, CH0, FLD_IAC_1>(values);
+                acCurrent += value<TYPE_AC, CH0, FLD_IAC_2>(values);
+                acCurrent += value<TYPE_AC, CH0, FLD_IAC_3>(values);
+                values[I] = acCurrent;
+            } else {
+                static_assert(field.start <= CALC_TOTAL_IAC, "Unknown calculation function");
+            }
+        }
+    }
+
+    template <ChannelType_t Type, ChannelNum_t Channel, FieldId_t FieldId>
+    static float value(const float* values)
+    {
+        constexpr uint8_t index = fieldIndex(Type, Channel, FieldId);
+        if constexpr (index != FIELD_INDEX_NONE) {
+            return values[index];
+        } else {
+            return 0;
+        }
+    }
+
+    // Sum of a field over all channels of a type, in the same order as the parser adds them
+    template <ChannelType_t Type, FieldId_t FieldId>
+    static float sum(const float* values)
+    {
+        float result = 0;
+        addChannels<Type, FieldId>(result, values, std::make_index_sequence<Size>());
+        return result;
+    }
+
+    template <ChannelType_t Type, FieldId_t FieldId, size_t... I>
+    static void addChannels(float& result, const float* values, std::index_sequence<I...>)
+    {
+        (addChannel<Type, FieldId, I>(result, values), ...);
+    }
+
+    template <ChannelType_t Type, FieldId_t FieldId, size_t I>
+    static void addChannel(float& result, const float* values)
+    {
+        if constexpr (Assignment[I].type == Type && isFirstOfChannel(I)) {
+            constexpr uint8_t index = fieldIndex(Type, Assignment[I].ch, FieldId);
+            if constexpr (index != FIELD_INDEX_NONE) {
+                result += values[index];
+            }
+        }
+    }
+};
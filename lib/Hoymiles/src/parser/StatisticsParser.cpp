@@ -3,20 +3,21 @@
  * Copyright (C) 2022 - 2025 Thomas Basler and others
  */
 #include "StatisticsParser.h"
+#include <algorithm>
 #include <esp_log.h>
 
 #undef TAG
 static const char* TAG = "hoymiles";
 
-static float calcTotalYieldTotal(StatisticsParser* iv, uint8_t arg0);
-static float calcTotalYieldDay(StatisticsParser* iv, uint8_t arg0);
-static float calcChUdc(StatisticsParser* iv, uint8_t arg0);
-static float calcTotalPowerDc(StatisticsParser* iv, uint8_t arg0);
-static float calcTotalEffiency(StatisticsParser* iv, uint8_t arg0);
-static float calcChIrradiation(StatisticsParser* iv, uint8_t arg0);
-static float calcTotalCurrentAc(StatisticsParser* iv, uint8_t arg0);
+static float calcTotalYieldTotal(StatisticsParser* iv, const float* values, uint8_t arg0);
+static float calcTotalYieldDay(StatisticsParser* iv, const float* values, uint8_t arg0);
+static float calcChUdc(StatisticsParser* iv, const float* values, uint8_t arg0);
+static float calcTotalPowerDc(StatisticsParser* iv, const float* values, uint8_t arg0);
+static float calcTotalEffiency(StatisticsParser* iv, const float* values, uint8_t arg0);
+static float calcChIrradiation(StatisticsParser* iv, const float* values, uint8_t arg0);
+static float calcTotalCurrentAc(StatisticsParser* iv, const float* values, uint8_t arg0);
 
-using func_t = float(StatisticsParser*, uint8_t);
+using func_t = float(StatisticsParser*, const float*, uint8_t);
 
 struct calcFunc_t {
     uint8_t funcId; // unique id
@@ -62,20 +63,61 @@ const FieldId_t dailyProductionFields[] = {
 StatisticsParser::StatisticsParser()
     : Parser()
 {
+    memset(_fieldIndex, FIELD_INDEX_NONE, sizeof(_fieldIndex));
     clearBuffer();
 }
 
-void StatisticsParser::setByteAssignment(const byteAssign_t* byteAssignment, const uint8_t size)
+float StatisticsSnapshot::getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
+    if (_parser == nullptr) {
+        return 0;
+    }
+    return _parser->getSnapshotFieldValue(_values, type, channel, fieldId);
+}
+
+uint32_t StatisticsSnapshot::getGeneration() const
+{
+    return _generation;
+}
+
+void StatisticsParser::setByteAssignment(const byteAssign_t* byteAssignment, const uint8_t size, const StatisticsDecoder_t decoder)
+{
+    if (size > STATISTIC_FIELD_MAX) {
+        ESP_LOGE(TAG, "(%s, %d) byte assignment too large", __FILE__, __LINE__);
+        return;
+    }
+
     _byteAssignment = byteAssignment;
     _byteAssignmentSize = size;
+    _decoder = decoder;
+    _fieldOffset.assign(size, 0);
 
+    memset(_fieldIndex, FIELD_INDEX_NONE, sizeof(_fieldIndex));
+    memset(_channelCount, 0, sizeof(_channelCount));
     for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        const ChannelType_t type = _byteAssignment[i].type;
+        const ChannelNum_t ch = _byteAssignment[i].ch;
+
+        uint8_t& index = _fieldIndex[type][ch][_byteAssignment[i].fieldId];
+        if (index == FIELD_INDEX_NONE) {
+            // First entry wins if a field is assigned more than once
+            index = i;
+        }
+
+        ChannelNum_t* channelsEnd = _channels[type] + _channelCount[type];
+        if (std::find(_channels[type], channelsEnd, ch) == channelsEnd) {
+            _channels[type][_channelCount[type]++] = ch;
+        }
+
         if (_byteAssignment[i].div == CMD_CALC) {
             continue;
         }
         _expectedByteCount = max<uint8_t>(_expectedByteCount, _byteAssignment[i].start + _byteAssignment[i].num);
     }
+
+    _snapshot[0].assign(size, 0);
+    _snapshot[1].assign(size, 0);
+    updateSnapshot();
 }
 
 uint8_t StatisticsParser::getExpectedByteCount()
@@ -102,93 +144,101 @@ void StatisticsParser::appendFragment(const uint8_t offset, const uint8_t* paylo
 void StatisticsParser::endAppendFragment()
 {
     Parser::endAppendFragment();
+    updateSnapshot(true);
+}
 
-    if (!_enableYieldDayCorrection) {
-        resetYieldDayCorrection();
-        return;
-    }
+bool StatisticsParser::updateYieldDayCorrection(const float* values)
+{
+    bool changed = false;
 
     for (auto& c : getChannelsByType(TYPE_DC)) {
-        // check if current yield day is smaller then last cached yield day
-        if (getChannelFieldValue(TYPE_DC, c, FLD_YD) < _lastYieldDay[static_cast<uint8_t>(c)]) {
+        const uint8_t index = getFieldIndex(TYPE_DC, c, FLD_YD);
+        if (index == FIELD_INDEX_NONE) {
+            continue;
+        }
+
+        float& lastYieldDay = _lastYieldDay[static_cast<uint8_t>(c)];
+
+        if (!_enableYieldDayCorrection) {
+            changed |= _fieldOffset[index] != 0;
+            _fieldOffset[index] = 0;
+            lastYieldDay = 0;
+
+        } else if (values[index] < lastYieldDay) {
+            // check if current yield day is smaller then last cached yield day
             // currently all values are zero --> Add last known values to offset
             ESP_LOGI(TAG, "Yield Day reset detected!");
 
-            setChannelFieldOffset(TYPE_DC, c, FLD_YD, _lastYieldDay[static_cast<uint8_t>(c)]);
+            changed |= _fieldOffset[index] != lastYieldDay;
+            _fieldOffset[index] = lastYieldDay;
+            lastYieldDay = 0;
 
-            _lastYieldDay[static_cast<uint8_t>(c)] = 0;
         } else {
-            _lastYieldDay[static_cast<uint8_t>(c)] = getChannelFieldValue(TYPE_DC, c, FLD_YD);
+            lastYieldDay = values[index];
         }
     }
+
+    return changed;
 }
 
-const byteAssign_t* StatisticsParser::getAssignmentByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
+uint8_t StatisticsParser::getFieldIndex(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
-    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
-        if (_byteAssignment[i].type == type && _byteAssignment[i].ch == channel && _byteAssignment[i].fieldId == fieldId) {
-            return &_byteAssignment[i];
-        }
+    if (type >= TYPE_CNT || channel >= CH_CNT || fieldId >= FLD_CNT) {
+        return FIELD_INDEX_NONE;
     }
-    return nullptr;
+    return _fieldIndex[type][channel][fieldId];
 }
 
-fieldSettings_t* StatisticsParser::getSettingByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+const byteAssign_t* StatisticsParser::getAssignmentByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
-    for (auto& i : _fieldSettings) {
-        if (i.type == type && i.ch == channel && i.fieldId == fieldId) {
-            return &i;
-        }
+    const uint8_t index = getFieldIndex(type, channel, fieldId);
+    if (index == FIELD_INDEX_NONE) {
+        return nullptr;
     }
-    return nullptr;
+    return &_byteAssignment[index];
 }
 
 float StatisticsParser::getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
-    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
-    if (pos == nullptr) {
-        return 0;
-    }
-
-    uint8_t ptr = pos->start;
-    const uint8_t end = ptr + pos->num;
-    const uint16_t div = pos->div;
+    return getSnapshotFieldValue(_snapshot[_generation.load(std::memory_order_acquire) & 1].data(), type, channel, fieldId);
+}
 
-    if (CMD_CALC != div) {
-        // Value is a static value
-        uint32_t val = 0;
-        HOY_SEMAPHORE_TAKE();
-        do {
-            val <<= 8;
-            val |= _payloadStatistic[ptr];
-        } while (++ptr != end);
-        HOY_SEMAPHORE_GIVE();
+void StatisticsParser::getSnapshot(StatisticsSnapshot& snapshot) const
+{
+    snapshot._parser = this;
 
-        float result;
-        if (pos->isSigned && pos->num == 2) {
-            result = static_cast<float>(static_cast<int16_t>(val));
-        } else if (pos->isSigned && pos->num == 4) {
-            result = static_cast<float>(static_cast<int32_t>(val));
-        } else {
-            result = static_cast<float>(val);
-        }
+    // The writer fills the other buffer first. This one is only modified
+    // again after the next generation was published, so the copy is
+    // consistent if the generation did not change in the meantime.
+    uint32_t generation;
+    do {
+        generation = _generation.load(std::memory_order_acquire);
+        memcpy(snapshot._values, _snapshot[generation & 1].data(), _byteAssignmentSize * sizeof(float));
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (_generation.load(std::memory_order_relaxed) != generation);
 
-        result /= static_cast<float>(div);
+    snapshot._generation = generation;
+}
 
-        const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-        if (setting != nullptr && _statisticLength > 0) {
-            result += setting->offset;
-        }
-        return result;
-    } else {
-        // Value has to be calculated
-        return calcFunctions[pos->start].func(this, pos->num);
+float StatisticsParser::getSnapshotFieldValue(const float* values, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
+{
+    const uint8_t index = getFieldIndex(type, channel, fieldId);
+    if (index == FIELD_INDEX_NONE) {
+        return 0;
     }
-
-    return 0;
+    return values[index];
 }
 
 bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value)
+{
+    if (!writeFieldValue(type, channel, fieldId, value)) {
+        return false;
+    }
+    updateSnapshot();
+    return true;
+}
+
+bool StatisticsParser::writeFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value)
 {
     const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
     if (pos == nullptr) {
@@ -203,10 +253,7 @@ bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const Chan
         return false;
     }
 
-    const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-    if (setting != nullptr) {
-        value -= setting->offset;
-    }
+    value -= _fieldOffset[pos - _byteAssignment];
     value *= static_cast<float>(div);
 
     uint32_t val = 0;
@@ -228,6 +275,83 @@ bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const Chan
     return true;
 }
 
+void StatisticsParser::updateSnapshot(const bool newFrame)
+{
+    if (_byteAssignmentSize == 0) {
+        return;
+    }
+
+    // The semaphore serializes the writers and protects the payload. Readers don't need it.
+    HOY_SEMAPHORE_TAKE();
+
+    const uint32_t generation = _generation.load(std::memory_order_relaxed) + 1;
+    float* values = _snapshot[generation & 1].data();
+
+    decode(values);
+
+    // The correction is applied before the frame is published, so no
+    // consumer sees the values of a yield day reset without offset
+    if (newFrame && updateYieldDayCorrection(values)) {
+        decode(values);
+    }
+
+    _generation.store(generation, std::memory_order_release);
+
+    HOY_SEMAPHORE_GIVE();
+}
+
+void StatisticsParser::decode(float* values)
+{
+    if (_decoder != nullptr) {
+        _decoder(this, _payloadStatistic, _fieldOffset.data(), _statisticLength > 0, values);
+    } else {
+        decodeGeneric(values);
+    }
+}
+
+void StatisticsParser::decodeGeneric(float* values)
+{
+    // Decode all static values first as the calculated ones are based on them
+    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        const byteAssign_t* pos = &_byteAssignment[i];
+        if (CMD_CALC == pos->div) {
+            continue;
+        }
+
+        uint8_t ptr = pos->start;
+        const uint8_t end = ptr + pos->num;
+
+        uint32_t val = 0;
+        do {
+            val <<= 8;
+            val |= _payloadStatistic[ptr];
+        } while (++ptr != end);
+
+        float result;
+        if (pos->isSigned && pos->num == 2) {
+            result = static_cast<float>(static_cast<int16_t>(val));
+        } else if (pos->isSigned && pos->num == 4) {
+            result = static_cast<float>(static_cast<int32_t>(val));
+        } else {
+            result = static_cast<float>(val);
+        }
+
+        result /= static_cast<float>(pos->div);
+
+        if (_statisticLength > 0) {
+            result += _fieldOffset[i];
+        }
+        values[i] = result;
+    }
+
+    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        const byteAssign_t* pos = &_byteAssignment[i];
+        if (CMD_CALC == pos->div) {
+            values[i] = calcFunctions[pos->start].func(this, values, pos->num);
+        }
+    }
+}
+
 String StatisticsParser::getChannelFieldValueString(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
     return String(
@@ -261,30 +385,30 @@ uint8_t StatisticsParser::getChannelFieldDigits(const ChannelType_t type, const
 
 float StatisticsParser::getChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
-    const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-    if (setting != nullptr) {
-        return setting->offset;
+    const uint8_t index = getFieldIndex(type, channel, fieldId);
+    if (index != FIELD_INDEX_NONE) {
+        return _fieldOffset[index];
     }
     return 0;
 }
 
 void StatisticsParser::setChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const float offset)
 {
-    fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-    if (setting != nullptr) {
-        setting->offset = offset;
-    } else {
-        _fieldSettings.push_back({ type, channel, fieldId, offset });
+    const uint8_t index = getFieldIndex(type, channel, fieldId);
+    if (index != FIELD_INDEX_NONE && _fieldOffset[index] != offset) {
+        _fieldOffset[index] = offset;
+        updateSnapshot();
     }
 }
 
-std::list<ChannelType_t> StatisticsParser::getChannelTypes() const
+ChannelRange<ChannelType_t> StatisticsParser::getChannelTypes() const
 {
-    return {
+    static const ChannelType_t types[] = {
         TYPE_AC,
         TYPE_DC,
         TYPE_INV
     };
+    return ChannelRange<ChannelType_t>(types, sizeof(types) / sizeof(types[0]));
 }
 
 const char* StatisticsParser::getChannelTypeName(const ChannelType_t type) const
@@ -292,16 +416,12 @@ const char* StatisticsParser::getChannelTypeName(const ChannelType_t type) const
     return channelsTypes[type];
 }
 
-std::list<ChannelNum_t> StatisticsParser::getChannelsByType(const ChannelType_t type) const
+ChannelRange<ChannelNum_t> StatisticsParser::getChannelsByType(const ChannelType_t type) const
 {
-    std::list<ChannelNum_t> l;
-    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
-        if (_byteAssignment[i].type == type) {
-            l.push_back(_byteAssignment[i].ch);
-        }
+    if (type >= TYPE_CNT) {
+        return ChannelRange<ChannelNum_t>(nullptr, 0);
     }
-    l.unique();
-    return l;
+    return ChannelRange<ChannelNum_t>(_channels[type], _channelCount[type]);
 }
 
 uint16_t StatisticsParser::getStringMaxPower(const uint8_t channel) const
@@ -313,6 +433,7 @@ void StatisticsParser::setStringMaxPower(const uint8_t channel, const uint16_t p
 {
     if (channel < sizeof(_stringMaxPower) / sizeof(_stringMaxPower[0])) {
         _stringMaxPower[channel] = power;
+        updateSnapshot();
     }
 }
 
@@ -347,6 +468,11 @@ void StatisticsParser::setLastUpdate(const uint32_t lastUpdate)
     setLastUpdateFromInternal(lastUpdate);
 }
 
+uint32_t StatisticsParser::getGeneration() const
+{
+    return _generation.load(std::memory_order_acquire);
+}
+
 uint32_t StatisticsParser::getLastUpdateFromInternal() const
 {
     return _lastUpdateFromInternal;
@@ -374,11 +500,12 @@ void StatisticsParser::zeroFields(const FieldId_t* fields)
         for (auto& c : getChannelsByType(t)) {
             for (uint8_t i = 0; i < (sizeof(runtimeFields) / sizeof(runtimeFields[0])); i++) {
                 if (hasChannelFieldValue(t, c, fields[i])) {
-                    setChannelFieldValue(t, c, fields[i], 0);
+                    writeFieldValue(t, c, fields[i], 0);
                 }
             }
         }
     }
+    updateSnapshot();
     setLastUpdateFromInternal(millis());
 }
 
@@ -391,49 +518,49 @@ void StatisticsParser::resetYieldDayCorrection()
     }
 }
 
-static float calcTotalYieldTotal(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalYieldTotal(StatisticsParser* iv, const float* values, uint8_t arg0)
 {
     float yield = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_DC)) {
-        yield += iv->getChannelFieldValue(TYPE_DC, channel, FLD_YT);
+        yield += iv->getSnapshotFieldValue(values, TYPE_DC, channel, FLD_YT);
     }
     return yield;
 }
 
-static float calcTotalYieldDay(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalYieldDay(StatisticsParser* iv, const float* values, uint8_t arg0)
 {
     float yield = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_DC)) {
-        yield += iv->getChannelFieldValue(TYPE_DC, channel, FLD_YD);
+        yield += iv->getSnapshotFieldValue(values, TYPE_DC, channel, FLD_YD);
     }
     return yield;
 }
 
 // arg0 = channel of source
-static float calcChUdc(StatisticsParser* iv, uint8_t arg0)
+static float calcChUdc(StatisticsParser* iv, const float* values, uint8_t arg0)
 {
-    return iv->getChannelFieldValue(TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_UDC);
+    return iv->getSnapshotFieldValue(values, TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_UDC);
 }
 
-static float calcTotalPowerDc(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalPowerDc(StatisticsParser* iv, const float* values, uint8_t arg0)
 {
     float dcPower = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_DC)) {
-        dcPower += iv->getChannelFieldValue(TYPE_DC, channel, FLD_PDC);
+        dcPower += iv->getSnapshotFieldValue(values, TYPE_DC, channel, FLD_PDC);
     }
     return dcPower;
 }
 
-static float calcTotalEffiency(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalEffiency(StatisticsParser* iv, const float* values, uint8_t arg0)
 {
     float acPower = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_AC)) {
-        acPower += iv->getChannelFieldValue(TYPE_AC, channel, FLD_PAC);
+        acPower += iv->getSnapshotFieldValue(values, TYPE_AC, channel, FLD_PAC);
     }
 
     float dcPower = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_DC)) {
-        dcPower += iv->getChannelFieldValue(TYPE_DC, channel, FLD_PDC);
+        dcPower += iv->getSnapshotFieldValue(values, TYPE_DC, channel, FLD_PDC);
     }
 
     if (dcPower > 0) {
@@ -443,20 +570,20 @@ static float calcTotalEffiency(StatisticsParser* iv, uint8_t arg0)
 }
 
 // arg0 = channel
-static float calcChIrradiation(StatisticsParser* iv, uint8_t arg0)
+static float calcChIrradiation(StatisticsParser* iv, const float* values, uint8_t arg0)
 {
     if (nullptr != iv) {
         if (iv->getStringMaxPower(arg0) > 0)
-            return iv->getChannelFieldValue(TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_PDC) / iv->getStringMaxPower(arg0) * 100.0f;
+            return iv->getSnapshotFieldValue(values, TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_PDC) / iv->getStringMaxPower(arg0) * 100.0f;
     }
     return 0.0;
 }
 
-static float calcTotalCurrentAc(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalCurrentAc(StatisticsParser* iv, const float* values, uint8_t arg0)
 {
     float acCurrent = 0;
-    acCurrent += iv->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_1);
-    acCurrent += iv->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_2);
-    acCurrent += iv->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_3);
+    acCurrent += iv->getSnapshotFieldValue(values, TYPE_AC, CH0, FLD_IAC_1);
+    acCurrent += iv->getSnapshotFieldValue(values, TYPE_AC, CH0, FLD_IAC_2);
+    acCurrent += iv->getSnapshotFieldValue(values, TYPE_AC, CH0, FLD_IAC_3);
     return acCurrent;
 }
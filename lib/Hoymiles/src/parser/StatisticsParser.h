@@ -1,11 +1,15 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 #include "Parser.h"
+#include <atomic>
 #include <cstdint>
-#include <list>
+#include <vector>
 
 #define STATISTIC_PACKET_SIZE (7 * 16)
 
+// Maximum number of entries of a byte assignment (including calculated fields)
+#define STATISTIC_FIELD_MAX 64
+
 // units
 enum UnitId_t {
     UNIT_V = 0,
@@ -47,7 +51,8 @@ enum FieldId_t {
     FLD_UAC_31,
     FLD_IAC_1,
     FLD_IAC_2,
-    FLD_IAC_3
+    FLD_IAC_3,
+    FLD_CNT
 };
 const char* const fields[] = { "Voltage", "Current", "Power", "YieldDay", "YieldTotal",
     "Voltage", "Current", "Power", "Frequency", "Temperature", "PowerFactor", "Efficiency", "Irradiation", "ReactivePower", "EventLogCount",
@@ -79,7 +84,8 @@ enum ChannelNum_t {
 enum ChannelType_t {
     TYPE_AC = 0,
     TYPE_DC,
-    TYPE_INV
+    TYPE_INV,
+    TYPE_CNT
 };
 const char* const channelsTypes[] = { "AC", "DC", "INV" };
 
@@ -95,12 +101,50 @@ typedef struct {
     uint8_t digits; // number of valid digits after the decimal point
 } byteAssign_t;
 
-typedef struct {
-    ChannelType_t type;
-    ChannelNum_t ch; // channel 0 - 5
-    FieldId_t fieldId; // field id
-    float offset; // offset (positive/negative) to be applied on the fetched value
-} fieldSettings_t;
+// marks a field which is not part of the byte assignment
+#define FIELD_INDEX_NONE 0xff
+
+// Read only view of an array which is owned by the parser. It can be used
+// in range based for loops like a container but does not allocate memory.
+template <typename T>
+class ChannelRange {
+public:
+    ChannelRange(const T* data, const uint8_t size)
+        : _data(data)
+        , _size(size)
+    {
+    }
+
+    const T* begin() const { return _data; }
+    const T* end() const { return _data + _size; }
+    uint8_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+private:
+    const T* _data;
+    uint8_t _size;
+};
+
+class StatisticsParser;
+
+// Copy of all field values of one decoded frame. Consumers which combine
+// several fields read them from a snapshot, otherwise a new frame could be
+// published between two reads.
+class StatisticsSnapshot {
+public:
+    float getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
+    uint32_t getGeneration() const;
+
+private:
+    friend class StatisticsParser;
+
+    const StatisticsParser* _parser = nullptr;
+    uint32_t _generation = 0;
+    float _values[STATISTIC_FIELD_MAX];
+};
+
+// Decodes a complete statistics payload into the field values, same order as the byte assignment
+typedef void (*StatisticsDecoder_t)(StatisticsParser* parser, const uint8_t* payload, const float* offsets, const bool applyOffsets, float* values);
 
 class StatisticsParser : public Parser {
 public:
@@ -109,15 +153,19 @@ public:
     void appendFragment(const uint8_t offset, const uint8_t* payload, const uint8_t len);
     void endAppendFragment();
 
-    void setByteAssignment(const byteAssign_t* byteAssignment, const uint8_t size);
+    // The decoder is optional, the generic one interprets the byte assignment at runtime
+    void setByteAssignment(const byteAssign_t* byteAssignment, const uint8_t size, const StatisticsDecoder_t decoder = nullptr);
 
     // Returns 1 based amount of expected bytes of statistic data
     uint8_t getExpectedByteCount();
 
     const byteAssign_t* getAssignmentByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
-    fieldSettings_t* getSettingByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
 
+    // Value of the latest frame. Use getSnapshot() to read several values of the same frame.
     float getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+    void getSnapshot(StatisticsSnapshot& snapshot) const;
+    // Used by the calculation functions to read from a snapshot which is currently built
+    float getSnapshotFieldValue(const float* values, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
     String getChannelFieldValueString(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
     bool hasChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
     const char* getChannelFieldUnit(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
@@ -129,9 +177,9 @@ public:
     float getChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
     void setChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const float offset);
 
-    std::list<ChannelType_t> getChannelTypes() const;
+    ChannelRange<ChannelType_t> getChannelTypes() const;
     const char* getChannelTypeName(const ChannelType_t type) const;
-    std::list<ChannelNum_t> getChannelsByType(const ChannelType_t type) const;
+    ChannelRange<ChannelNum_t> getChannelsByType(const ChannelType_t type) const;
 
     uint16_t getStringMaxPower(const uint8_t channel) const;
     void setStringMaxPower(const uint8_t channel, const uint16_t power);
@@ -147,6 +195,9 @@ public:
     // Update time when new data from the inverter is received
     void setLastUpdate(const uint32_t lastUpdate);
 
+    // Incremented every time a new snapshot of all field values is published
+    uint32_t getGeneration() const;
+
     // Update time when internal data structure changes (from inverter and by internal manipulation)
     uint32_t getLastUpdateFromInternal() const;
     void setLastUpdateFromInternal(const uint32_t lastUpdate);
@@ -156,15 +207,37 @@ public:
 
 private:
     void zeroFields(const FieldId_t* fields);
+    bool writeFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value);
+    void updateSnapshot(const bool newFrame = false);
+    void decode(float* values);
+    void decodeGeneric(float* values);
+    // Adjusts the yield day offsets to the decoded values, returns true if an offset changed
+    bool updateYieldDayCorrection(const float* values);
+    uint8_t getFieldIndex(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
 
     uint8_t _payloadStatistic[STATISTIC_PACKET_SIZE] = {};
     uint8_t _statisticLength = 0;
     uint16_t _stringMaxPower[CH_CNT];
 
-    const byteAssign_t* _byteAssignment;
-    uint8_t _byteAssignmentSize;
+    const byteAssign_t* _byteAssignment = nullptr;
+    uint8_t _byteAssignmentSize = 0;
+    StatisticsDecoder_t _decoder = nullptr;
     uint8_t _expectedByteCount = 0;
-    std::list<fieldSettings_t> _fieldSettings;
+
+    // Position of each field in _byteAssignment (or FIELD_INDEX_NONE)
+    uint8_t _fieldIndex[TYPE_CNT][CH_CNT][FLD_CNT];
+
+    // Channels of every type in the order of the byte assignment
+    ChannelNum_t _channels[TYPE_CNT][CH_CNT];
+    uint8_t _channelCount[TYPE_CNT] = {};
+
+    // Offset (positive/negative) to be applied on the fetched value. Same order as _byteAssignment
+    std::vector<float> _fieldOffset;
+
+    // All field values (including calculated ones) decoded once per update. Same order as _byteAssignment.
+    // Readers use the buffer selected by the lowest bit of _generation, the other one is written.
+    std::vector<float> _snapshot[2];
+    std::atomic<uint32_t> _generation = { 0 };
 
     uint32_t _rxFailureCount = 0;
     uint32_t _lastUpdateFromInternal = 0;
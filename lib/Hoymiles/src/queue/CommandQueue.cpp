@@ -6,6 +6,27 @@
 #include "../inverters/InverterAbstract.h"
 #include <algorithm>
 
+void CommandQueue::push(const std::shared_ptr<CommandAbstract>& cmd)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto pos = _queue.end();
+    while (pos - _queue.begin() > 1) {
+        const auto& prev = *(pos - 1);
+        if (prev->getPriority() <= cmd->getPriority()
+            || prev->getBypassCount() >= COMMAND_QUEUE_MAX_BYPASS) {
+            break;
+        }
+        pos--;
+    }
+
+    for (auto it = pos; it != _queue.end(); ++it) {
+        (*it)->incrementBypassCount();
+    }
+
+    _queue.insert(pos, cmd);
+}
+
 void CommandQueue::removeAllEntriesForInverter(InverterAbstract* inv)
 {
     std::lock_guard<std::mutex> lock(_mutex);
@@ -5,10 +5,18 @@
 #include <ThreadSafeQueue.h>
 #include <memory>
 
+// Maximum number of commands with a higher priority which can be inserted in
+// front of a command. Afterwards it keeps its position to avoid starvation.
+#define COMMAND_QUEUE_MAX_BYPASS 4
+
 class InverterAbstract;
 
 class CommandQueue : public ThreadSafeQueue<std::shared_ptr<CommandAbstract>> {
 public:
+    // Inserts the command behind all commands with the same or a higher priority.
+    // The first entry is never bypassed as it is currently processed by the radio.
+    void push(const std::shared_ptr<CommandAbstract>& cmd);
+
     void removeAllEntriesForInverter(InverterAbstract* inv);
     void removeDuplicatedEntries(std::shared_ptr<CommandAbstract> cmd);
     void replaceEntries(std::shared_ptr<CommandAbstract> cmd);
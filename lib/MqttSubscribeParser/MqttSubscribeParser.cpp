@@ -3,6 +3,7 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "MqttSubscribeParser.h"
+#include <cstring>
 
 void MqttSubscribeParser::register_callback(const std::string& topic, uint8_t qos, const OnMessageCallback& cb)
 {
@@ -11,6 +12,31 @@ void MqttSubscribeParser::register_callback(const std::string& topic, uint8_t qo
     cbf.qos = qos;
     cbf.cb = cb;
     _callbacks.push_back(cbf);
+
+    // Invalid subscriptions never match any message
+    if (!is_valid_subscription(topic)) {
+        return;
+    }
+
+    topic_node_t* node = &_root;
+    size_t start = 0;
+    while (true) {
+        const size_t end = topic.find('/', start);
+        const std::string level = topic.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+        auto& child = node->children[level];
+        if (child == nullptr) {
+            child = std::make_unique<topic_node_t>();
+        }
+        node = child.get();
+
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+
+    node->callbacks.push_back(cb);
 }
 
 void MqttSubscribeParser::unregister_callback(const std::string& topic)
@@ -22,150 +48,110 @@ void MqttSubscribeParser::unregister_callback(const std::string& topic)
             ++it;
         }
     }
+
+    remove(_root, topic);
 }
 
-void MqttSubscribeParser::handle_message(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)
+bool MqttSubscribeParser::remove(topic_node_t& node, std::string_view topic)
 {
-    bool result = false;
-    for (const auto& cb : _callbacks) {
-        if (mosquitto_topic_matches_sub(cb.topic.c_str(), topic, &result) == MOSQ_ERR_SUCCESS) {
-            if (result) {
-                cb.cb(properties, topic, payload, len);
-            }
+    const size_t end = topic.find('/');
+    const std::string_view level = topic.substr(0, end);
+
+    auto child = node.children.find(level);
+    if (child != node.children.end()) {
+        bool empty;
+        if (end == std::string_view::npos) {
+            child->second->callbacks.clear();
+            empty = child->second->children.empty();
+        } else {
+            empty = remove(*child->second, topic.substr(end + 1));
+        }
+
+        if (empty) {
+            node.children.erase(child);
         }
     }
+
+    return node.children.empty() && node.callbacks.empty();
 }
 
-std::vector<cb_filter_t> MqttSubscribeParser::get_callbacks()
+void MqttSubscribeParser::handle_message(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)
 {
-    return _callbacks;
+    // Wildcards are not allowed in the topic of a message
+    if (topic == nullptr || topic[0] == 0 || strpbrk(topic, "+#") != nullptr) {
+        return;
+    }
+
+    dispatch(_root, topic, true, properties, topic, payload, len);
 }
 
-/* Does a topic match a subscription? */
-int MqttSubscribeParser::mosquitto_topic_matches_sub(const char* sub, const char* topic, bool* result)
+void MqttSubscribeParser::dispatch(const topic_node_t& node, const char* level, const bool first_level,
+    const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len) const
 {
-    size_t spos;
+    // Topics starting with '$' are not matched by wildcards at the first level
+    const bool wildcards = !(first_level && topic[0] == '$');
+
+    // '#' also matches the parent level, e.g. "foo/#" matches "foo"
+    if (wildcards) {
+        auto multi = node.children.find(std::string_view("#"));
+        if (multi != node.children.end()) {
+            for (const auto& cb : multi->second->callbacks) {
+                cb(properties, topic, payload, len);
+            }
+        }
+    }
+
+    if (level == nullptr) {
+        for (const auto& cb : node.callbacks) {
+            cb(properties, topic, payload, len);
+        }
+        return;
+    }
 
-    if (!result)
-        return MOSQ_ERR_INVAL;
-    *result = false;
+    const char* end = strchr(level, '/');
+    const std::string_view name(level, end == nullptr ? strlen(level) : end - level);
+    const char* next = end == nullptr ? nullptr : end + 1;
 
-    if (!sub || !topic || sub[0] == 0 || topic[0] == 0) {
-        return MOSQ_ERR_INVAL;
+    auto exact = node.children.find(name);
+    if (exact != node.children.end()) {
+        dispatch(*exact->second, next, false, properties, topic, payload, len);
     }
 
-    if ((sub[0] == '$' && topic[0] != '$')
-        || (topic[0] == '$' && sub[0] != '$')) {
+    if (wildcards) {
+        auto single = node.children.find(std::string_view("+"));
+        if (single != node.children.end()) {
+            dispatch(*single->second, next, false, properties, topic, payload, len);
+        }
+    }
+}
 
-        return MOSQ_ERR_SUCCESS;
+std::vector<cb_filter_t> MqttSubscribeParser::get_callbacks()
+{
+    return _callbacks;
+}
+
+bool MqttSubscribeParser::is_valid_subscription(const std::string& topic)
+{
+    if (topic.empty()) {
+        return false;
     }
 
-    spos = 0;
+    size_t start = 0;
+    while (true) {
+        const size_t end = topic.find('/', start);
+        const std::string level = topic.substr(start, end == std::string::npos ? std::string::npos : end - start);
 
-    while (sub[0] != 0) {
-        if (topic[0] == '+' || topic[0] == '#') {
-            return MOSQ_ERR_INVAL;
+        // Wildcards have to occupy a whole level, '#' has to be the last one
+        if (level.find_first_of("+#") != std::string::npos && level.size() != 1) {
+            return false;
         }
-        if (sub[0] != topic[0] || topic[0] == 0) { /* Check for wildcard matches */
-            if (sub[0] == '+') {
-                /* Check for bad "+foo" or "a/+foo" subscription */
-                if (spos > 0 && sub[-1] != '/') {
-                    return MOSQ_ERR_INVAL;
-                }
-                /* Check for bad "foo+" or "foo+/a" subscription */
-                if (sub[1] != 0 && sub[1] != '/') {
-                    return MOSQ_ERR_INVAL;
-                }
-                spos++;
-                sub++;
-                while (topic[0] != 0 && topic[0] != '/') {
-                    if (topic[0] == '+' || topic[0] == '#') {
-                        return MOSQ_ERR_INVAL;
-                    }
-                    topic++;
-                }
-                if (topic[0] == 0 && sub[0] == 0) {
-                    *result = true;
-                    return MOSQ_ERR_SUCCESS;
-                }
-            } else if (sub[0] == '#') {
-                /* Check for bad "foo#" subscription */
-                if (spos > 0 && sub[-1] != '/') {
-                    return MOSQ_ERR_INVAL;
-                }
-                /* Check for # not the final character of the sub, e.g. "#foo" */
-                if (sub[1] != 0) {
-                    return MOSQ_ERR_INVAL;
-                } else {
-                    while (topic[0] != 0) {
-                        if (topic[0] == '+' || topic[0] == '#') {
-                            return MOSQ_ERR_INVAL;
-                        }
-                        topic++;
-                    }
-                    *result = true;
-                    return MOSQ_ERR_SUCCESS;
-                }
-            } else {
-                /* Check for e.g. foo/bar matching foo/+/# */
-                if (topic[0] == 0
-                    && spos > 0
-                    && sub[-1] == '+'
-                    && sub[0] == '/'
-                    && sub[1] == '#') {
-                    *result = true;
-                    return MOSQ_ERR_SUCCESS;
-                }
-
-                /* There is no match at this point, but is the sub invalid? */
-                while (sub[0] != 0) {
-                    if (sub[0] == '#' && sub[1] != 0) {
-                        return MOSQ_ERR_INVAL;
-                    }
-                    spos++;
-                    sub++;
-                }
-
-                /* Valid input, but no match */
-                return MOSQ_ERR_SUCCESS;
-            }
-        } else {
-            /* sub[spos] == topic[tpos] */
-            if (topic[1] == 0) {
-                /* Check for e.g. foo matching foo/# */
-                if (sub[1] == '/'
-                    && sub[2] == '#'
-                    && sub[3] == 0) {
-                    *result = true;
-                    return MOSQ_ERR_SUCCESS;
-                }
-            }
-            spos++;
-            sub++;
-            topic++;
-            if (sub[0] == 0 && topic[0] == 0) {
-                *result = true;
-                return MOSQ_ERR_SUCCESS;
-            } else if (topic[0] == 0 && sub[0] == '+' && sub[1] == 0) {
-                if (spos > 0 && sub[-1] != '/') {
-                    return MOSQ_ERR_INVAL;
-                }
-                spos++;
-                sub++;
-                *result = true;
-                return MOSQ_ERR_SUCCESS;
-            }
+        if (level == "#" && end != std::string::npos) {
+            return false;
         }
-    }
-    if ((topic[0] != 0 || sub[0] != 0)) {
-        *result = false;
-    }
-    while (topic[0] != 0) {
-        if (topic[0] == '+' || topic[0] == '#') {
-            return MOSQ_ERR_INVAL;
+
+        if (end == std::string::npos) {
+            return true;
         }
-        topic++;
+        start = end + 1;
     }
-
-    return MOSQ_ERR_SUCCESS;
 }
@@ -3,7 +3,11 @@
 
 #include <cstdint>
 #include <espMqttClient.h>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 typedef std::function<void(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)> OnMessageCallback;
@@ -22,12 +26,22 @@ public:
     std::vector<cb_filter_t> get_callbacks();
 
 private:
-    int mosquitto_topic_matches_sub(const char* sub, const char* topic, bool* result);
+    // One level of the subscribed topics. The wildcards '+' and '#' are
+    // stored as regular children, therefore a message is dispatched by
+    // visiting at most the literal and the '+' child of every level.
+    struct topic_node_t {
+        std::map<std::string, std::unique_ptr<topic_node_t>, std::less<>> children;
+        std::vector<OnMessageCallback> callbacks;
+    };
 
-    std::vector<cb_filter_t> _callbacks;
+    static bool is_valid_subscription(const std::string& topic);
 
-    enum mosq_err_t {
-        MOSQ_ERR_SUCCESS = 0,
-        MOSQ_ERR_INVAL = 3,
-    };
+    void dispatch(const topic_node_t& node, const char* level, const bool first_level,
+        const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len) const;
+
+    // Removes the callbacks of the topic below the node, returns true if the node became empty
+    static bool remove(topic_node_t& node, std::string_view topic);
+
+    std::vector<cb_filter_t> _callbacks;
+    topic_node_t _root;
 };
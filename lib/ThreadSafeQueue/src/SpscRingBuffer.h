@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed size ring buffer for exactly one producer and one consumer.
+// push() must only be called by the producer, front()/pop() only by the
+// consumer. Neither side allocates memory or takes a lock, therefore the
+// producer can also be an interrupt handler.
+template <typename T, size_t N>
+class SpscRingBuffer {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Capacity has to be a power of two");
+
+public:
+    SpscRingBuffer() = default;
+    SpscRingBuffer(const SpscRingBuffer<T, N>&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer<T, N>&) = delete;
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    bool full() const
+    {
+        return size() >= N;
+    }
+
+    // Producer: Returns false if the buffer is full and the item was dropped
+    bool push(const T& item)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            return false;
+        }
+        _buffer[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: Oldest item, only valid if the buffer is not empty
+    const T& front() const
+    {
+        return _buffer[_tail.load(std::memory_order_relaxed) & (N - 1)];
+    }
+
+    // Consumer: Returns false if the buffer is empty
+    bool pop(T& item)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_acquire) == tail) {
+            return false;
+        }
+        item = _buffer[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: Removes the oldest item
+    void pop()
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_acquire) != tail) {
+            _tail.store(tail + 1, std::memory_order_release);
+        }
+    }
+
+private:
+    std::array<T, N> _buffer = {};
+
+    // Free running counters, only the producer writes _head and only the consumer writes _tail
+    std::atomic<size_t> _head = { 0 };
+    std::atomic<size_t> _tail = { 0 };
+};
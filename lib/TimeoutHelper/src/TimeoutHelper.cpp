@@ -31,3 +31,9 @@ bool TimeoutHelper::occured() const
 {
     return millis() - startMillis > timeout;
 }
+
+uint32_t TimeoutHelper::remaining() const
+{
+    const uint32_t elapsed = millis() - startMillis;
+    return elapsed > timeout ? 0 : timeout - elapsed + 1;
+}
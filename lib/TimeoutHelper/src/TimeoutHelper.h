@@ -10,6 +10,7 @@ public:
     void extend(const uint32_t ms);
     void reset();
     bool occured() const;
+    uint32_t remaining() const;
 
 private:
     uint32_t startMillis;
@@ -87,6 +87,13 @@ bool ConfigurationClass::write()
     mqtt["retain"] = config.Mqtt.Retain;
     mqtt["publish_interval"] = config.Mqtt.PublishInterval;
     mqtt["clean_session"] = config.Mqtt.CleanSession;
+    mqtt["payload_mode"] = config.Mqtt.PayloadMode;
+
+    JsonObject mqtt_onchange = mqtt["onchange"].to<JsonObject>();
+    mqtt_onchange["enabled"] = config.Mqtt.OnChange.Enabled;
+    mqtt_onchange["max_age"] = config.Mqtt.OnChange.MaxAge;
+    mqtt_onchange["deadband"] = config.Mqtt.OnChange.Deadband;
+    mqtt_onchange["deadband_absolute"] = config.Mqtt.OnChange.DeadbandAbsolute;
 
     JsonObject mqtt_lwt = mqtt["lwt"].to<JsonObject>();
     mqtt_lwt["topic"] = config.Mqtt.Lwt.Topic;
@@ -111,11 +118,18 @@ bool ConfigurationClass::write()
     JsonObject dtu = doc["dtu"].to<JsonObject>();
     dtu["serial"] = config.Dtu.Serial;
     dtu["poll_interval"] = config.Dtu.PollInterval;
+    dtu["adaptive_poll"] = config.Dtu.AdaptivePoll.Enabled;
+    dtu["poll_interval_min"] = config.Dtu.AdaptivePoll.MinInterval;
+    dtu["poll_interval_max"] = config.Dtu.AdaptivePoll.MaxInterval;
     dtu["nrf_pa_level"] = config.Dtu.Nrf.PaLevel;
     dtu["cmt_pa_level"] = config.Dtu.Cmt.PaLevel;
     dtu["cmt_frequency"] = config.Dtu.Cmt.Frequency;
     dtu["cmt_country_mode"] = config.Dtu.Cmt.CountryMode;
 
+    JsonObject history = doc["history"].to<JsonObject>();
+    history["enabled"] = config.History.Enabled;
+    history["interval"] = config.History.Interval;
+
     JsonObject security = doc["security"].to<JsonObject>();
     security["password"] = config.Security.Password;
     security["allow_readonly"] = config.Security.AllowReadonly;
@@ -282,6 +296,13 @@ bool ConfigurationClass::read()
     config.Mqtt.Retain = mqtt["retain"] | MQTT_RETAIN;
     config.Mqtt.PublishInterval = mqtt["publish_interval"] | MQTT_PUBLISH_INTERVAL;
     config.Mqtt.CleanSession = mqtt["clean_session"] | MQTT_CLEAN_SESSION;
+    config.Mqtt.PayloadMode = mqtt["payload_mode"] | MQTT_PAYLOAD_MODE;
+
+    JsonObject mqtt_onchange = mqtt["onchange"];
+    config.Mqtt.OnChange.Enabled = mqtt_onchange["enabled"] | MQTT_ONCHANGE_ENABLED;
+    config.Mqtt.OnChange.MaxAge = mqtt_onchange["max_age"] | MQTT_ONCHANGE_MAX_AGE;
+    config.Mqtt.OnChange.Deadband = mqtt_onchange["deadband"] | MQTT_ONCHANGE_DEADBAND;
+    config.Mqtt.OnChange.DeadbandAbsolute = mqtt_onchange["deadband_absolute"] | MQTT_ONCHANGE_DEADBAND_ABSOLUTE;
 
     JsonObject mqtt_lwt = mqtt["lwt"];
     strlcpy(config.Mqtt.Lwt.Topic, mqtt_lwt["topic"] | MQTT_LWT_TOPIC, sizeof(config.Mqtt.Lwt.Topic));
@@ -306,11 +327,18 @@ bool ConfigurationClass::read()
     JsonObject dtu = doc["dtu"];
     config.Dtu.Serial = dtu["serial"] | DTU_SERIAL;
     config.Dtu.PollInterval = dtu["poll_interval"] | DTU_POLL_INTERVAL;
+    config.Dtu.AdaptivePoll.Enabled = dtu["adaptive_poll"] | DTU_ADAPTIVE_POLL;
+    config.Dtu.AdaptivePoll.MinInterval = dtu["poll_interval_min"] | DTU_POLL_INTERVAL_MIN;
+    config.Dtu.AdaptivePoll.MaxInterval = dtu["poll_interval_max"] | DTU_POLL_INTERVAL_MAX;
     config.Dtu.Nrf.PaLevel = dtu["nrf_pa_level"] | DTU_NRF_PA_LEVEL;
     config.Dtu.Cmt.PaLevel = dtu["cmt_pa_level"] | DTU_CMT_PA_LEVEL;
     config.Dtu.Cmt.Frequency = dtu["cmt_frequency"] | DTU_CMT_FREQUENCY;
     config.Dtu.Cmt.CountryMode = dtu["cmt_country_mode"] | DTU_CMT_COUNTRY_MODE;
 
+    JsonObject history = doc["history"];
+    config.History.Enabled = history["enabled"] | HISTORY_ENABLED;
+    config.History.Interval = history["interval"] | HISTORY_INTERVAL;
+
     JsonObject security = doc["security"];
     strlcpy(config.Security.Password, security["password"] | ACCESS_POINT_PASSWORD, sizeof(config.Security.Password));
     config.Security.AllowReadonly = security["allow_readonly"] | SECURITY_ALLOW_READONLY;
@@ -3,8 +3,7 @@
  * Copyright (C) 2023-2024 Thomas Basler and others
  */
 #include "Datastore.h"
-#include "Configuration.h"
-#include <Hoymiles.h>
+#include <algorithm>
 
 DatastoreClass Datastore;
 
@@ -19,197 +18,273 @@ void DatastoreClass::init(Scheduler& scheduler)
     _loopTask.enable();
 }
 
+void DatastoreClass::forceUpdate()
+{
+    _forceUpdate = true;
+}
+
 void DatastoreClass::loop()
 {
-    if (!Hoymiles.isAllRadioIdle()) {
-        _loopTask.forceNextIteration();
-        return;
-    }
+    // Field values are read from the published snapshot of the statistics,
+    // therefore there is no need to wait until the radios are idle.
+    const bool force = _forceUpdate.exchange(false);
+    const uint8_t count = std::min<uint8_t>(Hoymiles.getNumInverters(), INV_MAX_COUNT);
 
-    uint8_t isProducing = 0;
-    uint8_t isReachable = 0;
-    uint8_t pollEnabledCount = 0;
+    bool changed = force || count != _inverterCount;
+    _inverterCount = count;
 
-    std::lock_guard<std::mutex> lock(_mutex);
+    for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+        InverterState_t& state = _inverters[i];
 
-    _totalAcYieldTotalEnabled = 0;
-    _totalAcYieldTotalDigits = 0;
+        auto inv = i < count ? Hoymiles.getInverterByPos(i) : nullptr;
+        if (inv == nullptr) {
+            if (state.serial != 0) {
+                state = {};
+                changed = true;
+            }
+            continue;
+        }
 
-    _totalAcYieldDayEnabled = 0;
-    _totalAcYieldDayDigits = 0;
+        if (force || state.serial != inv->serial()) {
+            state = {};
+            state.serial = inv->serial();
+            state.config = Configuration.getInverterConfig(state.serial);
+        }
 
-    _totalAcPowerEnabled = 0;
-    _totalAcPowerDigits = 0;
+        changed |= updateInverter(state, inv.get());
+    }
 
-    _totalDcPowerEnabled = 0;
-    _totalDcPowerDigits = 0;
+    if (changed) {
+        updateTotals();
+    }
+}
 
-    _totalDcPowerIrradiation = 0;
-    _totalDcIrradiationInstalled = 0;
+bool DatastoreClass::updateInverter(InverterState_t& state, InverterAbstract* inv)
+{
+    if (state.config == nullptr) {
+        return false;
+    }
 
-    _isAllEnabledProducing = true;
-    _isAllEnabledReachable = true;
+    const uint32_t generation = inv->Statistics()->getGeneration();
+    const bool pollEnabled = inv->getEnablePolling();
+    const bool reachable = inv->isReachable();
+
+    if (state.valid
+        && state.generation == generation
+        && state.pollEnabled == pollEnabled
+        && state.reachable == reachable
+        && state.configPollEnabled == state.config->Poll_Enable
+        && state.addToTotal == state.config->AddToTotal) {
+        return false;
+    }
 
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
-        if (inv == nullptr) {
-            continue;
+    state.valid = true;
+    state.generation = generation;
+    state.pollEnabled = pollEnabled;
+    state.reachable = reachable;
+    state.configPollEnabled = state.config->Poll_Enable;
+    state.addToTotal = state.config->AddToTotal;
+    state.producing = inv->isProducing();
+
+    state.acYieldTotal = 0;
+    state.acYieldDay = 0;
+    state.acPower = 0;
+    state.dcPower = 0;
+    state.dcPowerIrradiation = 0;
+    state.dcIrradiationInstalled = 0;
+    state.acYieldTotalDigits = 0;
+    state.acYieldDayDigits = 0;
+    state.acPowerDigits = 0;
+    state.dcPowerDigits = 0;
+
+    StatisticsParser* stats = inv->Statistics();
+
+    // All values are taken from the same frame
+    StatisticsSnapshot snapshot;
+    stats->getSnapshot(snapshot);
+
+    if (state.configPollEnabled && state.addToTotal) {
+        for (auto& c : stats->getChannelsByType(TYPE_INV)) {
+            state.acYieldTotal += snapshot.getChannelFieldValue(TYPE_INV, c, FLD_YT);
+            state.acYieldDay += snapshot.getChannelFieldValue(TYPE_INV, c, FLD_YD);
+
+            state.acYieldTotalDigits = std::max<uint8_t>(state.acYieldTotalDigits, stats->getChannelFieldDigits(TYPE_INV, c, FLD_YT));
+            state.acYieldDayDigits = std::max<uint8_t>(state.acYieldDayDigits, stats->getChannelFieldDigits(TYPE_INV, c, FLD_YD));
         }
+    }
 
-        auto cfg = Configuration.getInverterConfig(inv->serial());
-        if (cfg == nullptr) {
-            continue;
+    if (state.pollEnabled && state.addToTotal) {
+        for (auto& c : stats->getChannelsByType(TYPE_AC)) {
+            state.acPower += snapshot.getChannelFieldValue(TYPE_AC, c, FLD_PAC);
+            state.acPowerDigits = std::max<uint8_t>(state.acPowerDigits, stats->getChannelFieldDigits(TYPE_AC, c, FLD_PAC));
         }
 
-        if (inv->getEnablePolling()) {
-            pollEnabledCount++;
-        }
+        for (auto& c : stats->getChannelsByType(TYPE_DC)) {
+            state.dcPower += snapshot.getChannelFieldValue(TYPE_DC, c, FLD_PDC);
+            state.dcPowerDigits = std::max<uint8_t>(state.dcPowerDigits, stats->getChannelFieldDigits(TYPE_DC, c, FLD_PDC));
 
-        if (inv->isProducing()) {
-            isProducing++;
-        } else {
-            if (inv->getEnablePolling()) {
-                _isAllEnabledProducing = false;
+            if (stats->getStringMaxPower(c) > 0) {
+                state.dcPowerIrradiation += snapshot.getChannelFieldValue(TYPE_DC, c, FLD_PDC);
+                state.dcIrradiationInstalled += stats->getStringMaxPower(c);
             }
         }
+    }
 
-        if (inv->isReachable()) {
-            isReachable++;
-        } else {
-            if (inv->getEnablePolling()) {
-                _isAllEnabledReachable = false;
-            }
-        }
+    return true;
+}
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_INV)) {
-            if (cfg->Poll_Enable && cfg->AddToTotal) {
-                _totalAcYieldTotalEnabled += inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_YT);
-                _totalAcYieldDayEnabled += inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_YD);
+void DatastoreClass::updateTotals()
+{
+    // The totals are summed up from the cached values of every inverter
+    // instead of being adjusted by differences. This way no rounding errors
+    // accumulate over time.
+    float totalAcYieldTotalEnabled = 0;
+    float totalAcYieldDayEnabled = 0;
+    float totalAcPowerEnabled = 0;
+    float totalDcPowerEnabled = 0;
+    float totalDcPowerIrradiation = 0;
+    float totalDcIrradiationInstalled = 0;
+    uint32_t totalAcYieldTotalDigits = 0;
+    uint32_t totalAcYieldDayDigits = 0;
+    uint32_t totalAcPowerDigits = 0;
+    uint32_t totalDcPowerDigits = 0;
 
-                _totalAcYieldTotalDigits = max<unsigned int>(_totalAcYieldTotalDigits, inv->Statistics()->getChannelFieldDigits(TYPE_INV, c, FLD_YT));
-                _totalAcYieldDayDigits = max<unsigned int>(_totalAcYieldDayDigits, inv->Statistics()->getChannelFieldDigits(TYPE_INV, c, FLD_YD));
-            }
+    uint8_t isProducing = 0;
+    uint8_t isReachable = 0;
+    uint8_t pollEnabledCount = 0;
+    bool isAllEnabledProducing = true;
+    bool isAllEnabledReachable = true;
+
+    for (uint8_t i = 0; i < _inverterCount; i++) {
+        const InverterState_t& state = _inverters[i];
+        if (!state.valid) {
+            continue;
         }
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_AC)) {
-            if (inv->getEnablePolling() && cfg->AddToTotal) {
-                _totalAcPowerEnabled += inv->Statistics()->getChannelFieldValue(TYPE_AC, c, FLD_PAC);
-                _totalAcPowerDigits = max<unsigned int>(_totalAcPowerDigits, inv->Statistics()->getChannelFieldDigits(TYPE_AC, c, FLD_PAC));
-            }
+        if (state.pollEnabled) {
+            pollEnabledCount++;
         }
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
-            if (inv->getEnablePolling() && cfg->AddToTotal) {
-                _totalDcPowerEnabled += inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
-                _totalDcPowerDigits = max<unsigned int>(_totalDcPowerDigits, inv->Statistics()->getChannelFieldDigits(TYPE_DC, c, FLD_PDC));
+        if (state.producing) {
+            isProducing++;
+        } else if (state.pollEnabled) {
+            isAllEnabledProducing = false;
+        }
 
-                if (inv->Statistics()->getStringMaxPower(c) > 0) {
-                    _totalDcPowerIrradiation += inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
-                    _totalDcIrradiationInstalled += inv->Statistics()->getStringMaxPower(c);
-                }
-            }
+        if (state.reachable) {
+            isReachable++;
+        } else if (state.pollEnabled) {
+            isAllEnabledReachable = false;
         }
+
+        totalAcYieldTotalEnabled += state.acYieldTotal;
+        totalAcYieldDayEnabled += state.acYieldDay;
+        totalAcPowerEnabled += state.acPower;
+        totalDcPowerEnabled += state.dcPower;
+        totalDcPowerIrradiation += state.dcPowerIrradiation;
+        totalDcIrradiationInstalled += state.dcIrradiationInstalled;
+
+        totalAcYieldTotalDigits = std::max<uint32_t>(totalAcYieldTotalDigits, state.acYieldTotalDigits);
+        totalAcYieldDayDigits = std::max<uint32_t>(totalAcYieldDayDigits, state.acYieldDayDigits);
+        totalAcPowerDigits = std::max<uint32_t>(totalAcPowerDigits, state.acPowerDigits);
+        totalDcPowerDigits = std::max<uint32_t>(totalDcPowerDigits, state.dcPowerDigits);
     }
 
+    _totalAcYieldTotalEnabled = totalAcYieldTotalEnabled;
+    _totalAcYieldDayEnabled = totalAcYieldDayEnabled;
+    _totalAcPowerEnabled = totalAcPowerEnabled;
+    _totalDcPowerEnabled = totalDcPowerEnabled;
+    _totalDcPowerIrradiation = totalDcPowerIrradiation;
+    _totalDcIrradiationInstalled = totalDcIrradiationInstalled;
+    _totalDcIrradiation = totalDcIrradiationInstalled > 0 ? totalDcPowerIrradiation / totalDcIrradiationInstalled * 100.0f : 0;
+    _totalAcYieldTotalDigits = totalAcYieldTotalDigits;
+    _totalAcYieldDayDigits = totalAcYieldDayDigits;
+    _totalAcPowerDigits = totalAcPowerDigits;
+    _totalDcPowerDigits = totalDcPowerDigits;
+
     _isAtLeastOneProducing = isProducing > 0;
     _isAtLeastOneReachable = isReachable > 0;
     _isAtLeastOnePollEnabled = pollEnabledCount > 0;
-
-    _totalDcIrradiation = _totalDcIrradiationInstalled > 0 ? _totalDcPowerIrradiation / _totalDcIrradiationInstalled * 100.0f : 0;
+    _isAllEnabledProducing = isAllEnabledProducing;
+    _isAllEnabledReachable = isAllEnabledReachable;
 }
 
 float DatastoreClass::getTotalAcYieldTotalEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalAcYieldTotalEnabled;
 }
 
 float DatastoreClass::getTotalAcYieldDayEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalAcYieldDayEnabled;
 }
 
 float DatastoreClass::getTotalAcPowerEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalAcPowerEnabled;
 }
 
 float DatastoreClass::getTotalDcPowerEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalDcPowerEnabled;
 }
 
 float DatastoreClass::getTotalDcPowerIrradiation()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalDcPowerIrradiation;
 }
 
 float DatastoreClass::getTotalDcIrradiationInstalled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalDcIrradiationInstalled;
 }
 
 float DatastoreClass::getTotalDcIrradiation()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalDcIrradiation;
 }
 
 uint32_t DatastoreClass::getTotalAcYieldTotalDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalAcYieldTotalDigits;
 }
 
 uint32_t DatastoreClass::getTotalAcYieldDayDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalAcYieldDayDigits;
 }
 
 uint32_t DatastoreClass::getTotalAcPowerDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalAcPowerDigits;
 }
 
 uint32_t DatastoreClass::getTotalDcPowerDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _totalDcPowerDigits;
 }
 
 bool DatastoreClass::getIsAtLeastOneReachable()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _isAtLeastOneReachable;
 }
 
 bool DatastoreClass::getIsAtLeastOneProducing()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _isAtLeastOneProducing;
 }
 
 bool DatastoreClass::getIsAllEnabledProducing()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _isAllEnabledProducing;
 }
 
 bool DatastoreClass::getIsAllEnabledReachable()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _isAllEnabledReachable;
 }
 
 bool DatastoreClass::getIsAtLeastOnePollEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     return _isAtLeastOnePollEnabled;
 }
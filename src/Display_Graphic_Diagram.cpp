@@ -28,20 +28,21 @@ void DisplayGraphicDiagramClass::init(Scheduler& scheduler, U8G2* display)
 void DisplayGraphicDiagramClass::averageLoop()
 {
     const float currentWatts = Datastore.getTotalAcPowerEnabled(); // get the current AC production
+    if (_iRunningAverageCnt == 0) {
+        _iRunningMin = currentWatts;
+        _iRunningMax = currentWatts;
+    } else {
+        _iRunningMin = std::min(_iRunningMin, currentWatts);
+        _iRunningMax = std::max(_iRunningMax, currentWatts);
+    }
     _iRunningAverage += currentWatts;
     _iRunningAverageCnt++;
 }
 
 void DisplayGraphicDiagramClass::dataPointLoop()
 {
-    if (_graphValuesCount >= std::size(_graphValues)) {
-        for (uint8_t i = 0; i < std::size(_graphValues) - 1; i++) {
-            _graphValues[i] = _graphValues[i + 1];
-        }
-        _graphValuesCount = std::size(_graphValues) - 1;
-    }
     if (_iRunningAverageCnt != 0) {
-        _graphValues[_graphValuesCount++] = _iRunningAverage / _iRunningAverageCnt;
+        _series.append({ _iRunningMin, _iRunningMax, _iRunningAverage / _iRunningAverageCnt });
         _iRunningAverage = 0;
         _iRunningAverageCnt = 0;
     }
@@ -55,12 +56,29 @@ uint32_t DisplayGraphicDiagramClass::getSecondsPerDot()
 void DisplayGraphicDiagramClass::updatePeriod()
 {
     //  Calculate seconds per datapoint
-    _dataPointTask.setInterval(Configuration.get().Display.Diagram.Duration * TASK_SECOND / MAX_DATAPOINTS);
+    const uint32_t interval = Configuration.get().Display.Diagram.Duration * TASK_SECOND / MAX_DATAPOINTS;
+
+    // The stored points would be drawn with a wrong time scale
+    if (_dataPointInterval != 0 && _dataPointInterval != interval) {
+        _series.clear();
+    }
+    _dataPointInterval = interval;
+
+    _dataPointTask.setInterval(interval);
+}
+
+SparklineBuffer& DisplayGraphicDiagramClass::getSeries()
+{
+    return _series;
 }
 
 void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos, uint8_t yPos, uint8_t width, uint8_t height, bool isFullscreen)
 {
-    _chartWidth = width;
+    _chartWidth = std::min<uint8_t>(width, MAX_DATAPOINTS);
+
+    // one bucket per pixel, peaks between the pixels are kept as min and max
+    SparklineBucket_t points[MAX_DATAPOINTS];
+    const uint16_t pointCount = _series.resample(points, _chartWidth);
 
     // screenSaverOffsetX expected to be in range 0..6
     const uint8_t graphPosX = xPos + ((screenSaverOffsetX > 3) ? 1 : 0);
@@ -83,7 +101,10 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
 
     // draw AC value
     char fmtText[7];
-    const float maxWatts = *std::max_element(_graphValues.begin(), _graphValues.end());
+    float maxWatts = 0;
+    for (uint16_t i = 0; i < pointCount; i++) {
+        maxWatts = std::max(maxWatts, points[i].max);
+    }
     if (maxWatts > 999) {
         snprintf(fmtText, sizeof(fmtText), "%2.1fkW", maxWatts / 1000);
     } else {
@@ -103,7 +124,6 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
 
     // draw chart
     const float scaleFactorY = maxWatts / static_cast<float>(height);
-    const float scaleFactorX = static_cast<float>(MAX_DATAPOINTS) / static_cast<float>(_chartWidth);
 
     if (maxWatts > 0 && isFullscreen) {
         // draw y axis ticks
@@ -118,19 +138,28 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
     }
 
     uint8_t xAxisTicks = 1;
-    for (uint8_t i = 1; i < _graphValuesCount; i++) {
+    for (uint8_t i = 0; i < pointCount; i++) {
         // draw one tick per hour to the x-axis
         if (i * getSecondsPerDot() > (3600u * xAxisTicks)) {
-            _display->drawPixel((graphPosX + 1 + i) * scaleFactorX, graphPosY + height);
+            _display->drawPixel(graphPosX + 1 + i, graphPosY + height);
             xAxisTicks++;
         }
 
-        if (scaleFactorY == 0 || scaleFactorX == 0) {
+        if (scaleFactorY == 0) {
             continue;
         }
 
-        _display->drawLine(
-            graphPosX + (i - 1) / scaleFactorX, horizontal_line_y - std::max<int16_t>(0, _graphValues[i - 1] / scaleFactorY - 0.5),
-            graphPosX + i / scaleFactorX, horizontal_line_y - std::max<int16_t>(0, _graphValues[i] / scaleFactorY - 0.5));
+        // range between the lowest and the highest value of the pixel
+        const int16_t yMin = horizontal_line_y - std::max<int16_t>(0, points[i].min / scaleFactorY - 0.5);
+        const int16_t yMax = horizontal_line_y - std::max<int16_t>(0, points[i].max / scaleFactorY - 0.5);
+        if (yMin > yMax) {
+            _display->drawVLine(graphPosX + i, yMax, yMin - yMax);
+        }
+
+        if (i > 0) {
+            _display->drawLine(
+                graphPosX + i - 1, horizontal_line_y - std::max<int16_t>(0, points[i - 1].avg / scaleFactorY - 0.5),
+                graphPosX + i, horizontal_line_y - std::max<int16_t>(0, points[i].avg / scaleFactorY - 0.5));
+        }
     }
 }
@@ -0,0 +1,560 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022-2025 Thomas Basler and others
+ */
+#include "History.h"
+#include <Hoymiles.h>
+#include <esp_log.h>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <vector>
+
+#undef TAG
+static const char* TAG = "history";
+
+// Samples are only recorded if the time was synchronized (2020-01-01)
+#define HISTORY_MIN_TIME 1577836800
+
+HistoryClass History;
+
+static size_t putVarint(uint8_t* buffer, const size_t size, uint32_t value)
+{
+    size_t len = 0;
+    do {
+        if (len >= size) {
+            return 0;
+        }
+        buffer[len++] = (value & 0x7f) | (value > 0x7f ? 0x80 : 0);
+        value >>= 7;
+    } while (value > 0);
+    return len;
+}
+
+static size_t getVarint(const uint8_t* buffer, const size_t len, uint32_t& value)
+{
+    value = 0;
+    for (size_t i = 0; i < len && i < 5; i++) {
+        value |= static_cast<uint32_t>(buffer[i] & 0x7f) << (7 * i);
+        if (!(buffer[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Differences are calculated modulo 2^32 so that large values cannot overflow
+static uint32_t zigzag(const int32_t value, const int32_t previous)
+{
+    const uint32_t diff = static_cast<uint32_t>(value) - static_cast<uint32_t>(previous);
+    return (diff << 1) ^ (0u - (diff >> 31));
+}
+
+static int32_t unzigzag(const int32_t previous, const uint32_t value)
+{
+    const uint32_t diff = (value >> 1) ^ (0u - (value & 1));
+    return static_cast<int32_t>(static_cast<uint32_t>(previous) + diff);
+}
+
+HistoryClass::HistoryClass()
+    : _loopTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&HistoryClass::loop, this))
+{
+}
+
+void HistoryClass::init(Scheduler& scheduler)
+{
+    if (!LittleFS.exists(HISTORY_PATH)) {
+        LittleFS.mkdir(HISTORY_PATH);
+    }
+
+    scheduler.addTask(_loopTask);
+    _loopTask.enable();
+}
+
+void HistoryClass::loop()
+{
+    const CONFIG_T& config = Configuration.get();
+    if (!config.History.Enabled) {
+        return;
+    }
+
+    const time_t now = getTime();
+    if (now < HISTORY_MIN_TIME) {
+        return;
+    }
+
+    const uint32_t slot = now / std::max<uint32_t>(config.History.Interval, 1);
+    if (slot == _lastSlot) {
+        return;
+    }
+    _lastSlot = slot;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uint32_t hour = now - now % SECONDS_PER_HOUR;
+
+    writeFinished(hour);
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters() && i < INV_MAX_COUNT; i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        Buffer_t& buffer = _buffers[i];
+
+        if (buffer.serial != inv->serial()) {
+            buffer = {};
+            buffer.serial = inv->serial();
+        }
+
+        if (!inv->isReachable() || inv->Statistics()->getLastUpdate() == 0) {
+            continue;
+        }
+
+        StatisticsParser* stats = inv->Statistics();
+
+        StatisticsSnapshot snapshot;
+        stats->getSnapshot(snapshot);
+
+        HistorySample_t sample = {};
+        sample.time = now;
+
+        for (auto& c : stats->getChannelsByType(TYPE_AC)) {
+            sample.acPower += lroundf(snapshot.getChannelFieldValue(TYPE_AC, c, FLD_PAC) * 10);
+        }
+
+        for (auto& c : stats->getChannelsByType(TYPE_INV)) {
+            sample.yieldTotal = lroundf(snapshot.getChannelFieldValue(TYPE_INV, c, FLD_YT) * 1000);
+        }
+
+        uint8_t channels = 0;
+        for (auto& c : stats->getChannelsByType(TYPE_DC)) {
+            if (c < INV_MAX_CHAN_COUNT) {
+                sample.dcPower[c] = lroundf(snapshot.getChannelFieldValue(TYPE_DC, c, FLD_PDC) * 10);
+                channels = std::max<uint8_t>(channels, c + 1);
+            }
+        }
+
+        addSample(buffer, sample, channels);
+    }
+
+    const uint32_t today = now / SECONDS_PER_DAY;
+    if (today != _day) {
+        writeMissingDaily(today);
+        rotate(today);
+
+        if (_day != 0) {
+            ESP_LOGI(TAG, "%" PRIu32 " bytes written since boot", _bytesWritten);
+        }
+        _day = today;
+    }
+}
+
+void HistoryClass::addSample(Buffer_t& buffer, const HistorySample_t& sample, const uint8_t channels)
+{
+    const uint32_t hour = sample.time - sample.time % SECONDS_PER_HOUR;
+    if (buffer.count == 0 || buffer.hour != hour) {
+        buffer.hour = hour;
+        buffer.acPowerSum = 0;
+        buffer.count = 0;
+        buffer.acPowerMax = 0;
+        // The energy between the last sample of the previous hour and the first one of this hour is counted as well
+        buffer.firstYield = buffer.lastYield > 0 ? buffer.lastYield : sample.yieldTotal;
+    }
+
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        if (buffer.header.length == 0) {
+            buffer.header.type = HISTORY_BLOCK_SAMPLES;
+            buffer.header.channels = channels;
+            buffer.header.start = sample.time;
+            buffer.header.serial = buffer.serial;
+            buffer.last = {};
+            buffer.last.time = sample.time;
+        }
+
+        const size_t len = encodeSample(buffer.data + buffer.header.length, HISTORY_BLOCK_SIZE - buffer.header.length,
+            sample, buffer.last, buffer.header.channels);
+        if (len > 0) {
+            buffer.header.length += len;
+            buffer.last = sample;
+            break;
+        }
+
+        // The block is full, the sample becomes the first one of a new block
+        appendBlock(buffer.header, buffer.data);
+        buffer.header.length = 0;
+    }
+
+    buffer.acPowerSum += std::max<int32_t>(sample.acPower, 0);
+    buffer.acPowerMax = std::max(buffer.acPowerMax, sample.acPower);
+    buffer.lastYield = sample.yieldTotal;
+    buffer.count++;
+}
+
+HistoryHourly_t HistoryClass::getHourly(const Buffer_t& buffer)
+{
+    HistoryHourly_t hourly;
+    hourly.acPowerAvg = buffer.acPowerSum / buffer.count;
+    hourly.acPowerMax = std::max<int32_t>(buffer.acPowerMax, 0);
+    hourly.energy = std::max<int32_t>(buffer.lastYield - buffer.firstYield, 0);
+    return hourly;
+}
+
+void HistoryClass::writeFinished(const uint32_t hour)
+{
+    bool finished[INV_MAX_COUNT];
+    for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        finished[i] = _buffers[i].count > 0
+            && (_buffers[i].hour != hour || inv == nullptr || _buffers[i].serial != inv->serial());
+    }
+
+    // The finished buffers usually belong to the same hour and therefore to the same segment
+    for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+        if (!finished[i]) {
+            continue;
+        }
+        const uint32_t day = _buffers[i].hour / SECONDS_PER_DAY;
+
+        size_t bytes = 0;
+        for (uint8_t j = i; j < INV_MAX_COUNT; j++) {
+            if (finished[j] && _buffers[j].hour / SECONDS_PER_DAY == day) {
+                bytes += sizeof(HistoryBlockHeader_t) + _buffers[j].header.length
+                    + sizeof(HistoryBlockHeader_t) + sizeof(HistoryHourly_t);
+            }
+        }
+
+        File file;
+        const String path = getSegmentPath(day);
+        if (reserveSpace(bytes, day)) {
+            file = LittleFS.open(path, "a");
+            if (!file) {
+                ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+            }
+        }
+
+        for (uint8_t j = i; j < INV_MAX_COUNT; j++) {
+            Buffer_t& buffer = _buffers[j];
+            if (!finished[j] || buffer.hour / SECONDS_PER_DAY != day) {
+                continue;
+            }
+
+            if (file) {
+                if (buffer.header.length > 0) {
+                    writeBlock(file, buffer.header, buffer.data);
+                }
+
+                const HistoryHourly_t hourly = getHourly(buffer);
+
+                HistoryBlockHeader_t header = {};
+                header.type = HISTORY_BLOCK_HOURLY;
+                header.length = sizeof(hourly);
+                header.start = buffer.hour;
+                header.serial = buffer.serial;
+                writeBlock(file, header, &hourly);
+            }
+
+            // Samples which could not be written are dropped like the ones of a full filesystem
+            buffer.header.length = 0;
+            buffer.count = 0;
+            finished[j] = false;
+        }
+        file.close();
+    }
+}
+
+void HistoryClass::writeDaily(const uint32_t day)
+{
+    File file = LittleFS.open(getSegmentPath(day), "r");
+    if (!file) {
+        return;
+    }
+
+    HistoryDaily_t daily[INV_MAX_COUNT] = {};
+    uint8_t count = 0;
+
+    HistoryBlockHeader_t header;
+    while (file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)) {
+        if (header.type != HISTORY_BLOCK_HOURLY || header.length != sizeof(HistoryHourly_t)) {
+            file.seek(header.length, SeekCur);
+            continue;
+        }
+
+        HistoryHourly_t hourly;
+        if (file.read(reinterpret_cast<uint8_t*>(&hourly), sizeof(hourly)) != sizeof(hourly)) {
+            break;
+        }
+
+        uint8_t i = 0;
+        while (i < count && daily[i].serial != header.serial) {
+            i++;
+        }
+        if (i == count) {
+            if (count == INV_MAX_COUNT) {
+                continue;
+            }
+            daily[count].day = day;
+            daily[count].serial = header.serial;
+            count++;
+        }
+
+        daily[i].acPowerMax = std::max(daily[i].acPowerMax, hourly.acPowerMax);
+        daily[i].energy += hourly.energy;
+    }
+    file.close();
+
+    if (count == 0) {
+        return;
+    }
+
+    if (!reserveSpace(count * sizeof(HistoryDaily_t), day)) {
+        return;
+    }
+
+    File out = LittleFS.open(HISTORY_DAILY_FILE, "a");
+    if (!out) {
+        ESP_LOGE(TAG, "Failed to open %s", HISTORY_DAILY_FILE);
+        return;
+    }
+    _bytesWritten += out.write(reinterpret_cast<const uint8_t*>(daily), count * sizeof(HistoryDaily_t));
+    out.close();
+}
+
+void HistoryClass::writeMissingDaily(const uint32_t today)
+{
+    // The last rollup in the file tells which days are still missing
+    uint32_t lastDay = 0;
+    File file = LittleFS.open(HISTORY_DAILY_FILE, "r");
+    if (file) {
+        HistoryDaily_t daily;
+        if (file.size() >= sizeof(daily)
+            && file.seek(file.size() - file.size() % sizeof(daily) - sizeof(daily))
+            && file.read(reinterpret_cast<uint8_t*>(&daily), sizeof(daily)) == sizeof(daily)) {
+            lastDay = daily.day;
+        }
+        file.close();
+    }
+
+    for (uint32_t day = std::max(lastDay + 1, today - HISTORY_SEGMENT_DAYS); day < today; day++) {
+        writeDaily(day);
+    }
+}
+
+void HistoryClass::rotate(const uint32_t today)
+{
+    std::vector<String> obsolete;
+
+    File dir = LittleFS.open(HISTORY_PATH);
+    if (dir && dir.isDirectory()) {
+        File file = dir.openNextFile();
+        while (file) {
+            const String name = file.name();
+            const uint32_t day = name.toInt();
+            if (day > 0 && day + HISTORY_SEGMENT_DAYS <= today) {
+                obsolete.push_back(String(HISTORY_PATH "/") + name);
+            }
+            file.close();
+            file = dir.openNextFile();
+        }
+    }
+    dir.close();
+
+    for (auto& path : obsolete) {
+        ESP_LOGI(TAG, "Removing %s", path.c_str());
+        LittleFS.remove(path);
+    }
+
+    // The daily rollups are compacted once they exceed twice their retention
+    File daily = LittleFS.open(HISTORY_DAILY_FILE, "r");
+    if (!daily || daily.size() < 2 * HISTORY_DAILY_DAYS * INV_MAX_COUNT * sizeof(HistoryDaily_t)) {
+        return;
+    }
+
+    // The compacted copy exists next to the original until it is complete
+    if (!reserveSpace(daily.size(), today)) {
+        return;
+    }
+
+    const String tmpPath = HISTORY_DAILY_FILE ".tmp";
+    File tmp = LittleFS.open(tmpPath, "w");
+    if (!tmp) {
+        return;
+    }
+
+    HistoryDaily_t record;
+    while (daily.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) == sizeof(record)) {
+        if (record.day + HISTORY_DAILY_DAYS > today) {
+            _bytesWritten += tmp.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+        }
+    }
+    daily.close();
+    tmp.close();
+
+    LittleFS.remove(HISTORY_DAILY_FILE);
+    LittleFS.rename(tmpPath, HISTORY_DAILY_FILE);
+}
+
+bool HistoryClass::appendBlock(const HistoryBlockHeader_t& header, const void* payload)
+{
+    const uint32_t day = header.start / SECONDS_PER_DAY;
+    if (!reserveSpace(sizeof(header) + header.length, day)) {
+        return false;
+    }
+
+    const String path = getSegmentPath(day);
+    File file = LittleFS.open(path, "a");
+    if (!file) {
+        ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+        return false;
+    }
+
+    const size_t written = writeBlock(file, header, payload);
+    file.close();
+
+    return written == sizeof(header) + header.length;
+}
+
+size_t HistoryClass::writeBlock(File& file, const HistoryBlockHeader_t& header, const void* payload)
+{
+    size_t written = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    written += file.write(static_cast<const uint8_t*>(payload), header.length);
+
+    _bytesWritten += written;
+    return written;
+}
+
+bool HistoryClass::reserveSpace(const size_t bytes, const uint32_t keepDay)
+{
+    while (LittleFS.usedBytes() + bytes + HISTORY_FS_RESERVE > LittleFS.totalBytes()) {
+        uint32_t oldest = 0;
+
+        File dir = LittleFS.open(HISTORY_PATH);
+        if (dir && dir.isDirectory()) {
+            File file = dir.openNextFile();
+            while (file) {
+                // The daily rollup file has no number and is never removed
+                const uint32_t day = String(file.name()).toInt();
+                if (day > 0 && day != keepDay && (oldest == 0 || day < oldest)) {
+                    oldest = day;
+                }
+                file.close();
+                file = dir.openNextFile();
+            }
+        }
+        dir.close();
+
+        if (oldest == 0) {
+            ESP_LOGW(TAG, "Filesystem full, %zu bytes of history dropped", bytes);
+            return false;
+        }
+
+        const String path = getSegmentPath(oldest);
+        ESP_LOGI(TAG, "Filesystem full, removing %s", path.c_str());
+        if (!LittleFS.remove(path)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool HistoryClass::getPendingBlock(const uint64_t serial, HistoryBlockHeader_t& header, uint8_t* data)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& buffer : _buffers) {
+        if (buffer.serial == serial && buffer.header.length > 0) {
+            header = buffer.header;
+            memcpy(data, buffer.data, buffer.header.length);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HistoryClass::getPendingHourly(const uint64_t serial, uint32_t& start, HistoryHourly_t& hourly)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& buffer : _buffers) {
+        if (buffer.serial == serial && buffer.count > 0) {
+            start = buffer.hour;
+            hourly = getHourly(buffer);
+            return true;
+        }
+    }
+    return false;
+}
+
+time_t HistoryClass::getTime() const
+{
+    return std::time(nullptr);
+}
+
+String HistoryClass::getSegmentPath(const uint32_t day)
+{
+    return String(HISTORY_PATH "/") + String(day) + ".hst";
+}
+
+size_t HistoryClass::encodeSample(uint8_t* buffer, const size_t size, const HistorySample_t& sample, const HistorySample_t& previous, const uint8_t channels)
+{
+    size_t pos = 0;
+    size_t len;
+
+    auto put = [&](const uint32_t value) {
+        len = putVarint(buffer + pos, size - pos, value);
+        pos += len;
+        return len > 0;
+    };
+
+    if (!put(sample.time - previous.time)
+        || !put(zigzag(sample.acPower, previous.acPower))
+        || !put(zigzag(sample.yieldTotal, previous.yieldTotal))) {
+        return 0;
+    }
+
+    for (uint8_t c = 0; c < channels; c++) {
+        if (!put(zigzag(sample.dcPower[c], previous.dcPower[c]))) {
+            return 0;
+        }
+    }
+
+    return pos;
+}
+
+size_t HistoryClass::decodeSample(const uint8_t* buffer, const size_t len, HistorySample_t& sample, const uint8_t channels)
+{
+    size_t pos = 0;
+    uint32_t value;
+
+    auto get = [&]() {
+        const size_t read = getVarint(buffer + pos, len - pos, value);
+        pos += read;
+        return read > 0;
+    };
+
+    if (!get()) {
+        return 0;
+    }
+    sample.time += value;
+
+    if (!get()) {
+        return 0;
+    }
+    sample.acPower = unzigzag(sample.acPower, value);
+
+    if (!get()) {
+        return 0;
+    }
+    sample.yieldTotal = unzigzag(sample.yieldTotal, value);
+
+    for (uint8_t c = 0; c < channels && c < INV_MAX_CHAN_COUNT; c++) {
+        if (!get()) {
+            return 0;
+        }
+        sample.dcPower[c] = unzigzag(sample.dcPower[c], value);
+    }
+
+    return pos;
+}
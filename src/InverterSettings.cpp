@@ -16,7 +16,6 @@ InverterSettingsClass InverterSettings;
 
 InverterSettingsClass::InverterSettingsClass()
     : _settingsTask(INVERTER_UPDATE_SETTINGS_INTERVAL, TASK_FOREVER, std::bind(&InverterSettingsClass::settingsLoop, this))
-    , _hoyTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&InverterSettingsClass::hoyLoop, this))
 {
 }
 
@@ -29,10 +28,17 @@ void InverterSettingsClass::init(Scheduler& scheduler)
     ESP_LOGI(TAG, "Initialize Hoymiles interface...");
     Hoymiles.init();
 
+#ifdef HOYMILES_RADIO_SIM
+    // Serve all inverters by the simulated radio. No RF hardware required.
+    ESP_LOGW(TAG, "SIM: Initialize simulated radio");
+    Hoymiles.initSim();
+    Hoymiles.getRadioSim()->setDtuSerial(config.Dtu.Serial);
+#else
     if (!PinMapping.isValidNrf24Config() && !PinMapping.isValidCmt2300Config()) {
         ESP_LOGE(TAG, "Invalid pin config");
         return;
     }
+#endif
 
     // Initialize NRF24 if configured
     if (PinMapping.isValidNrf24Config()) {
@@ -66,6 +72,7 @@ void InverterSettingsClass::init(Scheduler& scheduler)
 
     ESP_LOGI(TAG, "RF: Setting poll interval...");
     Hoymiles.setPollInterval(config.Dtu.PollInterval);
+    Hoymiles.setAdaptivePolling(config.Dtu.AdaptivePoll.Enabled, config.Dtu.AdaptivePoll.MinInterval, config.Dtu.AdaptivePoll.MaxInterval);
 
     // Configure inverters
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
@@ -99,8 +106,9 @@ void InverterSettingsClass::init(Scheduler& scheduler)
     }
     ESP_LOGI(TAG, "Initialization complete");
 
-    scheduler.addTask(_hoyTask);
-    _hoyTask.enable();
+    // Radio handling runs in its own task on the same core as the main loop
+    xTaskCreatePinnedToCore(hoyTask, "hoymiles", HOYMILES_TASK_STACK_SIZE, nullptr, HOYMILES_TASK_PRIORITY, &_hoyTaskHandle, xPortGetCoreID());
+    Hoymiles.setWakeupTask(_hoyTaskHandle);
 
     scheduler.addTask(_settingsTask);
     _settingsTask.enable();
@@ -126,7 +134,14 @@ void InverterSettingsClass::settingsLoop()
     }
 }
 
-void InverterSettingsClass::hoyLoop()
+void InverterSettingsClass::hoyTask(void* pvParameters)
 {
-    Hoymiles.loop();
+    for (;;) {
+        Hoymiles.loop();
+
+        // Sleep until a radio interrupt, a new command or the next required loop() call.
+        // Always block at least one tick to let lower priority tasks run.
+        const TickType_t ticks = std::max<TickType_t>(pdMS_TO_TICKS(Hoymiles.getMaxSleep()), 1);
+        ulTaskNotifyTake(pdTRUE, ticks);
+    }
 }
@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022-2025 Thomas Basler and others
+ */
+#include "LiveDataJson.h"
+#include "Configuration.h"
+#include "Utils.h"
+
+// Fields of each channel which are sent to the clients (FLD_IRR only if a string max power is set)
+static const FieldId_t liveFields[] = {
+    FLD_PAC, FLD_UAC, FLD_IAC, FLD_PDC, FLD_UDC, FLD_IDC, FLD_YD,
+    FLD_YT, FLD_F, FLD_T, FLD_PF, FLD_Q, FLD_EFF
+};
+
+void LiveDataJson::generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+{
+    const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
+    if (inv_cfg == nullptr) {
+        return;
+    }
+
+    root["serial"] = inv->serialString();
+    root["name"] = inv->name();
+    root["order"] = inv_cfg->Order;
+    root["data_age"] = (millis() - inv->Statistics()->getLastUpdate()) / 1000;
+    root["data_age_ms"] = millis() - inv->Statistics()->getLastUpdate();
+    root["poll_enabled"] = inv->getEnablePolling();
+    root["reachable"] = inv->isReachable();
+    root["producing"] = inv->isProducing();
+    root["limit_relative"] = inv->SystemConfigPara()->getLimitPercent();
+    if (inv->DevInfo()->getMaxPower() > 0) {
+        root["limit_absolute"] = inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0;
+    } else {
+        root["limit_absolute"] = -1;
+    }
+    root["radio_stats"]["tx_request"] = inv->RadioStats.TxRequestData;
+    root["radio_stats"]["tx_re_request"] = inv->RadioStats.TxReRequestFragment;
+    root["radio_stats"]["rx_success"] = inv->RadioStats.RxSuccess;
+    root["radio_stats"]["rx_fail_nothing"] = inv->RadioStats.RxFailNoAnswer;
+    root["radio_stats"]["rx_fail_partial"] = inv->RadioStats.RxFailPartialAnswer;
+    root["radio_stats"]["rx_fail_corrupt"] = inv->RadioStats.RxFailCorruptData;
+    root["radio_stats"]["rssi"] = inv->getLastRssi();
+}
+
+void LiveDataJson::generateInverterRadioJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+{
+    // Only command types which have been answered at least once
+    JsonObject rtt = root["radio_stats"]["rtt"].to<JsonObject>();
+    for (uint8_t t = 0; t < COMMAND_TYPE_CNT; t++) {
+        const auto& histogram = inv->getRttHistogram(static_cast<CommandType>(t));
+        if (histogram.getTotal() > 0) {
+            Utils::addHistogram(rtt[commandTypeNames[t]].to<JsonObject>(), histogram);
+        }
+    }
+    Utils::addHistogram(root["radio_stats"]["retransmits"].to<JsonObject>(), inv->getRetransmitHistogram());
+    Utils::addHistogram(root["radio_stats"]["rssi_histogram"].to<JsonObject>(), inv->getRssiHistogram());
+}
+
+void LiveDataJson::generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv, JsonObject* fieldIds)
+{
+    const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
+    if (inv_cfg == nullptr) {
+        return;
+    }
+
+    StatisticsSnapshot snapshot;
+    inv->Statistics()->getSnapshot(snapshot);
+
+    // Loop all channels
+    for (auto& t : inv->Statistics()->getChannelTypes()) {
+        auto chanTypeObj = root[inv->Statistics()->getChannelTypeName(t)].to<JsonObject>();
+        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+            if (t == TYPE_DC) {
+                chanTypeObj[String(static_cast<uint8_t>(c))]["name"]["u"] = inv_cfg->channel[c].Name;
+            }
+            for (auto& f : liveFields) {
+                if (t == TYPE_INV && f == FLD_PDC) {
+                    addField(chanTypeObj, inv, snapshot, t, c, f, "Power DC", fieldIds);
+                } else {
+                    addField(chanTypeObj, inv, snapshot, t, c, f, "", fieldIds);
+                }
+            }
+            if (t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0) {
+                addField(chanTypeObj, inv, snapshot, t, c, FLD_IRR, "", fieldIds);
+                chanTypeObj[String(c)][inv->Statistics()->getChannelFieldName(t, c, FLD_IRR)]["max"] = inv->Statistics()->getStringMaxPower(c);
+            }
+        }
+    }
+
+    if (inv->Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
+        root["events"] = inv->EventLog()->getEntryCount();
+    } else {
+        root["events"] = -1;
+    }
+}
+
+void LiveDataJson::generateInverterDeltaJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv, WsLiveDeltaState_t& state)
+{
+    generateInverterCommonJsonResponse(root, inv);
+
+    if (state.serial != inv->serial()) {
+        state.serial = inv->serial();
+        state.fields.clear();
+    }
+
+    // Only fields whose rounded value or digits changed are sent. Changed digits
+    // are sent as [value, digits], otherwise only the value.
+    auto fieldsObj = root["fields"].to<JsonObject>();
+    size_t pos = 0;
+
+    StatisticsSnapshot snapshot;
+    inv->Statistics()->getSnapshot(snapshot);
+
+    auto addDeltaField = [&](const ChannelType_t t, const ChannelNum_t c, const FieldId_t f) {
+        if (!inv->Statistics()->hasChannelFieldValue(t, c, f)) {
+            return;
+        }
+
+        const uint16_t id = getFieldId(t, c, f);
+        const uint8_t digits = inv->Statistics()->getChannelFieldDigits(t, c, f);
+        const float scale = powf(10, digits);
+        const int32_t value = lroundf(snapshot.getChannelFieldValue(t, c, f) * scale);
+
+        if (pos >= state.fields.size() || state.fields[pos].id != id) {
+            // Set of fields changed, all following fields are sent again
+            state.fields.resize(pos);
+            state.fields.push_back({ id, UINT8_MAX, 0 });
+        }
+        WsLiveDeltaField_t& last = state.fields[pos++];
+
+        if (last.value == value && last.digits == digits) {
+            return;
+        }
+
+        if (last.digits != digits) {
+            auto fieldArray = fieldsObj[String(id)].to<JsonArray>();
+            fieldArray.add(value / scale);
+            fieldArray.add(digits);
+        } else {
+            fieldsObj[String(id)] = value / scale;
+        }
+
+        last.value = value;
+        last.digits = digits;
+    };
+
+    for (auto& t : inv->Statistics()->getChannelTypes()) {
+        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+            for (auto& f : liveFields) {
+                addDeltaField(t, c, f);
+            }
+            if (t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0) {
+                addDeltaField(t, c, FLD_IRR);
+            }
+        }
+    }
+    state.fields.resize(pos);
+
+    if (inv->Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
+        root["events"] = inv->EventLog()->getEntryCount();
+    } else {
+        root["events"] = -1;
+    }
+}
+
+void LiveDataJson::addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const StatisticsSnapshot& snapshot, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic, JsonObject* fieldIds)
+{
+    if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
+        String chanName;
+        if (topic == "") {
+            chanName = inv->Statistics()->getChannelFieldName(type, channel, fieldId);
+        } else {
+            chanName = topic;
+        }
+        String chanNum;
+        chanNum = channel;
+        root[chanNum][chanName]["v"] = snapshot.getChannelFieldValue(type, channel, fieldId);
+        root[chanNum][chanName]["u"] = inv->Statistics()->getChannelFieldUnit(type, channel, fieldId);
+        root[chanNum][chanName]["d"] = inv->Statistics()->getChannelFieldDigits(type, channel, fieldId);
+
+        // Path of the field in the snapshot for the delta protocol
+        if (fieldIds != nullptr) {
+            auto path = (*fieldIds)[String(getFieldId(type, channel, fieldId))].to<JsonArray>();
+            path.add(inv->Statistics()->getChannelTypeName(type));
+            path.add(chanNum);
+            path.add(chanName);
+        }
+    }
+}
+
+uint16_t LiveDataJson::getFieldId(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    return (type * CH_CNT + channel) * FLD_CNT + fieldId;
+}
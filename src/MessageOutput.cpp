@@ -1,10 +1,14 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
- * Copyright (C) 2022-2024 Thomas Basler and others
+ * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "MessageOutput.h"
 #include "SyslogLogger.h"
 #include <HardwareSerial.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <esp_system.h>
 
 MessageOutputClass MessageOutput;
 
@@ -21,12 +25,13 @@ void MessageOutputClass::init(Scheduler& scheduler)
     scheduler.addTask(_loopTask);
     _loopTask.enable();
     esp_log_set_vprintf(log_vprintf);
+
+    // the lines which were not written by loop() yet are written before a restart
+    esp_register_shutdown_handler([] { MessageOutput.flush(); });
 }
 
 void MessageOutputClass::register_ws_output(AsyncWebSocket* output)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
-
     _ws = output;
 }
 
@@ -37,7 +42,7 @@ int MessageOutputClass::log_vprintf(const char* fmt, va_list arguments)
     return MessageOutput.print(log_buffer);
 }
 
-void MessageOutputClass::serialWrite(MessageOutputClass::message_t const& m)
+void MessageOutputClass::serialWrite(const uint8_t* data, const size_t len)
 {
     // operator bool() of HWCDC returns false if the device is not attached to
     // a USB host. in general it makes sense to skip writing entirely if the
@@ -47,74 +52,185 @@ void MessageOutputClass::serialWrite(MessageOutputClass::message_t const& m)
     }
 
     size_t written = 0;
-    while (written < m.size()) {
-        written += Serial.write(m.data() + written, m.size() - written);
+    while (written < len) {
+        written += Serial.write(data + written, len - written);
     }
-
-    Serial.flush();
 }
 
 size_t MessageOutputClass::write(uint8_t c)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
+    return write(&c, 1);
+}
+
+size_t MessageOutputClass::write(const uint8_t* buffer, size_t size)
+{
+    // an ISR has no task of its own, therefore its output is never buffered
+    const TaskHandle_t task = xPortInIsrContext() ? nullptr : xTaskGetCurrentTaskHandle();
+
+    size_t pos = 0;
+    while (pos < size) {
+        const uint8_t* newline = static_cast<const uint8_t*>(memchr(buffer + pos, '\n', size - pos));
+        const size_t end = (newline != nullptr) ? (newline - buffer + 1) : size;
+
+        // a complete line is only buffered if its beginning was written before
+        partial_t* partial = (task != nullptr) ? getPartial(task, newline == nullptr) : nullptr;
+
+        if (partial == nullptr) {
+            for (size_t idx = pos; idx < end; idx += MESSAGE_OUTPUT_RECORD_SIZE) {
+                writeRecord(buffer + idx, std::min<size_t>(end - idx, MESSAGE_OUTPUT_RECORD_SIZE), task == nullptr);
+            }
+        } else {
+            for (size_t idx = pos; idx < end;) {
+                const size_t len = std::min(end - idx, MESSAGE_OUTPUT_RECORD_SIZE - partial->len);
+                memcpy(partial->data + partial->len, buffer + idx, len);
+                partial->len += len;
+                idx += len;
+
+                if (partial->len == MESSAGE_OUTPUT_RECORD_SIZE) {
+                    writeRecord(partial->data, partial->len, false);
+                    partial->len = 0;
+                }
+            }
+
+            if (newline != nullptr) {
+                if (partial->len > 0) {
+                    writeRecord(partial->data, partial->len, false);
+                }
+                partial->len = 0;
+                partial->owner.store(nullptr, std::memory_order_release);
+            }
+        }
 
-    auto res = _task_messages.emplace(xTaskGetCurrentTaskHandle(), message_t());
-    auto iter = res.first;
-    auto& message = iter->second;
+        pos = end;
+    }
 
-    message.push_back(c);
+    return size;
+}
 
-    if (c == '\n') {
-        serialWrite(message);
-        _lines.emplace(std::move(message));
-        _task_messages.erase(iter);
+void MessageOutputClass::flush()
+{
+    if (xPortInIsrContext()) {
+        return;
     }
 
-    return 1;
+    std::lock_guard<std::mutex> lock(_serialLock);
+    drainSerial();
+
+    if (Serial) {
+        Serial.flush();
+    }
 }
 
-size_t MessageOutputClass::write(const uint8_t* buffer, size_t size)
+void MessageOutputClass::writeRecord(const uint8_t* data, const size_t len, const bool fromIsr)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
+    const bool pushed = pushRecord(data, len);
 
-    auto res = _task_messages.emplace(xTaskGetCurrentTaskHandle(), message_t());
-    auto iter = res.first;
-    auto& message = iter->second;
+    if (fromIsr || _loopRunning.load(std::memory_order_relaxed)) {
+        return;
+    }
 
-    message.reserve(message.size() + size);
+    // another task is writing to the serial port, the line is written by it or by loop()
+    std::unique_lock<std::mutex> lock(_serialLock, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
 
-    for (size_t idx = 0; idx < size; ++idx) {
-        uint8_t c = buffer[idx];
+    drainSerial();
 
-        message.push_back(c);
+    // the ring is only full before the scheduler runs if the other outputs did
+    // not consume anything yet, the serial port still gets the line
+    if (!pushed) {
+        serialWrite(data, len);
+    }
+}
 
-        if (c == '\n') {
-            serialWrite(message);
-            _lines.emplace(std::move(message));
-            message.clear();
-            message.reserve(size - idx - 1);
+MessageOutputClass::partial_t* MessageOutputClass::getPartial(const TaskHandle_t task, const bool claim)
+{
+    for (auto& partial : _partials) {
+        if (partial.owner.load(std::memory_order_acquire) == task) {
+            return &partial;
         }
     }
 
-    if (message.empty()) {
-        _task_messages.erase(iter);
+    if (!claim) {
+        return nullptr;
     }
 
-    return size;
+    for (auto& partial : _partials) {
+        TaskHandle_t expected = nullptr;
+        if (partial.owner.compare_exchange_strong(expected, task, std::memory_order_acq_rel)) {
+            partial.len = 0;
+            return &partial;
+        }
+    }
+
+    // all buffers are in use, the line is written in parts
+    return nullptr;
 }
 
-void MessageOutputClass::send_ws_chunk(message_t&& line)
+bool MessageOutputClass::pushRecord(const uint8_t* data, const size_t len)
 {
-    if (!_ws) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    do {
+        // distance to the slowest output, cursors may already be ahead of a stale head
+        int32_t used = 0;
+        for (auto& cursor : _cursors) {
+            used = std::max(used, static_cast<int32_t>(head - cursor.load(std::memory_order_acquire)));
+        }
+
+        if (used >= MESSAGE_OUTPUT_RECORD_COUNT) {
+            _overruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    record_t& record = _records[head % MESSAGE_OUTPUT_RECORD_COUNT];
+    record.len = len;
+    memcpy(record.data, data, len);
+    record.seq.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+const MessageOutputClass::record_t* MessageOutputClass::peekRecord(const consumer_t consumer) const
+{
+    const uint32_t pos = _cursors[consumer].load(std::memory_order_relaxed);
+    const record_t& record = _records[pos % MESSAGE_OUTPUT_RECORD_COUNT];
+
+    // the record is either not written yet or still being written
+    if (record.seq.load(std::memory_order_acquire) != pos + 1) {
+        return nullptr;
+    }
+
+    return &record;
+}
+
+void MessageOutputClass::popRecord(const consumer_t consumer)
+{
+    _cursors[consumer].fetch_add(1, std::memory_order_release);
+}
+
+void MessageOutputClass::drainSerial()
+{
+    const record_t* record;
+    while ((record = peekRecord(CONSUMER_SERIAL)) != nullptr) {
+        serialWrite(record->data, record->len);
+        popRecord(CONSUMER_SERIAL);
+    }
+}
+
+void MessageOutputClass::send_ws_chunk(const uint8_t* data, const size_t len)
+{
+    AsyncWebSocket* ws = _ws.load();
+    if (!ws) {
         return;
     }
 
     if (nullptr == _ws_chunk) {
-        _ws_chunk = std::make_shared<message_t>(std::move(line));
-        _ws_chunk->reserve(WS_CHUNK_SIZE_BYTES + 128); // add room for one more line
-    } else {
-        _ws_chunk->insert(_ws_chunk->end(), line.begin(), line.end());
+        _ws_chunk = std::make_shared<message_t>();
+        _ws_chunk->reserve(WS_CHUNK_SIZE_BYTES + MESSAGE_OUTPUT_RECORD_SIZE); // add room for one more line
     }
+    _ws_chunk->insert(_ws_chunk->end(), data, data + len);
 
     bool small = _ws_chunk->size() < WS_CHUNK_SIZE_BYTES;
     bool recent = (millis() - _last_ws_chunk_sent) < WS_CHUNK_INTERVAL_MS;
@@ -123,7 +239,7 @@ void MessageOutputClass::send_ws_chunk(message_t&& line)
     }
 
     bool added_warning = false;
-    for (auto& client : _ws->getClients()) {
+    for (auto& client : ws->getClients()) {
         if (client.queueIsFull()) {
             continue;
         }
@@ -147,22 +263,39 @@ void MessageOutputClass::send_ws_chunk(message_t&& line)
 
 void MessageOutputClass::loop()
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
+    _loopRunning.store(true, std::memory_order_relaxed);
 
     // clean up (possibly filled) buffers of deleted tasks
-    auto map_iter = _task_messages.begin();
-    while (map_iter != _task_messages.end()) {
-        if (eTaskGetState(map_iter->first) == eDeleted) {
-            map_iter = _task_messages.erase(map_iter);
-            continue;
+    for (auto& partial : _partials) {
+        const TaskHandle_t owner = partial.owner.load(std::memory_order_acquire);
+        if (owner != nullptr && eTaskGetState(owner) == eDeleted) {
+            partial.len = 0;
+            partial.owner.store(nullptr, std::memory_order_release);
         }
+    }
+
+    const uint32_t overruns = _overruns.load(std::memory_order_relaxed);
+    if (overruns != _reported_overruns) {
+        char warning[64];
+        const int len = snprintf(warning, sizeof(warning), "WARNING: %" PRIu32 " log lines dropped\n", overruns - _reported_overruns);
+        if (pushRecord(reinterpret_cast<const uint8_t*>(warning), len)) {
+            _reported_overruns = overruns;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_serialLock);
+        drainSerial();
+    }
 
-        ++map_iter;
+    const record_t* record;
+    while ((record = peekRecord(CONSUMER_SYSLOG)) != nullptr) {
+        Syslog.write(record->data, record->len);
+        popRecord(CONSUMER_SYSLOG);
     }
 
-    while (!_lines.empty()) {
-        Syslog.write(_lines.front().data(), _lines.front().size());
-        send_ws_chunk(std::move(_lines.front()));
-        _lines.pop();
+    while ((record = peekRecord(CONSUMER_WEBSOCKET)) != nullptr) {
+        send_ws_chunk(record->data, record->len);
+        popRecord(CONSUMER_WEBSOCKET);
     }
 }
@@ -9,6 +9,7 @@
 #include "Utils.h"
 #include "__compiled_constants.h"
 #include "defaults.h"
+#include <algorithm>
 
 #define MAX_CONFIG_PUBLISH_RATIO 60000
 
@@ -34,15 +35,30 @@ void MqttHandleHassClass::loop()
         // Connection established
         _wasConnected = true;
         _updateForced = true;
+
+        // Retained configs are lost together with the session of the broker
+        if (!MqttSettings.getSessionPresent()) {
+            _publishedHashes.clear();
+        }
     } else if (!MqttSettings.getConnected() && _wasConnected) {
-        // Connection lost
+        // Connection lost. Configs of an interrupted publish may have been accepted by
+        // the client but not sent, therefore the whole discovery is published again.
         _wasConnected = false;
+        if (_cursor.active) {
+            _publishedHashes.clear();
+        }
+        _cursor.active = false;
     }
 
-    if (_updateForced && _publishConfigTimeout.occured()) {
+    if (_updateForced && !_cursor.active && _publishConfigTimeout.occured()) {
         publishConfig();
         _updateForced = false;
     }
+
+    // Only one part of the discovery is published per iteration to keep the other tasks running
+    if (_cursor.active) {
+        _cursor.active = publishNextStep();
+    }
 }
 
 void MqttHandleHassClass::forceUpdate()
@@ -63,6 +79,49 @@ void MqttHandleHassClass::publishConfig()
     ESP_LOGI(TAG, "Publish HA config");
     _publishConfigTimeout.set(MAX_CONFIG_PUBLISH_RATIO);
 
+    _cursor = {};
+    _cursor.active = true;
+    _cursor.dtu = true;
+}
+
+bool MqttHandleHassClass::publishNextStep()
+{
+    if (!MqttSettings.getConnected()) {
+        return false;
+    }
+
+    if (_cursor.dtu) {
+        publishDtuConfig();
+        _cursor.dtu = false;
+        return true;
+    }
+
+    // No inverters or the last one was removed meanwhile
+    if (_cursor.inverter >= Hoymiles.getNumInverters()) {
+        return false;
+    }
+
+    auto inv = Hoymiles.getInverterByPos(_cursor.inverter);
+
+    if (_cursor.channel == 0) {
+        publishInverterConfig(inv);
+        _cursor.channel++;
+        return true;
+    }
+
+    if (publishChannelConfig(inv, _cursor.channel - 1)) {
+        _cursor.channel++;
+        return true;
+    }
+
+    // All channels done, continue with the next inverter
+    _cursor.inverter++;
+    _cursor.channel = 0;
+    return _cursor.inverter < Hoymiles.getNumInverters();
+}
+
+void MqttHandleHassClass::publishDtuConfig()
+{
     const CONFIG_T& config = Configuration.get();
 
     // publish DTU sensors
@@ -81,48 +140,51 @@ void MqttHandleHassClass::publishConfig()
     publishDtuSensor("DC Power", "dc/power", "W", "", DEVICE_CLS_PWR, STATE_CLS_MEASUREMENT, CATEGORY_NONE);
 
     publishDtuBinarySensor("Status", config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Online, config.Mqtt.Lwt.Value_Offline, DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+}
+
+void MqttHandleHassClass::publishInverterConfig(std::shared_ptr<InverterAbstract> inv)
+{
+    publishInverterButton(inv, "Turn Inverter Off", "cmd/power", "0", "mdi:power-plug-off", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterButton(inv, "Turn Inverter On", "cmd/power", "1", "mdi:power-plug", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterButton(inv, "Restart Inverter", "cmd/restart", "1", "", DEVICE_CLS_RESTART, STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterButton(inv, "Reset Radio Statistics", "cmd/reset_rf_stats", "1", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
+
+    publishInverterNumber(inv, "Limit NonPersistent Relative", "status/limit_relative", "cmd/limit_nonpersistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterNumber(inv, "Limit Persistent Relative", "status/limit_relative", "cmd/limit_persistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+
+    publishInverterNumber(inv, "Limit NonPersistent Absolute", "status/limit_absolute", "cmd/limit_nonpersistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterNumber(inv, "Limit Persistent Absolute", "status/limit_absolute", "cmd/limit_persistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+
+    publishInverterBinarySensor(inv, "Reachable", "status/reachable", "1", "0", DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterBinarySensor(inv, "Producing", "status/producing", "1", "0", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_NONE);
+
+    publishInverterSensor(inv, "TX Requests", "radio/tx_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RX Success", "radio/rx_success", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RX Fail Receive Nothing", "radio/rx_fail_nothing", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RX Fail Receive Partial", "radio/rx_fail_partial", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RX Fail Receive Corrupt", "radio/rx_fail_corrupt", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "TX Re-Request Fragment", "radio/tx_re_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RSSI", "radio/rssi", "dBm", "", DEVICE_CLS_SIGNAL_STRENGTH, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+}
 
-    // Loop all inverters
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
-        yield();
-
-        publishInverterButton(inv, "Turn Inverter Off", "cmd/power", "0", "mdi:power-plug-off", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Turn Inverter On", "cmd/power", "1", "mdi:power-plug", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Restart Inverter", "cmd/restart", "1", "", DEVICE_CLS_RESTART, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Reset Radio Statistics", "cmd/reset_rf_stats", "1", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
-
-        publishInverterNumber(inv, "Limit NonPersistent Relative", "status/limit_relative", "cmd/limit_nonpersistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterNumber(inv, "Limit Persistent Relative", "status/limit_relative", "cmd/limit_persistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-
-        publishInverterNumber(inv, "Limit NonPersistent Absolute", "status/limit_absolute", "cmd/limit_nonpersistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterNumber(inv, "Limit Persistent Absolute", "status/limit_absolute", "cmd/limit_persistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-
-        publishInverterBinarySensor(inv, "Reachable", "status/reachable", "1", "0", DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterBinarySensor(inv, "Producing", "status/producing", "1", "0", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_NONE);
-
-        publishInverterSensor(inv, "TX Requests", "radio/tx_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Success", "radio/rx_success", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Nothing", "radio/rx_fail_nothing", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Partial", "radio/rx_fail_partial", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Corrupt", "radio/rx_fail_corrupt", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "TX Re-Request Fragment", "radio/tx_re_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RSSI", "radio/rssi", "dBm", "", DEVICE_CLS_SIGNAL_STRENGTH, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-
-        // Loop all channels
-        for (auto& t : inv->Statistics()->getChannelTypes()) {
-            for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-                for (uint8_t f = 0; f < DEVICE_CLS_ASSIGN_LIST_LEN; f++) {
-                    bool clear = false;
-                    if (t == TYPE_DC && !config.Mqtt.Hass.IndividualPanels) {
-                        clear = true;
-                    }
-                    publishInverterField(inv, t, c, deviceFieldAssignment[f], clear);
-                    yield();
-                }
+bool MqttHandleHassClass::publishChannelConfig(std::shared_ptr<InverterAbstract> inv, const uint8_t index)
+{
+    uint8_t i = 0;
+    for (auto& t : inv->Statistics()->getChannelTypes()) {
+        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+            if (i++ != index) {
+                continue;
             }
+
+            const bool clear = (t == TYPE_DC && !Configuration.get().Mqtt.Hass.IndividualPanels);
+            for (uint8_t f = 0; f < DEVICE_CLS_ASSIGN_LIST_LEN; f++) {
+                publishInverterField(inv, t, c, deviceFieldAssignment[f], clear);
+            }
+            return true;
         }
     }
+
+    return false;
 }
 
 void MqttHandleHassClass::publishInverterField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const byteAssign_fieldDeviceClass_t fieldType, const bool clear)
@@ -153,7 +215,12 @@ void MqttHandleHassClass::publishInverterField(std::shared_ptr<InverterAbstract>
         + "/config";
 
     if (!clear) {
-        const String stateTopic = MqttSettings.getPrefix() + MqttHandleInverter.getTopic(inv, type, channel, fieldType.fieldId);
+        String stateTopic;
+        if (MqttHandleInverter.isJsonEnabled()) {
+            stateTopic = MqttSettings.getPrefix() + MqttHandleInverter.getJsonTopic(inv);
+        } else {
+            stateTopic = MqttSettings.getPrefix() + MqttHandleInverter.getTopic(inv, type, channel, fieldType.fieldId);
+        }
 
         String name;
         if (type != TYPE_DC) {
@@ -172,8 +239,12 @@ void MqttHandleHassClass::publishInverterField(std::shared_ptr<InverterAbstract>
         root["stat_t"] = stateTopic;
         root["uniq_id"] = serial + "_ch" + chanNum + "_" + fieldName;
 
+        if (MqttHandleInverter.isJsonEnabled()) {
+            root["val_tpl"] = MqttHandleInverter.getValueTemplate(inv, type, channel, fieldType.fieldId);
+        }
+
         if (Configuration.get().Mqtt.Hass.Expire) {
-            root["exp_aft"] = Hoymiles.getNumInverters() * max<uint32_t>(Hoymiles.PollInterval(), Configuration.get().Mqtt.PublishInterval) * inv->getReachableThreshold();
+            root["exp_aft"] = getExpireAfter(inv);
         }
 
         publish(configTopic, root);
@@ -246,6 +317,24 @@ void MqttHandleHassClass::publishInverterNumber(
     publish(configTopic, root);
 }
 
+uint32_t MqttHandleHassClass::getExpireAfter(std::shared_ptr<InverterAbstract> inv)
+{
+    const CONFIG_T& config = Configuration.get();
+    uint32_t interval = Hoymiles.getNumInverters() * max<uint32_t>(Hoymiles.PollInterval(), config.Mqtt.PublishInterval);
+
+    // Stable inverters back off to the maximum poll interval
+    if (config.Dtu.AdaptivePoll.Enabled) {
+        interval = max<uint32_t>(interval, config.Dtu.AdaptivePoll.MaxInterval);
+    }
+
+    // Unchanged values are only published again after the max age
+    if (config.Mqtt.OnChange.Enabled) {
+        interval = max<uint32_t>(interval, config.Mqtt.OnChange.MaxAge);
+    }
+
+    return interval * inv->getReachableThreshold();
+}
+
 void MqttHandleHassClass::createInverterInfo(JsonDocument& root, std::shared_ptr<InverterAbstract> inv)
 {
     createDeviceInfo(
@@ -305,7 +394,30 @@ void MqttHandleHassClass::publish(const String& subtopic, const String& payload)
 {
     String topic = Configuration.get().Mqtt.Hass.Topic;
     topic += subtopic;
-    MqttSettings.publishGeneric(topic, payload, Configuration.get().Mqtt.Hass.Retain);
+
+    const bool retain = Configuration.get().Mqtt.Hass.Retain;
+
+    // The retain flag is part of the hash as changing it requires a republish as well.
+    // Non retained configs are always published as they are not kept by the broker.
+    const uint32_t topicHash = Utils::fnv1a(topic.c_str(), topic.length());
+    const uint32_t payloadHash = Utils::fnv1a(&retain, sizeof(retain), Utils::fnv1a(payload.c_str(), payload.length()));
+
+    auto it = std::lower_bound(_publishedHashes.begin(), _publishedHashes.end(), topicHash,
+        [](const std::pair<uint32_t, uint32_t>& entry, const uint32_t hash) { return entry.first < hash; });
+
+    const bool known = it != _publishedHashes.end() && it->first == topicHash;
+    if (known && retain && it->second == payloadHash) {
+        return;
+    }
+
+    // A config which was not accepted by the client is published with the next update
+    if (MqttSettings.publishGeneric(topic, payload, retain)) {
+        if (known) {
+            it->second = payloadHash;
+        } else {
+            _publishedHashes.insert(it, { topicHash, payloadHash });
+        }
+    }
     yield();
 }
 
@@ -4,6 +4,10 @@
  */
 #include "MqttHandleInverter.h"
 #include "MqttSettings.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
 #include <ctime>
 
 #undef TAG
@@ -13,8 +17,30 @@ static const char* TAG = "mqtt";
 
 MqttHandleInverterClass MqttHandleInverter;
 
+const char* const MqttHandleInverterClass::_statusSubtopics[STATUS_CNT] = {
+    "name",
+    "radio/tx_request",
+    "radio/tx_re_request",
+    "radio/rx_success",
+    "radio/rx_fail_nothing",
+    "radio/rx_fail_partial",
+    "radio/rx_fail_corrupt",
+    "radio/rssi",
+    "device/bootloaderversion",
+    "device/fwbuildversion",
+    "device/fwbuilddatetime",
+    "device/hwpartnumber",
+    "device/hwversion",
+    "status/limit_relative",
+    "status/limit_absolute",
+    "status/reachable",
+    "status/producing",
+    "status/last_update",
+};
+
 MqttHandleInverterClass::MqttHandleInverterClass()
     : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MqttHandleInverterClass::loop, this))
+    , _batch([](const MqttPublishBatch& batch) { MqttSettings.publishBatch(batch); })
 {
 }
 
@@ -31,101 +57,357 @@ void MqttHandleInverterClass::loop()
 {
     _loopTask.setInterval(Configuration.get().Mqtt.PublishInterval * TASK_SECOND);
 
-    if (!MqttSettings.getConnected() || !Hoymiles.isAllRadioIdle()) {
+    if (!MqttSettings.getConnected()) {
+        _wasConnected = false;
         _loopTask.forceNextIteration();
         return;
     }
 
+    if (!Hoymiles.isAllRadioIdle()) {
+        _loopTask.forceNextIteration();
+        return;
+    }
+
+    // Values which were published before the connection got lost are published again
+    if (!_wasConnected) {
+        _wasConnected = true;
+        resetPublishedValues();
+    }
+
+    const bool onChange = Configuration.get().Mqtt.OnChange.Enabled;
+    const bool publishTopics = Configuration.get().Mqtt.PayloadMode != MqttPayloadMode_t::PayloadJson;
+    const bool publishJsonDoc = isJsonEnabled();
+
+    // Topics are rebuilt if the prefix changed
+    const String prefix = MqttSettings.getPrefix();
+    if (prefix != _topicPrefix) {
+        _topicPrefix = prefix;
+        for (auto& topics : _topics) {
+            topics.serial = 0;
+        }
+    }
+
     // Loop all inverters
     for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
         auto inv = Hoymiles.getInverterByPos(i);
 
-        const String subtopic = inv->serialString();
+        InverterTopics_t& topics = getTopics(i, inv);
 
         // Name
-        MqttSettings.publish(subtopic + "/name", inv->name());
+        addStatus(topics, STATUS_NAME, inv->name());
 
         // Radio Statistics
-        MqttSettings.publish(subtopic + "/radio/tx_request", String(inv->RadioStats.TxRequestData));
-        MqttSettings.publish(subtopic + "/radio/tx_re_request", String(inv->RadioStats.TxReRequestFragment));
-        MqttSettings.publish(subtopic + "/radio/rx_success", String(inv->RadioStats.RxSuccess));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_nothing", String(inv->RadioStats.RxFailNoAnswer));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_partial", String(inv->RadioStats.RxFailPartialAnswer));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_corrupt", String(inv->RadioStats.RxFailCorruptData));
-        MqttSettings.publish(subtopic + "/radio/rssi", String(inv->getLastRssi()));
+        addStatusf(topics, STATUS_TX_REQUEST, "%" PRIu32, inv->RadioStats.TxRequestData);
+        addStatusf(topics, STATUS_TX_RE_REQUEST, "%" PRIu32, inv->RadioStats.TxReRequestFragment);
+        addStatusf(topics, STATUS_RX_SUCCESS, "%" PRIu32, inv->RadioStats.RxSuccess);
+        addStatusf(topics, STATUS_RX_FAIL_NOTHING, "%" PRIu32, inv->RadioStats.RxFailNoAnswer);
+        addStatusf(topics, STATUS_RX_FAIL_PARTIAL, "%" PRIu32, inv->RadioStats.RxFailPartialAnswer);
+        addStatusf(topics, STATUS_RX_FAIL_CORRUPT, "%" PRIu32, inv->RadioStats.RxFailCorruptData);
+        addStatusf(topics, STATUS_RSSI, "%" PRId8, inv->getLastRssi());
 
         if (inv->DevInfo()->getLastUpdate() > 0) {
             // Bootloader Version
-            MqttSettings.publish(subtopic + "/device/bootloaderversion", String(inv->DevInfo()->getFwBootloaderVersion()));
+            addStatusf(topics, STATUS_BOOTLOADER_VERSION, "%" PRIu16, inv->DevInfo()->getFwBootloaderVersion());
 
             // Firmware Version
-            MqttSettings.publish(subtopic + "/device/fwbuildversion", String(inv->DevInfo()->getFwBuildVersion()));
+            addStatusf(topics, STATUS_FW_BUILD_VERSION, "%" PRIu16, inv->DevInfo()->getFwBuildVersion());
 
             // Firmware Build DateTime
-            MqttSettings.publish(subtopic + "/device/fwbuilddatetime", inv->DevInfo()->getFwBuildDateTimeStr());
+            addStatus(topics, STATUS_FW_BUILD_DATETIME, inv->DevInfo()->getFwBuildDateTimeStr().c_str());
 
             // Hardware part number
-            MqttSettings.publish(subtopic + "/device/hwpartnumber", String(inv->DevInfo()->getHwPartNumber()));
+            addStatusf(topics, STATUS_HW_PART_NUMBER, "%" PRIu32, inv->DevInfo()->getHwPartNumber());
 
             // Hardware version
-            MqttSettings.publish(subtopic + "/device/hwversion", inv->DevInfo()->getHwVersion());
+            addStatus(topics, STATUS_HW_VERSION, inv->DevInfo()->getHwVersion().c_str());
         }
 
         if (inv->SystemConfigPara()->getLastUpdate() > 0) {
             // Limit
-            MqttSettings.publish(subtopic + "/status/limit_relative", String(inv->SystemConfigPara()->getLimitPercent()));
+            addStatusf(topics, STATUS_LIMIT_RELATIVE, "%.2f", inv->SystemConfigPara()->getLimitPercent());
 
             uint16_t maxpower = inv->DevInfo()->getMaxPower();
             if (maxpower > 0) {
-                MqttSettings.publish(subtopic + "/status/limit_absolute", String(inv->SystemConfigPara()->getLimitPercent() * maxpower / 100));
+                addStatusf(topics, STATUS_LIMIT_ABSOLUTE, "%.2f", inv->SystemConfigPara()->getLimitPercent() * maxpower / 100);
             }
         }
 
-        MqttSettings.publish(subtopic + "/status/reachable", String(inv->isReachable()));
-        MqttSettings.publish(subtopic + "/status/producing", String(inv->isProducing()));
+        addStatusf(topics, STATUS_REACHABLE, "%d", inv->isReachable());
+        addStatusf(topics, STATUS_PRODUCING, "%d", inv->isProducing());
 
-        if (inv->Statistics()->getLastUpdate() > 0) {
-            MqttSettings.publish(subtopic + "/status/last_update", String(std::time(0) - (millis() - inv->Statistics()->getLastUpdate()) / 1000));
+        // The time is calculated on every publish and may jitter by a second,
+        // therefore it is only treated as changed if new statistics were received
+        const uint32_t lastUpdate = inv->Statistics()->getLastUpdate();
+        if (lastUpdate > 0) {
+            char payload[24];
+            snprintf(payload, sizeof(payload), "%" PRId64, static_cast<int64_t>(std::time(0) - (millis() - lastUpdate) / 1000));
+            addStatus(topics, STATUS_LAST_UPDATE, payload, lastUpdate);
         } else {
-            MqttSettings.publish(subtopic + "/status/last_update", String(0));
+            addStatus(topics, STATUS_LAST_UPDATE, "0", 0);
         }
 
         const uint32_t lastUpdateInternal = inv->Statistics()->getLastUpdateFromInternal();
-        if (inv->Statistics()->getLastUpdate() > 0 && (lastUpdateInternal != _lastPublishStats[i])) {
+        const bool newStats = inv->Statistics()->getLastUpdate() > 0 && (lastUpdateInternal != _lastPublishStats[i]);
+        if (newStats) {
             _lastPublishStats[i] = lastUpdateInternal;
+        }
 
-            // Loop all channels
-            for (auto& t : inv->Statistics()->getChannelTypes()) {
-                for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-                    if (t == TYPE_DC) {
-                        INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
-                        if (inv_cfg != nullptr) {
-                            // TODO(tbnobody)
-                            MqttSettings.publish(inv->serialString() + "/" + String(static_cast<uint8_t>(c) + 1) + "/name", inv_cfg->channel[c].Name);
-                        }
-                    }
-                    for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(FieldId_t); f++) {
-                        publishField(inv, t, c, _publishFields[f]);
-                    }
+        if (publishTopics) {
+            if (onChange) {
+                // The fields are checked on every iteration as the max age also
+                // expires if no new statistics were received
+                if (inv->Statistics()->getLastUpdate() > 0) {
+                    publishChangedFields(inv, topics);
                 }
+            } else if (newStats) {
+                publishFields(inv, topics);
             }
         }
 
+        _batch.publish();
+
+        if (publishJsonDoc && newStats) {
+            publishJson(inv, topics);
+        }
+
         yield();
     }
 }
 
-void MqttHandleInverterClass::publishField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+void MqttHandleInverterClass::publishFields(std::shared_ptr<InverterAbstract> inv, InverterTopics_t& topics)
+{
+    const char* base = topics.base.c_str();
+
+    StatisticsSnapshot snapshot;
+    inv->Statistics()->getSnapshot(snapshot);
+
+    INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
+    if (inv_cfg != nullptr) {
+        for (auto& channel : topics.channelNames) {
+            _batch.add(base, channel.subtopic, inv_cfg->channel[channel.channel].Name);
+        }
+    }
+
+    for (auto& field : topics.fields) {
+        _batch.addf(base, field.subtopic, "%.*f",
+            static_cast<int>(inv->Statistics()->getChannelFieldDigits(field.type, field.channel, field.fieldId)),
+            snapshot.getChannelFieldValue(field.type, field.channel, field.fieldId));
+    }
+}
+
+void MqttHandleInverterClass::publishChangedFields(std::shared_ptr<InverterAbstract> inv, InverterTopics_t& topics)
 {
-    const String topic = getTopic(inv, type, channel, fieldId);
-    if (topic == "") {
+    const CONFIG_T& config = Configuration.get();
+    const char* base = topics.base.c_str();
+    const uint32_t now = millis();
+    const uint32_t maxAge = config.Mqtt.OnChange.MaxAge * 1000;
+
+    StatisticsSnapshot snapshot;
+    inv->Statistics()->getSnapshot(snapshot);
+
+    // Channel names only change by configuration, therefore they are just refreshed after the max age
+    if (!topics.namesPublished || now - topics.lastPublishNames >= maxAge) {
+        INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
+        if (inv_cfg != nullptr) {
+            for (auto& channel : topics.channelNames) {
+                _batch.add(base, channel.subtopic, inv_cfg->channel[channel.channel].Name);
+            }
+        }
+        topics.lastPublishNames = now;
+        topics.namesPublished = true;
+    }
+
+    for (auto& field : topics.fields) {
+        const float value = snapshot.getChannelFieldValue(field.type, field.channel, field.fieldId);
+        const uint8_t digits = inv->Statistics()->getChannelFieldDigits(field.type, field.channel, field.fieldId);
+
+        if (field.published
+            && now - field.lastPublish < maxAge
+            && !isOutsideDeadband(value, field.lastValue, digits, config.Mqtt.OnChange.Deadband, config.Mqtt.OnChange.DeadbandAbsolute)) {
+            continue;
+        }
+
+        _batch.addf(base, field.subtopic, "%.*f", static_cast<int>(digits), value);
+
+        field.lastValue = value;
+        field.lastPublish = now;
+        field.published = true;
+    }
+}
+
+void MqttHandleInverterClass::publishJson(std::shared_ptr<InverterAbstract> inv, const InverterTopics_t& topics)
+{
+    // The document mirrors the per field topics: {"0":{"power":...},"1":{"name":"...","voltage":...}}
+    JsonDocument root;
+
+    StatisticsSnapshot snapshot;
+    inv->Statistics()->getSnapshot(snapshot);
+
+    auto getMember = [&root](const char* subtopic) -> JsonVariant {
+        const char* slash = strchr(subtopic, '/');
+        return root[String(subtopic).substring(0, slash - subtopic)][slash + 1].to<JsonVariant>();
+    };
+
+    INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
+    if (inv_cfg != nullptr) {
+        for (auto& channel : topics.channelNames) {
+            getMember(channel.subtopic).set(inv_cfg->channel[channel.channel].Name);
+        }
+    }
+
+    for (auto& field : topics.fields) {
+        getMember(field.subtopic).set(snapshot.getChannelFieldValue(field.type, field.channel, field.fieldId));
+    }
+
+    if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
         return;
     }
 
-    MqttSettings.publish(topic, inv->Statistics()->getChannelFieldValueString(type, channel, fieldId));
+    String buffer;
+    serializeJson(root, buffer);
+    MqttSettings.publishGeneric(topics.base + "json", buffer, Configuration.get().Mqtt.Retain);
+}
+
+void MqttHandleInverterClass::addStatus(InverterTopics_t& topics, const StatusTopic_t id, const char* payload, const uint32_t hash)
+{
+    const CONFIG_T& config = Configuration.get();
+    const uint32_t now = millis();
+    StatusValue_t& status = topics.status[id];
+
+    if (config.Mqtt.OnChange.Enabled
+        && status.published
+        && status.hash == hash
+        && now - status.lastPublish < config.Mqtt.OnChange.MaxAge * 1000) {
+        return;
+    }
+
+    _batch.add(topics.base.c_str(), _statusSubtopics[id], payload);
+
+    status.hash = hash;
+    status.lastPublish = now;
+    status.published = true;
+}
+
+void MqttHandleInverterClass::addStatus(InverterTopics_t& topics, const StatusTopic_t id, const char* payload)
+{
+    addStatus(topics, id, payload, Utils::fnv1a(payload, strlen(payload)));
+}
+
+void MqttHandleInverterClass::addStatusf(InverterTopics_t& topics, const StatusTopic_t id, const char* format, ...)
+{
+    char buffer[64];
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    addStatus(topics, id, buffer);
+}
+
+bool MqttHandleInverterClass::isOutsideDeadband(const float value, const float lastValue, const uint8_t digits, const float relDeadband, const float absDeadband)
+{
+    // Changes which are not visible with the digits of the field are never published
+    const float scale = powf(10, digits);
+    if (lroundf(value * scale) == lroundf(lastValue * scale)) {
+        return false;
+    }
+
+    // Changes from and to zero are always published (e.g. the power at sunset)
+    if ((value == 0) != (lastValue == 0)) {
+        return true;
+    }
+
+    const float threshold = std::max(absDeadband, std::fabs(lastValue) * relDeadband / 100);
+    return std::fabs(value - lastValue) >= threshold;
+}
+
+void MqttHandleInverterClass::resetPublishedValues()
+{
+    for (auto& topics : _topics) {
+        topics.namesPublished = false;
+        for (auto& status : topics.status) {
+            status.published = false;
+        }
+        for (auto& field : topics.fields) {
+            field.published = false;
+        }
+    }
+}
+
+MqttHandleInverterClass::InverterTopics_t& MqttHandleInverterClass::getTopics(const uint8_t pos, std::shared_ptr<InverterAbstract> inv)
+{
+    InverterTopics_t& topics = _topics[pos];
+    if (topics.serial == inv->serial()) {
+        return topics;
+    }
+
+    topics.serial = inv->serial();
+    topics.base = _topicPrefix + inv->serialString() + "/";
+    topics.channelNames.clear();
+    topics.fields.clear();
+    topics.namesPublished = false;
+    for (auto& status : topics.status) {
+        status.published = false;
+    }
+
+    // The channels of an inverter never change, therefore the lists are only used here
+    for (auto& t : inv->Statistics()->getChannelTypes()) {
+        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+            if (t == TYPE_DC) {
+                // TODO(tbnobody)
+                topics.channelNames.push_back({ c, intern(String(static_cast<uint8_t>(c) + 1) + "/name") });
+            }
+            for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(FieldId_t); f++) {
+                const String subtopic = getSubtopic(inv, t, c, _publishFields[f]);
+                if (subtopic != "") {
+                    topics.fields.push_back({ t, c, _publishFields[f], intern(subtopic), 0, 0, false });
+                }
+            }
+        }
+    }
+
+    return topics;
+}
+
+const char* MqttHandleInverterClass::intern(const String& subtopic)
+{
+    return _subtopics.insert(subtopic).first->c_str();
 }
 
 String MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    const String subtopic = getSubtopic(inv, type, channel, fieldId);
+    if (subtopic == "") {
+        return "";
+    }
+
+    return inv->serialString() + "/" + subtopic;
+}
+
+String MqttHandleInverterClass::getJsonTopic(std::shared_ptr<InverterAbstract> inv)
+{
+    return inv->serialString() + "/json";
+}
+
+String MqttHandleInverterClass::getValueTemplate(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    const String subtopic = getSubtopic(inv, type, channel, fieldId);
+    const int slash = subtopic.indexOf('/');
+    if (slash < 0) {
+        return "";
+    }
+
+    return "{{ value_json['" + subtopic.substring(0, slash) + "']." + subtopic.substring(slash + 1) + " }}";
+}
+
+bool MqttHandleInverterClass::isJsonEnabled()
+{
+    const uint8_t mode = Configuration.get().Mqtt.PayloadMode;
+    return mode == MqttPayloadMode_t::PayloadJson || mode == MqttPayloadMode_t::PayloadTopicsAndJson;
+}
+
+String MqttHandleInverterClass::getSubtopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
     if (!inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
         return "";
@@ -147,7 +429,7 @@ String MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv,
         chanNum = channel;
     }
 
-    return inv->serialString() + "/" + chanNum + "/" + chanName;
+    return chanNum + "/" + chanName;
 }
 
 void MqttHandleInverterClass::onMqttMessage(Topic t, const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, const size_t len)
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "MqttPublishBatch.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+MqttPublishBatch::MqttPublishBatch(PublishCallback callback)
+    : _callback(callback)
+{
+}
+
+void MqttPublishBatch::add(const char* base, const char* subtopic, const char* payload)
+{
+    // Same as MqttSettingsClass::publish which trims the payload
+    while (isspace(static_cast<unsigned char>(*payload))) {
+        payload++;
+    }
+    size_t len = strlen(payload);
+    while (len > 0 && isspace(static_cast<unsigned char>(payload[len - 1]))) {
+        len--;
+    }
+    len = std::min(len, sizeof(_payload) - 1);
+
+    reserve(len);
+
+    memcpy(&_payload[_payloadLen], payload, len);
+    _payload[_payloadLen + len] = '\0';
+
+    _messages[_count++] = { base, subtopic, static_cast<uint16_t>(_payloadLen) };
+    _payloadLen += len + 1;
+}
+
+void MqttPublishBatch::addf(const char* base, const char* subtopic, const char* format, ...)
+{
+    char buffer[64];
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    add(base, subtopic, buffer);
+}
+
+void MqttPublishBatch::reserve(const size_t len)
+{
+    if (_count >= _messages.size() || _payloadLen + len + 1 > sizeof(_payload)) {
+        publish();
+    }
+}
+
+void MqttPublishBatch::publish()
+{
+    if (_count > 0) {
+        _callback(*this);
+    }
+    _count = 0;
+    _payloadLen = 0;
+}
+
+size_t MqttPublishBatch::size() const
+{
+    return _count;
+}
+
+const char* MqttPublishBatch::getBase(const size_t index) const
+{
+    return _messages[index].base;
+}
+
+const char* MqttPublishBatch::getSubtopic(const size_t index) const
+{
+    return _messages[index].subtopic;
+}
+
+const char* MqttPublishBatch::getPayload(const size_t index) const
+{
+    return &_payload[_messages[index].payload];
+}
+
+size_t MqttPublishBatch::getTopic(const size_t index, char* buffer, const size_t size) const
+{
+    return snprintf(buffer, size, "%s%s", _messages[index].base, _messages[index].subtopic);
+}
@@ -33,6 +33,7 @@ void MqttSettingsClass::NetworkEvent(network_event event)
 void MqttSettingsClass::onMqttConnect(const bool sessionPresent)
 {
     ESP_LOGI(TAG, "Connected to MQTT.");
+    _sessionPresent = sessionPresent;
     const CONFIG_T& config = Configuration.get();
     publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Online);
 
@@ -193,6 +194,11 @@ bool MqttSettingsClass::getConnected()
     return _mqttClient->connected();
 }
 
+bool MqttSettingsClass::getSessionPresent() const
+{
+    return _sessionPresent;
+}
+
 String MqttSettingsClass::getPrefix() const
 {
     return Configuration.get().Mqtt.Topic;
@@ -218,13 +224,28 @@ void MqttSettingsClass::publish(const String& subtopic, const String& payload)
     publishGeneric(topic, value, Configuration.get().Mqtt.Retain, 0);
 }
 
-void MqttSettingsClass::publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos)
+bool MqttSettingsClass::publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos)
+{
+    std::lock_guard<std::mutex> lock(_clientLock);
+    if (_mqttClient == nullptr) {
+        return false;
+    }
+    return _mqttClient->publish(topic.c_str(), qos, retain, payload.c_str()) != 0;
+}
+
+void MqttSettingsClass::publishBatch(const MqttPublishBatch& batch)
 {
+    const bool retain = Configuration.get().Mqtt.Retain;
+    char topic[MQTT_MAX_TOPIC_STRLEN + 64];
+
     std::lock_guard<std::mutex> lock(_clientLock);
     if (_mqttClient == nullptr) {
         return;
     }
-    _mqttClient->publish(topic.c_str(), qos, retain, payload.c_str());
+    for (size_t i = 0; i < batch.size(); i++) {
+        batch.getTopic(i, topic, sizeof(topic));
+        _mqttClient->publish(topic, 0, retain, batch.getPayload(i));
+    }
 }
 
 void MqttSettingsClass::init()
@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022-2025 Thomas Basler and others
+ */
+#include "PrometheusExporter.h"
+#include <algorithm>
+#include <cstring>
+
+// Prefix of all metric families which are rendered from inverter data
+#define METRIC_PREFIX "opendtu_"
+
+// Families are emitted in the order of MetricFamily_t, each one with a single HELP and TYPE header
+const PrometheusExporter::metric_family_t PrometheusExporter::_families[] = {
+    { "opendtu_build", "Build info", GAUGE, SYSTEM },
+    { "opendtu_platform", "Platform info", GAUGE, SYSTEM },
+    { "opendtu_uptime", "Uptime in seconds", COUNTER, SYSTEM },
+    { "opendtu_heap_size", "System memory size", GAUGE, SYSTEM },
+    { "opendtu_free_heap_size", "System free memory", GAUGE, SYSTEM },
+    { "opendtu_biggest_heap_block", "Biggest free heap block", GAUGE, SYSTEM },
+    { "opendtu_heap_min_free", "Minimum free memory since boot", GAUGE, SYSTEM },
+    { "wifi_rssi", "WiFi RSSI", GAUGE, SYSTEM },
+    { "wifi_station", "WiFi Station info", GAUGE, SYSTEM },
+    { "opendtu_last_update", "last update from inverter in s", GAUGE, INVERTER },
+    { "opendtu_inverter_limit_relative", "current relative limit of the inverter", GAUGE, INVERTER },
+    { "opendtu_inverter_limit_absolute", "current relative limit of the inverter", GAUGE, INVERTER },
+    { "opendtu_radio_rtt_milliseconds", "time between request and last fragment of a complete answer", HISTOGRAM, RADIO },
+    { "opendtu_radio_retransmits", "fragment re-requests per request", HISTOGRAM, RADIO },
+    { "opendtu_radio_rssi_dbm", "RSSI of received fragments", HISTOGRAM, RADIO },
+    { "opendtu_PanelInfo", "panel information", GAUGE, PANEL },
+    { "opendtu_MaxPower", "panel maximum output power", GAUGE, PANEL },
+    { "opendtu_YieldTotalOffset", "panel yield offset (for used inverters)", GAUGE, PANEL },
+    // FAMILY_FIELDS
+    { "opendtu_Power", "in W", GAUGE, FIELD },
+    { "opendtu_Voltage", "in V", GAUGE, FIELD },
+    { "opendtu_Current", "in A", GAUGE, FIELD },
+    { "opendtu_PowerDC", "in W", GAUGE, FIELD },
+    { "opendtu_YieldDay", "in Wh", COUNTER, FIELD },
+    { "opendtu_YieldTotal", "in kWh", COUNTER, FIELD },
+    { "opendtu_Frequency", "in Hz", GAUGE, FIELD },
+    { "opendtu_Temperature", "in °C", GAUGE, FIELD },
+    { "opendtu_PowerFactor", "in ", GAUGE, FIELD },
+    { "opendtu_ReactivePower", "in var", GAUGE, FIELD },
+    { "opendtu_Efficiency", "in %", GAUGE, FIELD },
+    { "opendtu_Irradiation", "in %", GAUGE, FIELD },
+};
+
+const uint8_t PrometheusExporter::_familyCount = sizeof(_families) / sizeof(_families[0]);
+
+void PrometheusExporter::updateLabels()
+{
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters() && i < INV_MAX_COUNT; i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        if (_labelSerial[i] == inv->serial() && strncmp(_labelName[i], inv->name(), sizeof(_labelName[i])) == 0) {
+            continue;
+        }
+
+        _labelSerial[i] = inv->serial();
+        strlcpy(_labelName[i], inv->name(), sizeof(_labelName[i]));
+        snprintf(_labels[i], sizeof(_labels[i]), "serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"",
+            inv->serialString().c_str(), i, _labelName[i]);
+    }
+}
+
+size_t PrometheusExporter::fillChunk(Scrape_t& scrape, uint8_t* buffer, const size_t maxLen)
+{
+    size_t written = 0;
+    while (written < maxLen) {
+        if (scrape.linePos >= scrape.lineLen) {
+            scrape.lineLen = 0;
+            scrape.linePos = 0;
+            if (!nextLine(scrape)) {
+                break;
+            }
+        }
+
+        const size_t len = std::min(maxLen - written, scrape.lineLen - scrape.linePos);
+        memcpy(buffer + written, scrape.line + scrape.linePos, len);
+        written += len;
+        scrape.linePos += len;
+    }
+    return written;
+}
+
+bool PrometheusExporter::nextLine(Scrape_t& scrape)
+{
+    for (; scrape.family < _familyCount; scrape.family++, scrape.inverter = 0, scrape.type = 0, scrape.channel = 0, scrape.field = 0, scrape.header = false) {
+        const metric_family_t& family = _families[scrape.family];
+
+        // HELP and TYPE are written in front of the first line of the family.
+        // They are only kept if the family really contains a line.
+        size_t offset = 0;
+        if (!scrape.header) {
+            offset = snprintf(scrape.line, sizeof(scrape.line), "# HELP %s %s\n# TYPE %s %s\n",
+                family.name, family.help, family.name, _metricTypes[family.type]);
+            offset = std::min(offset, sizeof(scrape.line) - 1);
+        }
+        char* line = scrape.line + offset;
+        const size_t size = sizeof(scrape.line) - offset;
+        int len = -1;
+
+        if (family.source == SYSTEM) {
+            if (scrape.inverter == 0) {
+                scrape.inverter = 1;
+                len = printSystemMetric(line, size, scrape.family);
+            }
+        } else {
+            for (; scrape.inverter < Hoymiles.getNumInverters() && scrape.inverter < INV_MAX_COUNT; scrape.inverter++, scrape.type = 0, scrape.channel = 0, scrape.field = 0) {
+                auto inv = Hoymiles.getInverterByPos(scrape.inverter);
+                if (inv == nullptr) {
+                    continue;
+                }
+
+                len = printNextInverterLine(scrape, line, size, inv.get());
+                if (len >= 0) {
+                    break;
+                }
+            }
+        }
+
+        if (len >= 0) {
+            scrape.header = true;
+            scrape.lineLen = std::min(offset + len, sizeof(scrape.line) - 1);
+            scrape.linePos = 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int PrometheusExporter::printNextInverterLine(Scrape_t& scrape, char* line, const size_t size, InverterAbstract* inv)
+{
+    const metric_family_t& family = _families[scrape.family];
+
+    if (family.source == INVERTER) {
+        if (scrape.type > 0) {
+            return -1;
+        }
+        scrape.type = 1;
+        return printInverterMetric(line, size, scrape.family, scrape.inverter, inv);
+    }
+
+    if (family.source == RADIO) {
+        // Only the round trip time is available per command type
+        const uint8_t typeCount = (scrape.family == FAMILY_RADIO_RTT) ? COMMAND_TYPE_CNT : 1;
+        for (; scrape.type < typeCount; scrape.type++, scrape.field = 0) {
+            const int len = printHistogramMetric(line, size, scrape.family, scrape.inverter, inv, static_cast<CommandType>(scrape.type), scrape.field);
+            if (len >= 0) {
+                scrape.field++;
+                return len;
+            }
+        }
+        return -1;
+    }
+
+    // Channels are only available if Statistics have been updated at least once since DTU boot
+    if (inv->Statistics()->getLastUpdate() == 0) {
+        return -1;
+    }
+
+    for (; scrape.type < TYPE_CNT; scrape.type++, scrape.channel = 0, scrape.field = 0) {
+        const ChannelType_t type = static_cast<ChannelType_t>(scrape.type);
+        if (family.source == PANEL && type != TYPE_DC) {
+            continue;
+        }
+
+        for (; scrape.channel < CH_CNT; scrape.channel++, scrape.field = 0) {
+            const ChannelNum_t channel = static_cast<ChannelNum_t>(scrape.channel);
+
+            if (family.source == PANEL) {
+                if (scrape.field == 0 && hasChannel(inv->Statistics(), type, channel)) {
+                    scrape.field = 1;
+                    return printPanelMetric(line, size, scrape.family, scrape.inverter, inv, channel);
+                }
+                continue;
+            }
+
+            while (scrape.field < sizeof(_publishFields) / sizeof(_publishFields[0])) {
+                const FieldId_t fieldId = _publishFields[scrape.field++];
+                if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)
+                    && strcmp(family.name + strlen(METRIC_PREFIX), getMetricName(type, fieldId)) == 0) {
+                    return printFieldMetric(line, size, scrape.family, scrape.inverter, inv, type, channel, fieldId);
+                }
+            }
+        }
+    }
+
+    return -1;
+}
+
+int PrometheusExporter::printInverterMetric(char* line, const size_t size, const uint8_t family, const uint8_t idx, InverterAbstract* inv)
+{
+    const char* name = _families[family].name;
+    const char* labels = _labels[idx];
+
+    switch (family) {
+    case FAMILY_LAST_UPDATE:
+        return snprintf(line, size, "%s{%s} %" PRIu32 "\n", name, labels, inv->Statistics()->getLastUpdate() / 1000);
+    case FAMILY_LIMIT_RELATIVE:
+        return snprintf(line, size, "%s{%s} %f\n", name, labels, inv->SystemConfigPara()->getLimitPercent() / 100.0);
+    case FAMILY_LIMIT_ABSOLUTE:
+        if (inv->DevInfo()->getMaxPower() == 0) {
+            return -1;
+        }
+        return snprintf(line, size, "%s{%s} %f\n", name, labels, inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
+    default:
+        return -1;
+    }
+}
+
+// Renders the bucket at the given index, followed by the +Inf bucket, the sum and the count
+template <typename T, size_t N>
+static int printHistogramLine(char* line, const size_t size, const char* name, const char* labels, const Histogram<T, N>& histogram, const uint8_t index)
+{
+    if (index < N - 1) {
+        uint32_t count = 0;
+        for (size_t i = 0; i <= index; i++) {
+            count += histogram.getCount(i);
+        }
+        return snprintf(line, size, "%s_bucket{%s,le=\"%d\"} %" PRIu32 "\n", name, labels, static_cast<int>(histogram.getLimit(index)), count);
+    }
+    if (index == N - 1) {
+        return snprintf(line, size, "%s_bucket{%s,le=\"+Inf\"} %" PRIu32 "\n", name, labels, histogram.getTotal());
+    }
+    if (index == N) {
+        return snprintf(line, size, "%s_sum{%s} %" PRId64 "\n", name, labels, histogram.getSum());
+    }
+    if (index == N + 1) {
+        return snprintf(line, size, "%s_count{%s} %" PRIu32 "\n", name, labels, histogram.getTotal());
+    }
+    return -1;
+}
+
+int PrometheusExporter::printHistogramMetric(char* line, const size_t size, const uint8_t family, const uint8_t idx, InverterAbstract* inv, const CommandType type, const uint8_t index)
+{
+    const char* name = _families[family].name;
+    const char* labels = _labels[idx];
+
+    switch (family) {
+    case FAMILY_RADIO_RTT: {
+        // Command types which never have been answered are skipped
+        const auto& histogram = inv->getRttHistogram(type);
+        if (histogram.getTotal() == 0) {
+            return -1;
+        }
+        char commandLabels[PROMETHEUS_LABEL_SIZE + 32];
+        snprintf(commandLabels, sizeof(commandLabels), "%s,command=\"%s\"", labels, commandTypeNames[static_cast<uint8_t>(type)]);
+        return printHistogramLine(line, size, name, commandLabels, histogram, index);
+    }
+    case FAMILY_RADIO_RETRANSMITS:
+        return printHistogramLine(line, size, name, labels, inv->getRetransmitHistogram(), index);
+    case FAMILY_RADIO_RSSI:
+        return printHistogramLine(line, size, name, labels, inv->getRssiHistogram(), index);
+    default:
+        return -1;
+    }
+}
+
+int PrometheusExporter::printPanelMetric(char* line, const size_t size, const uint8_t family, const uint8_t idx, InverterAbstract* inv, const ChannelNum_t channel)
+{
+    const char* name = _families[family].name;
+    const char* labels = _labels[idx];
+
+    const auto& config = Configuration.getInverterConfig(inv->serial());
+    if (config == nullptr) {
+        return -1;
+    }
+
+    switch (family) {
+    case FAMILY_PANEL_INFO:
+        return snprintf(line, size, "%s{%s,channel=\"%" PRIu8 "\",panelname=\"%s\"} 1\n", name, labels, channel, config->channel[channel].Name);
+    case FAMILY_PANEL_MAX_POWER:
+        return snprintf(line, size, "%s{%s,channel=\"%" PRIu8 "\"} %" PRIu16 "\n", name, labels, channel, config->channel[channel].MaxChannelPower);
+    case FAMILY_PANEL_YIELD_TOTAL_OFFSET:
+        return snprintf(line, size, "%s{%s,channel=\"%" PRIu8 "\"} %f\n", name, labels, channel, config->channel[channel].YieldTotalOffset);
+    default:
+        return -1;
+    }
+}
+
+int PrometheusExporter::printFieldMetric(char* line, const size_t size, const uint8_t family, const uint8_t idx, InverterAbstract* inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    StatisticsParser* statistics = inv->Statistics();
+
+    return snprintf(line, size, "%s{%s,type=\"%s\",channel=\"%d\"} %.*f\n",
+        _families[family].name,
+        _labels[idx],
+        statistics->getChannelTypeName(type),
+        channel,
+        static_cast<int>(statistics->getChannelFieldDigits(type, channel, fieldId)),
+        statistics->getChannelFieldValue(type, channel, fieldId));
+}
+
+const char* PrometheusExporter::getMetricName(const ChannelType_t type, const FieldId_t fieldId)
+{
+    // The DC power of the inverter is the sum of all panels
+    if (type == TYPE_INV && fieldId == FLD_PDC) {
+        return "PowerDC";
+    }
+    return fields[fieldId];
+}
+
+bool PrometheusExporter::hasChannel(StatisticsParser* statistics, const ChannelType_t type, const ChannelNum_t channel)
+{
+    for (uint8_t f = 0; f < FLD_CNT; f++) {
+        if (statistics->hasChannelFieldValue(type, channel, static_cast<FieldId_t>(f))) {
+            return true;
+        }
+    }
+    return false;
+}
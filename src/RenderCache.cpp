@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "RenderCache.h"
+#include <Arduino.h>
+
+RenderCacheClass RenderCache;
+
+RenderBufferPrint::RenderBufferPrint(std::vector<uint8_t>& buffer)
+    : _buffer(buffer)
+{
+}
+
+size_t RenderBufferPrint::write(uint8_t c)
+{
+    _buffer.push_back(c);
+    return 1;
+}
+
+size_t RenderBufferPrint::write(const uint8_t* buffer, size_t size)
+{
+    _buffer.insert(_buffer.end(), buffer, buffer + size);
+    return size;
+}
+
+RenderBuffer_t RenderCacheClass::get(const uint8_t pos, std::shared_ptr<InverterAbstract> inv, const RenderFormat_t format, const RenderFunction& render)
+{
+    if (pos >= INV_MAX_COUNT) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Entry_t& entry = _entries[pos][static_cast<uint8_t>(format)];
+    const uint32_t generation = inv->Statistics()->getGeneration();
+
+    if (entry.buffer != nullptr
+        && entry.serial == inv->serial()
+        && entry.generation == generation
+        && millis() - entry.renderTime < RENDER_CACHE_MAX_AGE) {
+        _hits++;
+        return entry.buffer;
+    }
+
+    _misses++;
+
+    // Buffers which are still used by clients are not modified, a new one is created instead
+    auto buffer = std::make_shared<std::vector<uint8_t>>();
+    if (entry.buffer != nullptr) {
+        buffer->reserve(entry.buffer->size());
+    }
+
+    RenderBufferPrint out(*buffer);
+    if (!render(out)) {
+        entry.buffer = nullptr;
+        return nullptr;
+    }
+
+    entry.serial = inv->serial();
+    entry.generation = generation;
+    entry.renderTime = millis();
+    entry.buffer = buffer;
+
+    return buffer;
+}
+
+uint32_t RenderCacheClass::getHits() const
+{
+    return _hits;
+}
+
+uint32_t RenderCacheClass::getMisses() const
+{
+    return _misses;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022-2025 Thomas Basler and others
+ */
+#include "SparklineBuffer.h"
+#include <algorithm>
+
+static void mergeBucket(SparklineBucket_t& target, uint32_t& targetWeight, const SparklineBucket_t& source, const uint32_t sourceWeight)
+{
+    if (targetWeight == 0) {
+        target = source;
+    } else {
+        target.min = std::min(target.min, source.min);
+        target.max = std::max(target.max, source.max);
+        target.avg = (target.avg * targetWeight + source.avg * sourceWeight) / (targetWeight + sourceWeight);
+    }
+    targetWeight += sourceWeight;
+}
+
+void SparklineBuffer::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _count = 0;
+}
+
+uint16_t SparklineBuffer::size()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return std::min<uint32_t>(_count, SPARKLINE_CAPACITY);
+}
+
+SparklineBucket_t& SparklineBuffer::bucket(const uint8_t level, const uint32_t index)
+{
+    const uint16_t levelSize = SPARKLINE_CAPACITY >> level;
+    return _buckets[2 * SPARKLINE_CAPACITY - 2 * levelSize + index % levelSize];
+}
+
+void SparklineBuffer::append(const SparklineBucket_t& value)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    bucket(0, _count) = value;
+    _count++;
+
+    // A bucket of level k is complete after every 2^k base buckets. It is
+    // built from its two children, which are still in the level below.
+    for (uint8_t level = 1; level < SPARKLINE_LEVELS; level++) {
+        if (_count & ((1U << level) - 1)) {
+            break;
+        }
+
+        const uint32_t index = (_count >> level) - 1;
+        SparklineBucket_t& target = bucket(level, index);
+        uint32_t weight = 0;
+        mergeBucket(target, weight, bucket(level - 1, 2 * index), 1);
+        mergeBucket(target, weight, bucket(level - 1, 2 * index + 1), 1);
+    }
+}
+
+uint16_t SparklineBuffer::resample(SparklineBucket_t* out, const uint16_t points)
+{
+    if (points == 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uint32_t first = _count - std::min<uint32_t>(_count, SPARKLINE_CAPACITY);
+
+    uint16_t point = 0;
+    for (; point < points; point++) {
+        const uint32_t lo = first + static_cast<uint32_t>(point) * SPARKLINE_CAPACITY / points;
+        const uint32_t hi = std::min(first + static_cast<uint32_t>(point + 1) * SPARKLINE_CAPACITY / points, _count);
+        if (lo >= _count) {
+            break;
+        }
+
+        SparklineBucket_t& target = out[point];
+        uint32_t weight = 0;
+
+        // Cover exactly the base buckets of the point with the largest
+        // complete buckets which are aligned and fit into the remaining
+        // range. The edges are built from finer levels down to single base
+        // buckets, so nothing outside the point and the window is merged.
+        for (uint32_t index = lo; index < hi;) {
+            uint8_t level = SPARKLINE_LEVELS - 1;
+            while (level > 0 && ((index & ((1U << level) - 1)) != 0 || index + (1U << level) > hi)) {
+                level--;
+            }
+
+            mergeBucket(target, weight, bucket(level, index >> level), 1U << level);
+            index += 1U << level;
+        }
+    }
+
+    return point;
+}
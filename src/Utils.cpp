@@ -125,3 +125,13 @@ void Utils::skipBom(File& f)
         f.read();
     }
 }
+
+uint32_t Utils::fnv1a(const void* data, const size_t len, uint32_t hash)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
@@ -4,6 +4,7 @@
  */
 #include "WebApi_dtu.h"
 #include "Configuration.h"
+#include "MqttHandleHass.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include <AsyncJson.h>
@@ -35,6 +36,12 @@ void WebApiDtuClass::applyDataTaskCb()
     Hoymiles.getRadioCmt()->setCountryMode(static_cast<CountryModeId_t>(config.Dtu.Cmt.CountryMode));
     Hoymiles.getRadioCmt()->setInverterTargetFrequency(config.Dtu.Cmt.Frequency);
     Hoymiles.setPollInterval(config.Dtu.PollInterval);
+    Hoymiles.setAdaptivePolling(config.Dtu.AdaptivePoll.Enabled, config.Dtu.AdaptivePoll.MinInterval, config.Dtu.AdaptivePoll.MaxInterval);
+
+    if (_hassUpdate) {
+        MqttHandleHass.forceUpdate();
+        _hassUpdate = false;
+    }
 }
 
 void WebApiDtuClass::onDtuAdminGet(AsyncWebServerRequest* request)
@@ -54,6 +61,11 @@ void WebApiDtuClass::onDtuAdminGet(AsyncWebServerRequest* request)
         static_cast<uint32_t>(config.Dtu.Serial & 0xFFFFFFFF));
     root["serial"] = buffer;
     root["pollinterval"] = config.Dtu.PollInterval;
+    root["adaptivepoll"] = config.Dtu.AdaptivePoll.Enabled;
+    root["pollinterval_min"] = config.Dtu.AdaptivePoll.MinInterval;
+    root["pollinterval_max"] = config.Dtu.AdaptivePoll.MaxInterval;
+    root["history_enabled"] = config.History.Enabled;
+    root["history_interval"] = config.History.Interval;
     root["nrf_enabled"] = Hoymiles.getRadioNrf()->isInitialized();
     root["nrf_palevel"] = config.Dtu.Nrf.PaLevel;
     root["cmt_enabled"] = Hoymiles.getRadioCmt()->isInitialized();
@@ -92,6 +104,11 @@ void WebApiDtuClass::onDtuAdminPost(AsyncWebServerRequest* request)
 
     if (!(root["serial"].is<String>()
             && root["pollinterval"].is<uint32_t>()
+            && root["adaptivepoll"].is<bool>()
+            && root["pollinterval_min"].is<uint32_t>()
+            && root["pollinterval_max"].is<uint32_t>()
+            && root["history_enabled"].is<bool>()
+            && root["history_interval"].is<uint32_t>()
             && root["nrf_palevel"].is<uint8_t>()
             && root["cmt_palevel"].is<int8_t>()
             && root["cmt_frequency"].is<uint32_t>()
@@ -119,6 +136,23 @@ void WebApiDtuClass::onDtuAdminPost(AsyncWebServerRequest* request)
         return;
     }
 
+    if (root["pollinterval_min"].as<uint32_t>() == 0
+        || root["pollinterval_max"].as<uint32_t>() < root["pollinterval_min"].as<uint32_t>()) {
+        retMsg["message"] = "Maximum poll interval must be greater or equal minimum poll interval!";
+        retMsg["code"] = WebApiError::DtuInvalidPollRange;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    if (root["history_interval"].as<uint32_t>() < 60 || root["history_interval"].as<uint32_t>() > 3600) {
+        retMsg["message"] = "History interval must between 60 and 3600 seconds!";
+        retMsg["code"] = WebApiError::DtuInvalidHistoryInterval;
+        retMsg["param"]["min"] = 60;
+        retMsg["param"]["max"] = 3600;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
     if (root["nrf_palevel"].as<uint8_t>() > 3) {
         retMsg["message"] = "Invalid power level setting!";
         retMsg["code"] = WebApiError::DtuInvalidPowerLevel;
@@ -156,8 +190,20 @@ void WebApiDtuClass::onDtuAdminPost(AsyncWebServerRequest* request)
     {
         auto guard = Configuration.getWriteGuard();
         auto& config = guard.getConfig();
+
+        // The expire time of the Home Assistant sensors depends on the poll intervals
+        _hassUpdate = _hassUpdate
+            || config.Dtu.PollInterval != root["pollinterval"].as<uint32_t>()
+            || config.Dtu.AdaptivePoll.Enabled != root["adaptivepoll"].as<bool>()
+            || config.Dtu.AdaptivePoll.MaxInterval != root["pollinterval_max"].as<uint32_t>();
+
         config.Dtu.Serial = serial;
         config.Dtu.PollInterval = root["pollinterval"].as<uint32_t>();
+        config.Dtu.AdaptivePoll.Enabled = root["adaptivepoll"].as<bool>();
+        config.Dtu.AdaptivePoll.MinInterval = root["pollinterval_min"].as<uint32_t>();
+        config.Dtu.AdaptivePoll.MaxInterval = root["pollinterval_max"].as<uint32_t>();
+        config.History.Enabled = root["history_enabled"].as<bool>();
+        config.History.Interval = root["history_interval"].as<uint32_t>();
         config.Dtu.Nrf.PaLevel = root["nrf_palevel"].as<uint8_t>();
         config.Dtu.Cmt.PaLevel = root["cmt_palevel"].as<int8_t>();
         config.Dtu.Cmt.Frequency = root["cmt_frequency"].as<uint32_t>();
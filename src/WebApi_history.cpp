@@ -0,0 +1,272 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022-2025 Thomas Basler and others
+ */
+#include "WebApi_history.h"
+#include "WebApi.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+#undef TAG
+static const char* TAG = "webapi";
+
+static const char* const resolutionNames[] = { "raw", "hour", "day" };
+
+void WebApiHistoryClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/history", HTTP_GET, std::bind(&WebApiHistoryClass::onHistoryGet, this, _1));
+}
+
+void WebApiHistoryClass::onHistoryGet(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    const uint64_t serial = WebApi.parseSerialFromRequest(request);
+    if (serial == 0) {
+        request->send(400, "text/plain", "Inverter serial missing");
+        return;
+    }
+
+    Resolution_t resolution = RESOLUTION_RAW;
+    if (request->hasParam("res")) {
+        const String res = request->getParam("res")->value();
+        if (res == "hour") {
+            resolution = RESOLUTION_HOUR;
+        } else if (res == "day") {
+            resolution = RESOLUTION_DAY;
+        } else if (res != "raw") {
+            request->send(400, "text/plain", "Invalid resolution");
+            return;
+        }
+    }
+
+    uint32_t to = std::time(nullptr);
+    if (request->hasParam("to")) {
+        to = strtoul(request->getParam("to")->value().c_str(), NULL, 10);
+    }
+
+    uint32_t from = to > SECONDS_PER_DAY ? to - SECONDS_PER_DAY : 0;
+    if (request->hasParam("from")) {
+        from = strtoul(request->getParam("from")->value().c_str(), NULL, 10);
+    }
+
+    try {
+        auto query = std::make_shared<Query_t>();
+        query->serial = serial;
+        query->from = from;
+        query->to = to;
+        query->resolution = resolution;
+
+        AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+            [this, query](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                return fillChunk(*query, buffer, maxLen);
+            });
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+
+    } catch (std::bad_alloc& bad_alloc) {
+        ESP_LOGE(TAG, "Call to /api/history temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
+
+        WebApi.sendTooManyRequests(request);
+    }
+}
+
+size_t WebApiHistoryClass::fillChunk(Query_t& query, uint8_t* buffer, const size_t maxLen)
+{
+    size_t written = 0;
+    while (written < maxLen) {
+        if (query.linePos >= query.lineLen) {
+            query.lineLen = 0;
+            query.linePos = 0;
+            if (!nextLine(query)) {
+                break;
+            }
+        }
+
+        const size_t len = std::min(maxLen - written, query.lineLen - query.linePos);
+        memcpy(buffer + written, query.line + query.linePos, len);
+        written += len;
+        query.linePos += len;
+    }
+    return written;
+}
+
+bool WebApiHistoryClass::nextLine(Query_t& query)
+{
+    while (query.lineLen == 0) {
+        // Samples of the current block are emitted before the next block is read
+        if (query.inBlock) {
+            const size_t len = query.dataPos < query.header.length
+                ? History.decodeSample(query.data + query.dataPos, query.header.length - query.dataPos, query.sample, query.header.channels)
+                : 0;
+
+            if (len == 0) {
+                query.inBlock = false;
+            } else {
+                query.dataPos += len;
+                if (query.sample.time >= query.from && query.sample.time <= query.to) {
+                    query.lineLen = printSample(query);
+                }
+            }
+            continue;
+        }
+
+        switch (query.stage) {
+        case STAGE_HEADER: {
+            char serial[sizeof(uint64_t) * 8 + 1];
+            snprintf(serial, sizeof(serial), "%0" PRIx32 "%08" PRIx32,
+                static_cast<uint32_t>((query.serial >> 32) & 0xFFFFFFFF),
+                static_cast<uint32_t>(query.serial & 0xFFFFFFFF));
+
+            query.lineLen = snprintf(query.line, sizeof(query.line), "{\"serial\":\"%s\",\"resolution\":\"%s\",\"values\":[",
+                serial, resolutionNames[query.resolution]);
+
+            if (query.resolution == RESOLUTION_DAY) {
+                if (LittleFS.exists(HISTORY_DAILY_FILE)) {
+                    query.file = LittleFS.open(HISTORY_DAILY_FILE, "r");
+                }
+            } else {
+                // Older segments were already removed by the rotation
+                query.day = std::max(query.from / SECONDS_PER_DAY, query.to / SECONDS_PER_DAY - HISTORY_SEGMENT_DAYS);
+            }
+            query.stage = STAGE_FILES;
+            break;
+        }
+
+        case STAGE_FILES:
+            if (query.resolution == RESOLUTION_DAY) {
+                HistoryDaily_t daily;
+                if (!query.file || query.file.read(reinterpret_cast<uint8_t*>(&daily), sizeof(daily)) != sizeof(daily)) {
+                    query.file.close();
+                    query.stage = STAGE_PENDING;
+                } else if (daily.serial == query.serial
+                    && daily.day >= query.from / SECONDS_PER_DAY && daily.day <= query.to / SECONDS_PER_DAY) {
+                    query.lineLen = printDaily(query, daily);
+                }
+            } else if (!readSegmentBlock(query)) {
+                query.stage = STAGE_PENDING;
+            }
+            break;
+
+        case STAGE_PENDING: {
+            // Data of the current hour which is not written to flash yet
+            query.stage = STAGE_FOOTER;
+
+            if (query.resolution == RESOLUTION_RAW) {
+                if (History.getPendingBlock(query.serial, query.header, query.data)) {
+                    query.sample = {};
+                    query.sample.time = query.header.start;
+                    query.dataPos = 0;
+                    query.inBlock = true;
+                }
+            } else if (query.resolution == RESOLUTION_HOUR) {
+                uint32_t start;
+                HistoryHourly_t hourly;
+                if (History.getPendingHourly(query.serial, start, hourly) && start >= query.from && start <= query.to) {
+                    query.lineLen = printHourly(query, start, hourly);
+                }
+            }
+            break;
+        }
+
+        case STAGE_FOOTER:
+            query.lineLen = snprintf(query.line, sizeof(query.line), "]}");
+            query.stage = STAGE_DONE;
+            break;
+
+        case STAGE_DONE:
+        default:
+            return false;
+        }
+    }
+
+    query.lineLen = std::min(query.lineLen, sizeof(query.line) - 1);
+    return true;
+}
+
+bool WebApiHistoryClass::readSegmentBlock(Query_t& query)
+{
+    const uint8_t type = query.resolution == RESOLUTION_RAW ? HISTORY_BLOCK_SAMPLES : HISTORY_BLOCK_HOURLY;
+
+    while (true) {
+        if (!query.file) {
+            if (query.day > query.to / SECONDS_PER_DAY) {
+                return false;
+            }
+
+            const String path = History.getSegmentPath(query.day++);
+            if (LittleFS.exists(path)) {
+                query.file = LittleFS.open(path, "r");
+            }
+            continue;
+        }
+
+        if (query.file.read(reinterpret_cast<uint8_t*>(&query.header), sizeof(query.header)) != sizeof(query.header)
+            || query.header.length > HISTORY_BLOCK_SIZE) {
+            query.file.close();
+            continue;
+        }
+
+        if (query.header.serial != query.serial || query.header.type != type) {
+            query.file.seek(query.header.length, SeekCur);
+            continue;
+        }
+
+        if (query.file.read(query.data, query.header.length) != query.header.length) {
+            query.file.close();
+            continue;
+        }
+
+        if (type == HISTORY_BLOCK_SAMPLES) {
+            query.sample = {};
+            query.sample.time = query.header.start;
+            query.dataPos = 0;
+            query.inBlock = true;
+        } else if (query.header.length == sizeof(HistoryHourly_t)
+            && query.header.start >= query.from && query.header.start <= query.to) {
+            HistoryHourly_t hourly;
+            memcpy(&hourly, query.data, sizeof(hourly));
+            query.lineLen = printHourly(query, query.header.start, hourly);
+        }
+        return true;
+    }
+}
+
+int WebApiHistoryClass::printSample(Query_t& query)
+{
+    const HistorySample_t& sample = query.sample;
+
+    int len = snprintf(query.line, sizeof(query.line), "%s[%" PRIu32 ",%.1f,%" PRId32,
+        query.firstRow ? "" : ",", sample.time, sample.acPower / 10.0f, sample.yieldTotal);
+
+    for (uint8_t c = 0; c < query.header.channels && c < INV_MAX_CHAN_COUNT; c++) {
+        len += snprintf(query.line + len, sizeof(query.line) - len, ",%.1f", sample.dcPower[c] / 10.0f);
+    }
+    len += snprintf(query.line + len, sizeof(query.line) - len, "]");
+
+    query.firstRow = false;
+    return len;
+}
+
+int WebApiHistoryClass::printHourly(Query_t& query, const uint32_t start, const HistoryHourly_t& hourly)
+{
+    const int len = snprintf(query.line, sizeof(query.line), "%s[%" PRIu32 ",%.1f,%.1f,%" PRIu32 "]",
+        query.firstRow ? "" : ",", start, hourly.acPowerAvg / 10.0f, hourly.acPowerMax / 10.0f, static_cast<uint32_t>(hourly.energy));
+
+    query.firstRow = false;
+    return len;
+}
+
+int WebApiHistoryClass::printDaily(Query_t& query, const HistoryDaily_t& daily)
+{
+    const int len = snprintf(query.line, sizeof(query.line), "%s[%" PRIu32 ",%.1f,%" PRIu32 "]",
+        query.firstRow ? "" : ",", static_cast<uint32_t>(daily.day * SECONDS_PER_DAY), daily.acPowerMax / 10.0f, static_cast<uint32_t>(daily.energy));
+
+    query.firstRow = false;
+    return len;
+}
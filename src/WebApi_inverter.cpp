@@ -4,6 +4,7 @@
  */
 #include "WebApi_inverter.h"
 #include "Configuration.h"
+#include "Datastore.h"
 #include "MqttHandleHass.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
@@ -153,6 +154,7 @@ void WebApiInverterClass::onInverterAdd(AsyncWebServerRequest* request)
     }
 
     MqttHandleHass.forceUpdate();
+    Datastore.forceUpdate();
 }
 
 void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
@@ -279,6 +281,7 @@ void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
     }
 
     MqttHandleHass.forceUpdate();
+    Datastore.forceUpdate();
 }
 
 void WebApiInverterClass::onInverterDelete(AsyncWebServerRequest* request)
@@ -321,6 +324,7 @@ void WebApiInverterClass::onInverterDelete(AsyncWebServerRequest* request)
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
     MqttHandleHass.forceUpdate();
+    Datastore.forceUpdate();
 }
 
 void WebApiInverterClass::onInverterOrder(AsyncWebServerRequest* request)
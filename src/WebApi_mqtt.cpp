@@ -46,6 +46,11 @@ void WebApiMqttClass::onMqttStatus(AsyncWebServerRequest* request)
     root["mqtt_lwt_topic"] = String(config.Mqtt.Topic) + config.Mqtt.Lwt.Topic;
     root["mqtt_publish_interval"] = config.Mqtt.PublishInterval;
     root["mqtt_clean_session"] = config.Mqtt.CleanSession;
+    root["mqtt_payload_mode"] = config.Mqtt.PayloadMode;
+    root["mqtt_onchange_enabled"] = config.Mqtt.OnChange.Enabled;
+    root["mqtt_onchange_maxage"] = config.Mqtt.OnChange.MaxAge;
+    root["mqtt_onchange_deadband"] = config.Mqtt.OnChange.Deadband;
+    root["mqtt_onchange_deadband_absolute"] = config.Mqtt.OnChange.DeadbandAbsolute;
     root["mqtt_hass_enabled"] = config.Mqtt.Hass.Enabled;
     root["mqtt_hass_expire"] = config.Mqtt.Hass.Expire;
     root["mqtt_hass_retain"] = config.Mqtt.Hass.Retain;
@@ -84,6 +89,11 @@ void WebApiMqttClass::onMqttAdminGet(AsyncWebServerRequest* request)
     root["mqtt_lwt_qos"] = config.Mqtt.Lwt.Qos;
     root["mqtt_publish_interval"] = config.Mqtt.PublishInterval;
     root["mqtt_clean_session"] = config.Mqtt.CleanSession;
+    root["mqtt_payload_mode"] = config.Mqtt.PayloadMode;
+    root["mqtt_onchange_enabled"] = config.Mqtt.OnChange.Enabled;
+    root["mqtt_onchange_maxage"] = config.Mqtt.OnChange.MaxAge;
+    root["mqtt_onchange_deadband"] = config.Mqtt.OnChange.Deadband;
+    root["mqtt_onchange_deadband_absolute"] = config.Mqtt.OnChange.DeadbandAbsolute;
     root["mqtt_hass_enabled"] = config.Mqtt.Hass.Enabled;
     root["mqtt_hass_expire"] = config.Mqtt.Hass.Expire;
     root["mqtt_hass_retain"] = config.Mqtt.Hass.Retain;
@@ -125,6 +135,11 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
             && root["mqtt_lwt_qos"].is<uint8_t>()
             && root["mqtt_publish_interval"].is<uint32_t>()
             && root["mqtt_clean_session"].is<bool>()
+            && root["mqtt_payload_mode"].is<uint8_t>()
+            && root["mqtt_onchange_enabled"].is<bool>()
+            && root["mqtt_onchange_maxage"].is<uint32_t>()
+            && root["mqtt_onchange_deadband"].is<float>()
+            && root["mqtt_onchange_deadband_absolute"].is<float>()
             && root["mqtt_hass_enabled"].is<bool>()
             && root["mqtt_hass_expire"].is<bool>()
             && root["mqtt_hass_retain"].is<bool>()
@@ -253,6 +268,43 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
             return;
         }
 
+        if (root["mqtt_payload_mode"].as<uint8_t>() >= MqttPayloadMode_t::PayloadMode_Max) {
+            retMsg["message"] = "Invalid payload format!";
+            retMsg["code"] = WebApiError::MqttPayloadMode;
+            retMsg["param"]["max"] = MqttPayloadMode_t::PayloadMode_Max - 1;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
+
+        if (root["mqtt_onchange_enabled"].as<bool>()) {
+            if (root["mqtt_onchange_maxage"].as<uint32_t>() < root["mqtt_publish_interval"].as<uint32_t>() || root["mqtt_onchange_maxage"].as<uint32_t>() > 86400) {
+                retMsg["message"] = "Max age must be a number between the publish interval and 86400!";
+                retMsg["code"] = WebApiError::MqttOnChangeMaxAge;
+                retMsg["param"]["min"] = root["mqtt_publish_interval"].as<uint32_t>();
+                retMsg["param"]["max"] = 86400;
+                WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+                return;
+            }
+
+            if (root["mqtt_onchange_deadband"].as<float>() < 0 || root["mqtt_onchange_deadband"].as<float>() > 100) {
+                retMsg["message"] = "Deadband must be a number between 0 and 100!";
+                retMsg["code"] = WebApiError::MqttOnChangeDeadband;
+                retMsg["param"]["min"] = 0;
+                retMsg["param"]["max"] = 100;
+                WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+                return;
+            }
+
+            if (root["mqtt_onchange_deadband_absolute"].as<float>() < 0 || root["mqtt_onchange_deadband_absolute"].as<float>() > 1000) {
+                retMsg["message"] = "Absolute deadband must be a number between 0 and 1000!";
+                retMsg["code"] = WebApiError::MqttOnChangeDeadbandAbsolute;
+                retMsg["param"]["min"] = 0;
+                retMsg["param"]["max"] = 1000;
+                WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+                return;
+            }
+        }
+
         if (root["mqtt_hass_enabled"].as<bool>()) {
             if (root["mqtt_hass_topic"].as<String>().length() > MQTT_MAX_TOPIC_STRLEN) {
                 retMsg["message"] = "Hass topic must not be longer than " STR(MQTT_MAX_TOPIC_STRLEN) " characters!";
@@ -293,6 +345,11 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
         config.Mqtt.Lwt.Qos = root["mqtt_lwt_qos"].as<uint8_t>();
         config.Mqtt.PublishInterval = root["mqtt_publish_interval"].as<uint32_t>();
         config.Mqtt.CleanSession = root["mqtt_clean_session"].as<bool>();
+        config.Mqtt.PayloadMode = root["mqtt_payload_mode"].as<uint8_t>();
+        config.Mqtt.OnChange.Enabled = root["mqtt_onchange_enabled"].as<bool>();
+        config.Mqtt.OnChange.MaxAge = root["mqtt_onchange_maxage"].as<uint32_t>();
+        config.Mqtt.OnChange.Deadband = root["mqtt_onchange_deadband"].as<float>();
+        config.Mqtt.OnChange.DeadbandAbsolute = root["mqtt_onchange_deadband_absolute"].as<float>();
         config.Mqtt.Hass.Enabled = root["mqtt_hass_enabled"].as<bool>();
         config.Mqtt.Hass.Expire = root["mqtt_hass_expire"].as<bool>();
         config.Mqtt.Hass.Retain = root["mqtt_hass_retain"].as<bool>();
@@ -312,6 +369,8 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
     MqttSettings.performReconnect();
+
+    // Also covers the expire time of the sensors which depends on the publish interval and the on change settings
     MqttHandleHass.forceUpdate();
 }
 
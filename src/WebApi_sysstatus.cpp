@@ -6,6 +6,8 @@
 #include "Configuration.h"
 #include "NetworkSettings.h"
 #include "PinMapping.h"
+#include "RenderCache.h"
+#include "Utils.h"
 #include "WebApi.h"
 #include "__compiled_constants.h"
 #include <AsyncJson.h>
@@ -53,9 +55,9 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
     root["flashsize"] = ESP.getFlashChipSize();
 
     JsonArray taskDetails = root["task_details"].to<JsonArray>();
-    static std::array<char const*, 12> constexpr task_names = {
+    static std::array<char const*, 13> constexpr task_names = {
         "IDLE0", "IDLE1", "wifi", "tiT", "loopTask", "async_tcp", "mqttclient",
-        "HUAWEI_CAN_0", "PM:SDM", "PM:HTTP+JSON", "PM:SML", "PM:HTTP+SML"
+        "hoymiles", "HUAWEI_CAN_0", "PM:SDM", "PM:HTTP+JSON", "PM:SML", "PM:HTTP+SML"
     };
     for (char const* task_name : task_names) {
         TaskHandle_t const handle = xTaskGetHandle(task_name);
@@ -93,5 +95,24 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
     root["cmt_configured"] = PinMapping.isValidCmt2300Config();
     root["cmt_connected"] = Hoymiles.getRadioCmt()->isConnected();
 
+    // Limits of the loop latency buckets in us
+    JsonObject latency = root["radio_latency"].to<JsonObject>();
+    Utils::addHistogram(latency["nrf"].to<JsonObject>(), Hoymiles.getRadioNrf()->getLoopLatency());
+    Utils::addHistogram(latency["cmt"].to<JsonObject>(), Hoymiles.getRadioCmt()->getLoopLatency());
+#ifdef HOYMILES_RADIO_SIM
+    Utils::addHistogram(latency["sim"].to<JsonObject>(), Hoymiles.getRadioSim()->getLoopLatency());
+#endif
+
+    // Time in ms required to poll all inverters of a radio once
+    JsonObject cycleTime = root["radio_cycle_time"].to<JsonObject>();
+    cycleTime["nrf"] = Hoymiles.getRadioNrf()->Scheduler()->getCycleTime();
+    cycleTime["cmt"] = Hoymiles.getRadioCmt()->Scheduler()->getCycleTime();
+#ifdef HOYMILES_RADIO_SIM
+    cycleTime["sim"] = Hoymiles.getRadioSim()->Scheduler()->getCycleTime();
+#endif
+
+    root["render_cache"]["hits"] = RenderCache.getHits();
+    root["render_cache"]["misses"] = RenderCache.getMisses();
+
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
@@ -18,6 +18,7 @@ static const char* TAG = "webapi";
 
 WebApiWsLiveClass::WebApiWsLiveClass()
     : _ws("/livedata")
+    , _wsDelta("/livedata/delta")
     , _wsCleanupTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&WebApiWsLiveClass::wsCleanupTaskCb, this))
     , _sendDataTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&WebApiWsLiveClass::sendDataTaskCb, this))
 {
@@ -37,6 +38,9 @@ void WebApiWsLiveClass::init(AsyncWebServer& server, Scheduler& scheduler)
     server.addHandler(&_ws);
     _ws.onEvent(std::bind(&WebApiWsLiveClass::onWebsocketEvent, this, _1, _2, _3, _4, _5, _6));
 
+    server.addHandler(&_wsDelta);
+    _wsDelta.onEvent(std::bind(&WebApiWsLiveClass::onWebsocketEvent, this, _1, _2, _3, _4, _5, _6));
+
     scheduler.addTask(_wsCleanupTask);
     _wsCleanupTask.enable();
 
@@ -51,6 +55,7 @@ void WebApiWsLiveClass::init(AsyncWebServer& server, Scheduler& scheduler)
 void WebApiWsLiveClass::reload()
 {
     _ws.removeMiddleware(&_simpleDigestAuth);
+    _wsDelta.removeMiddleware(&_simpleDigestAuth);
 
     auto const& config = Configuration.get();
 
@@ -58,23 +63,27 @@ void WebApiWsLiveClass::reload()
         return;
     }
 
-    _ws.enable(false);
     _simpleDigestAuth.setPassword(config.Security.Password);
-    _ws.addMiddleware(&_simpleDigestAuth);
-    _ws.closeAll();
-    _ws.enable(true);
+
+    for (auto ws : { &_ws, &_wsDelta }) {
+        ws->enable(false);
+        ws->addMiddleware(&_simpleDigestAuth);
+        ws->closeAll();
+        ws->enable(true);
+    }
 }
 
 void WebApiWsLiveClass::wsCleanupTaskCb()
 {
     // see: https://github.com/me-no-dev/ESPAsyncWebServer#limiting-the-number-of-web-socket-clients
     _ws.cleanupClients();
+    _wsDelta.cleanupClients();
 }
 
 void WebApiWsLiveClass::sendDataTaskCb()
 {
     // do nothing if no WS client is connected
-    if (_ws.count() == 0) {
+    if (_ws.count() == 0 && _wsDelta.count() == 0) {
         return;
     }
 
@@ -94,24 +103,37 @@ void WebApiWsLiveClass::sendDataTaskCb()
 
         try {
             std::lock_guard<std::mutex> lock(_mutex);
-            JsonDocument root;
-            JsonVariant var = root;
 
-            auto invArray = var["inverters"].to<JsonArray>();
-            auto invObject = invArray.add<JsonObject>();
+            if (_ws.count() > 0) {
+                // All clients share the same buffer
+                auto buffer = RenderCache.get(i, inv, RenderFormat_t::LiveJson,
+                    [inv](Print& out) { return renderLiveJson(out, inv); });
 
-            generateCommonJsonResponse(var);
-            generateInverterCommonJsonResponse(invObject, inv);
-            generateInverterChannelJsonResponse(invObject, inv);
-
-            if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
-                continue;
+                if (buffer != nullptr) {
+                    _ws.textAll(buffer);
+                }
             }
 
-            String buffer;
-            serializeJson(root, buffer);
+            if (_wsDelta.count() > 0) {
+                JsonDocument root;
+                JsonVariant var = root;
+
+                auto invArray = var["inverters"].to<JsonArray>();
+                auto invObject = invArray.add<JsonObject>();
+
+                generateCommonJsonResponse(var);
+                LiveDataJson::generateInverterDeltaJsonResponse(invObject, inv, _deltaState[i]);
 
-            _ws.textAll(buffer);
+                if (Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+                    String buffer;
+                    serializeJson(root, buffer);
+
+                    _wsDelta.textAll(buffer);
+                } else {
+                    // Send all fields with the next update
+                    _deltaState[i].serial = 0;
+                }
+            }
 
         } catch (const std::bad_alloc& bad_alloc) {
             ESP_LOGE(TAG, "Call to /api/livedata/status temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
@@ -121,6 +143,59 @@ void WebApiWsLiveClass::sendDataTaskCb()
     }
 }
 
+bool WebApiWsLiveClass::renderLiveJson(Print& out, std::shared_ptr<InverterAbstract> inv)
+{
+    JsonDocument root;
+    JsonVariant var = root;
+
+    auto invArray = var["inverters"].to<JsonArray>();
+    auto invObject = invArray.add<JsonObject>();
+
+    generateCommonJsonResponse(var);
+    LiveDataJson::generateInverterCommonJsonResponse(invObject, inv);
+    LiveDataJson::generateInverterRadioJsonResponse(invObject, inv);
+    LiveDataJson::generateInverterChannelJsonResponse(invObject, inv);
+
+    if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+        return false;
+    }
+
+    serializeJson(root, out);
+    return true;
+}
+
+bool WebApiWsLiveClass::renderListJson(Print& out, std::shared_ptr<InverterAbstract> inv)
+{
+    JsonDocument root;
+    JsonObject invObject = root.to<JsonObject>();
+
+    LiveDataJson::generateInverterCommonJsonResponse(invObject, inv);
+
+    if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+        return false;
+    }
+
+    serializeJson(root, out);
+    return true;
+}
+
+void WebApiWsLiveClass::sendRenderBuffer(AsyncWebServerRequest* request, RenderBuffer_t buffer)
+{
+    if (buffer == nullptr) {
+        WebApi.sendTooManyRequests(request);
+        return;
+    }
+
+    // The callback keeps the buffer alive until the response was sent
+    auto response = request->beginResponse("application/json", buffer->size(),
+        [buffer](uint8_t* out, size_t maxLen, size_t index) -> size_t {
+            const size_t len = std::min(maxLen, buffer->size() - index);
+            memcpy(out, buffer->data() + index, len);
+            return len;
+        });
+    request->send(response);
+}
+
 void WebApiWsLiveClass::generateCommonJsonResponse(JsonVariant& root)
 {
     auto totalObj = root["total"].to<JsonObject>();
@@ -137,109 +212,67 @@ void WebApiWsLiveClass::generateCommonJsonResponse(JsonVariant& root)
     hintObj["pin_mapping_issue"] = PIN_MAPPING_REQUIRED && !PinMapping.isMappingSelected();
 }
 
-void WebApiWsLiveClass::generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+void WebApiWsLiveClass::addTotalField(JsonObject& root, const String& name, const float value, const String& unit, const uint8_t digits)
 {
-    const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
-    if (inv_cfg == nullptr) {
-        return;
-    }
-
-    root["serial"] = inv->serialString();
-    root["name"] = inv->name();
-    root["order"] = inv_cfg->Order;
-    root["data_age"] = (millis() - inv->Statistics()->getLastUpdate()) / 1000;
-    root["data_age_ms"] = millis() - inv->Statistics()->getLastUpdate();
-    root["poll_enabled"] = inv->getEnablePolling();
-    root["reachable"] = inv->isReachable();
-    root["producing"] = inv->isProducing();
-    root["limit_relative"] = inv->SystemConfigPara()->getLimitPercent();
-    if (inv->DevInfo()->getMaxPower() > 0) {
-        root["limit_absolute"] = inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0;
-    } else {
-        root["limit_absolute"] = -1;
-    }
-    root["radio_stats"]["tx_request"] = inv->RadioStats.TxRequestData;
-    root["radio_stats"]["tx_re_request"] = inv->RadioStats.TxReRequestFragment;
-    root["radio_stats"]["rx_success"] = inv->RadioStats.RxSuccess;
-    root["radio_stats"]["rx_fail_nothing"] = inv->RadioStats.RxFailNoAnswer;
-    root["radio_stats"]["rx_fail_partial"] = inv->RadioStats.RxFailPartialAnswer;
-    root["radio_stats"]["rx_fail_corrupt"] = inv->RadioStats.RxFailCorruptData;
-    root["radio_stats"]["rssi"] = inv->getLastRssi();
+    root[name]["v"] = value;
+    root[name]["u"] = unit;
+    root[name]["d"] = digits;
 }
 
-void WebApiWsLiveClass::generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+void WebApiWsLiveClass::sendSnapshot(AsyncWebSocketClient* client)
 {
-    const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
-    if (inv_cfg == nullptr) {
-        return;
-    }
+    // Complete data of each inverter in the default format plus the ids of all fields
+    try {
+        std::lock_guard<std::mutex> lock(_mutex);
 
-    // Loop all channels
-    for (auto& t : inv->Statistics()->getChannelTypes()) {
-        auto chanTypeObj = root[inv->Statistics()->getChannelTypeName(t)].to<JsonObject>();
-        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-            if (t == TYPE_DC) {
-                chanTypeObj[String(static_cast<uint8_t>(c))]["name"]["u"] = inv_cfg->channel[c].Name;
-            }
-            addField(chanTypeObj, inv, t, c, FLD_PAC);
-            addField(chanTypeObj, inv, t, c, FLD_UAC);
-            addField(chanTypeObj, inv, t, c, FLD_IAC);
-            if (t == TYPE_INV) {
-                addField(chanTypeObj, inv, t, c, FLD_PDC, "Power DC");
-            } else {
-                addField(chanTypeObj, inv, t, c, FLD_PDC);
+        // The delta state of the other clients may contain values which differ from the
+        // snapshot. Send all fields with the next update to bring every client in sync.
+        for (auto& state : _deltaState) {
+            state.serial = 0;
+        }
+
+        for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv == nullptr) {
+                continue;
             }
-            addField(chanTypeObj, inv, t, c, FLD_UDC);
-            addField(chanTypeObj, inv, t, c, FLD_IDC);
-            addField(chanTypeObj, inv, t, c, FLD_YD);
-            addField(chanTypeObj, inv, t, c, FLD_YT);
-            addField(chanTypeObj, inv, t, c, FLD_F);
-            addField(chanTypeObj, inv, t, c, FLD_T);
-            addField(chanTypeObj, inv, t, c, FLD_PF);
-            addField(chanTypeObj, inv, t, c, FLD_Q);
-            addField(chanTypeObj, inv, t, c, FLD_EFF);
-            if (t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0) {
-                addField(chanTypeObj, inv, t, c, FLD_IRR);
-                chanTypeObj[String(c)][inv->Statistics()->getChannelFieldName(t, c, FLD_IRR)]["max"] = inv->Statistics()->getStringMaxPower(c);
+
+            JsonDocument root;
+            JsonVariant var = root;
+
+            auto invArray = var["inverters"].to<JsonArray>();
+            auto invObject = invArray.add<JsonObject>();
+            auto fieldIds = invObject["ids"].to<JsonObject>();
+
+            generateCommonJsonResponse(var);
+            LiveDataJson::generateInverterCommonJsonResponse(invObject, inv);
+            LiveDataJson::generateInverterChannelJsonResponse(invObject, inv, &fieldIds);
+
+            if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+                continue;
             }
-        }
-    }
 
-    if (inv->Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
-        root["events"] = inv->EventLog()->getEntryCount();
-    } else {
-        root["events"] = -1;
-    }
-}
+            String buffer;
+            serializeJson(root, buffer);
 
-void WebApiWsLiveClass::addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic)
-{
-    if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
-        String chanName;
-        if (topic == "") {
-            chanName = inv->Statistics()->getChannelFieldName(type, channel, fieldId);
-        } else {
-            chanName = topic;
+            client->text(buffer);
         }
-        String chanNum;
-        chanNum = channel;
-        root[chanNum][chanName]["v"] = inv->Statistics()->getChannelFieldValue(type, channel, fieldId);
-        root[chanNum][chanName]["u"] = inv->Statistics()->getChannelFieldUnit(type, channel, fieldId);
-        root[chanNum][chanName]["d"] = inv->Statistics()->getChannelFieldDigits(type, channel, fieldId);
-    }
-}
 
-void WebApiWsLiveClass::addTotalField(JsonObject& root, const String& name, const float value, const String& unit, const uint8_t digits)
-{
-    root[name]["v"] = value;
-    root[name]["u"] = unit;
-    root[name]["d"] = digits;
+    } catch (const std::bad_alloc& bad_alloc) {
+        ESP_LOGE(TAG, "Call to /livedata/delta temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
+    } catch (const std::exception& exc) {
+        ESP_LOGE(TAG, "Unknown exception in /livedata/delta. Reason: \"%s\".", exc.what());
+    }
 }
 
 void WebApiWsLiveClass::onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len)
 {
     if (type == WS_EVT_CONNECT) {
         ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] connect", server->url(), client->id());
+
+        if (server == &_wsDelta) {
+            sendSnapshot(client);
+        }
     } else if (type == WS_EVT_DISCONNECT) {
         ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] disconnect", server->url(), client->id());
     }
@@ -253,34 +286,59 @@ void WebApiWsLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
 
     try {
         std::lock_guard<std::mutex> lock(_mutex);
-        AsyncJsonResponse* response = new AsyncJsonResponse();
-        auto& root = response->getRoot();
-        auto invArray = root["inverters"].to<JsonArray>();
         auto serial = WebApi.parseSerialFromRequest(request);
 
         if (serial > 0) {
-            auto inv = Hoymiles.getInverterBySerial(serial);
-            if (inv != nullptr) {
-                JsonObject invObject = invArray.add<JsonObject>();
-                generateInverterCommonJsonResponse(invObject, inv);
-                generateInverterChannelJsonResponse(invObject, inv);
+            // Same document as sent by the websocket
+            for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+                auto inv = Hoymiles.getInverterByPos(i);
+                if (inv != nullptr && inv->serial() == serial) {
+                    auto buffer = RenderCache.get(i, inv, RenderFormat_t::LiveJson,
+                        [inv](Print& out) { return renderLiveJson(out, inv); });
+                    sendRenderBuffer(request, buffer);
+                    return;
+                }
             }
-        } else {
+        }
+
+        auto response = request->beginResponseStream("application/json");
+        response->print("{\"inverters\":[");
+
+        if (serial == 0) {
             // Loop all inverters
+            bool first = true;
             for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
                 auto inv = Hoymiles.getInverterByPos(i);
                 if (inv == nullptr) {
                     continue;
                 }
 
-                JsonObject invObject = invArray.add<JsonObject>();
-                generateInverterCommonJsonResponse(invObject, inv);
+                auto buffer = RenderCache.get(i, inv, RenderFormat_t::ListJson,
+                    [inv](Print& out) { return renderListJson(out, inv); });
+                if (buffer == nullptr) {
+                    continue;
+                }
+
+                if (!first) {
+                    response->print(",");
+                }
+                response->write(buffer->data(), buffer->size());
+                first = false;
             }
         }
 
-        generateCommonJsonResponse(root);
+        response->print("],");
+
+        // Append total and hints to the same object
+        JsonDocument root;
+        JsonVariant var = root;
+        generateCommonJsonResponse(var);
+
+        String common;
+        serializeJson(root, common);
+        response->write(reinterpret_cast<const uint8_t*>(common.c_str()) + 1, common.length() - 1);
 
-        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        request->send(response);
 
     } catch (const std::bad_alloc& bad_alloc) {
         ESP_LOGE(TAG, "Call to /api/livedata/status temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
@@ -5,6 +5,7 @@
 #include "Configuration.h"
 #include "Datastore.h"
 #include "Display_Graphic.h"
+#include "History.h"
 #include "I18n.h"
 #include "InverterSettings.h"
 #include "Led_Single.h"
@@ -126,6 +127,7 @@ void setup()
     InverterSettings.init(scheduler);
 
     Datastore.init(scheduler);
+    History.init(scheduler);
     RestartHelper.init(scheduler);
 
     ESP_LOGI(TAG, "Startup complete");
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// Minimal replacement of the Arduino core for the native test environment.
+// Only provides what the libraries in lib/ use. Also included from C sources.
+
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define ARDUINO_ISR_ATTR
+#define IRAM_ATTR
+
+#define RISING 0x01
+#define FALLING 0x02
+
+typedef enum {
+    GPIO_NUM_NC = -1,
+} gpio_num_t;
+
+static inline uint32_t micros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static inline uint32_t millis(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static inline void delayMicroseconds(uint32_t us)
+{
+    struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+static inline void delay(uint32_t ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+static inline void yield(void)
+{
+}
+
+#ifdef __cplusplus
+
+#include "WString.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+using std::max;
+using std::min;
+
+inline int digitalPinToInterrupt(int pin)
+{
+    return pin;
+}
+
+inline void attachInterrupt(int, std::function<void()>, int)
+{
+}
+
+inline bool getLocalTime(struct tm* info, uint32_t = 5000)
+{
+    const time_t now = time(nullptr);
+    localtime_r(&now, info);
+    return true;
+}
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+// Part of newlib on the ESP32, but only of recent glibc versions
+inline size_t strlcpy(char* dst, const char* src, size_t size)
+{
+    const size_t len = strlen(src);
+    if (size > 0) {
+        const size_t n = std::min(len, size - 1);
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// Timing and heap allocation counting for the benchmarks of the native tests.
+// Include it in exactly one source file of a test suite, it replaces the
+// global operator new and delete of the test program.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace Benchmark {
+
+inline std::atomic<size_t> allocations = { 0 };
+
+// Number of heap allocations since the counter was created
+class AllocationCounter {
+public:
+    AllocationCounter()
+        : _start(allocations.load())
+    {
+    }
+
+    size_t count() const { return allocations.load() - _start; }
+
+private:
+    size_t _start;
+};
+
+// Runs func the given number of times and prints the time and heap allocations per call
+template <typename F>
+double run(const char* name, const size_t iterations, F&& func)
+{
+    // Warm up caches and lazily initialized data
+    func();
+
+    const AllocationCounter counter;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        func();
+    }
+    const auto duration = std::chrono::steady_clock::now() - start;
+
+    const double nsPerOp = std::chrono::duration<double, std::nano>(duration).count() / iterations;
+    printf("BENCH %-48s %10.1f ns/op %8.2f allocs/op\n", name, nsPerOp, static_cast<double>(counter.count()) / iterations);
+    return nsPerOp;
+}
+
+// Keeps the compiler from optimizing away a result
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace Benchmark
+
+// Counting replacements of the global allocation functions. They are kept out of
+// line, otherwise GCC pairs the inlined malloc() with free() and warns about it.
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    Benchmark::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size > 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
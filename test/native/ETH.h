@@ -0,0 +1,7 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// There is no Ethernet in the native test environment. CONFIG_ETH_USE_ESP32_EMAC
+// is not defined, therefore the pin mapping only needs the GPIO type of Arduino.h.
+
+#include <Arduino.h>
@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// LittleFS on top of a directory of the host. Block usage and the bytes
+// programmed to flash are estimated like LittleFS does it: every file
+// occupies whole blocks and appending to a file rewrites its last block.
+
+#include <WString.h>
+#include <cstdio>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LITTLEFS_BLOCK_SIZE 4096
+
+// Host only: Bytes written by the files and programmed to flash
+struct LittleFSCounters {
+    size_t written = 0;
+    size_t programmed = 0;
+};
+
+enum SeekMode {
+    SeekSet = SEEK_SET,
+    SeekCur = SEEK_CUR,
+    SeekEnd = SEEK_END,
+};
+
+class File {
+public:
+    File() { }
+
+    File(const std::string& path, const char* mode, LittleFSCounters* counters)
+        : _path(path)
+        , _counters(counters)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            _dir = opendir(path.c_str());
+            return;
+        }
+
+        _f = fopen(path.c_str(), mode[0] == 'r' ? "rb" : mode[0] == 'w' ? "wb" : "ab");
+        if (_f != nullptr) {
+            _startSize = _tail = size();
+        }
+    }
+
+    File(File&& other) { *this = std::move(other); }
+
+    File& operator=(File&& other)
+    {
+        close();
+        _f = other._f;
+        _dir = other._dir;
+        _path = other._path;
+        _counters = other._counters;
+        _startSize = other._startSize;
+        _tail = other._tail;
+        other._f = nullptr;
+        other._dir = nullptr;
+        return *this;
+    }
+
+    ~File() { close(); }
+
+    explicit operator bool() const { return _f != nullptr || _dir != nullptr; }
+
+    size_t read(uint8_t* buffer, const size_t size) { return _f ? fread(buffer, 1, size, _f) : 0; }
+
+    size_t write(const uint8_t* buffer, const size_t size)
+    {
+        if (_f == nullptr) {
+            return 0;
+        }
+        const size_t written = fwrite(buffer, 1, size, _f);
+        _tail += written;
+        return written;
+    }
+
+    bool seek(const uint32_t pos, const SeekMode mode = SeekSet) { return _f && fseek(_f, pos, mode) == 0; }
+
+    size_t size()
+    {
+        if (_f == nullptr) {
+            return 0;
+        }
+        const long pos = ftell(_f);
+        fseek(_f, 0, SEEK_END);
+        const long size = ftell(_f);
+        fseek(_f, pos, SEEK_SET);
+        return size;
+    }
+
+    bool isDirectory() const { return _dir != nullptr; }
+
+    const char* name() const { return _path.c_str() + _path.rfind('/') + 1; }
+
+    File openNextFile()
+    {
+        dirent* entry;
+        while ((entry = readdir(_dir)) != nullptr && entry->d_name[0] == '.') { }
+        if (entry == nullptr) {
+            return File();
+        }
+        return File(_path + "/" + entry->d_name, "r", _counters);
+    }
+
+    void close()
+    {
+        if (_f != nullptr) {
+            // All blocks from the one containing the old end of the file are written again
+            if (_tail > _startSize && _counters != nullptr) {
+                const size_t first = _startSize / LITTLEFS_BLOCK_SIZE;
+                const size_t last = (_tail - 1) / LITTLEFS_BLOCK_SIZE;
+                _counters->written += _tail - _startSize;
+                _counters->programmed += (last - first + 1) * LITTLEFS_BLOCK_SIZE;
+            }
+            fclose(_f);
+        }
+        if (_dir != nullptr) {
+            closedir(_dir);
+        }
+        _f = nullptr;
+        _dir = nullptr;
+    }
+
+private:
+    FILE* _f = nullptr;
+    DIR* _dir = nullptr;
+    std::string _path;
+    LittleFSCounters* _counters = nullptr;
+    size_t _startSize = 0;
+    size_t _tail = 0;
+};
+
+class LittleFSFS {
+public:
+    // Host only: Directory which holds the files and size of the simulated partition
+    void setRoot(const std::string& root, const size_t totalBytes)
+    {
+        _root = root;
+        _totalBytes = totalBytes;
+        _counters = {};
+        ::mkdir(root.c_str(), 0755);
+    }
+
+    // Host only: Bytes written to files and programmed to flash since setRoot()
+    size_t writtenBytes() const { return _counters.written; }
+    size_t programmedBytes() const { return _counters.programmed; }
+
+    File open(const String& path, const char* mode = "r") { return File(_root + path, mode, &_counters); }
+    bool exists(const String& path) const
+    {
+        struct stat st;
+        return stat((_root + path).c_str(), &st) == 0;
+    }
+    bool mkdir(const String& path) const { return ::mkdir((_root + path).c_str(), 0755) == 0; }
+    bool remove(const String& path) const { return ::unlink((_root + path).c_str()) == 0; }
+    bool rename(const String& from, const String& to) const { return ::rename((_root + from).c_str(), (_root + to).c_str()) == 0; }
+
+    size_t totalBytes() const { return _totalBytes; }
+
+    // Superblocks plus the blocks of all files
+    size_t usedBytes() const { return 2 * LITTLEFS_BLOCK_SIZE + usedBytes(_root); }
+
+private:
+    static size_t usedBytes(const std::string& path)
+    {
+        size_t used = 0;
+        DIR* dir = opendir(path.c_str());
+        if (dir == nullptr) {
+            return 0;
+        }
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            const std::string child = path + "/" + entry->d_name;
+            struct stat st;
+            if (stat(child.c_str(), &st) != 0) {
+                continue;
+            }
+            if (S_ISDIR(st.st_mode)) {
+                used += LITTLEFS_BLOCK_SIZE + usedBytes(child);
+            } else {
+                used += (st.st_size + LITTLEFS_BLOCK_SIZE - 1) / LITTLEFS_BLOCK_SIZE * LITTLEFS_BLOCK_SIZE;
+            }
+        }
+        closedir(dir);
+        return used;
+    }
+
+    String _root;
+    size_t _totalBytes = 0;
+    LittleFSCounters _counters;
+};
+
+inline LittleFSFS LittleFS;
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Arduino.h"
+
+#ifdef __cplusplus
+
+class Print {
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size)
+    {
+        size_t n = 0;
+        while (n < size && write(buffer[n])) {
+            n++;
+        }
+        return n;
+    }
+
+    size_t print(const char* str)
+    {
+        return write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+    }
+};
+
+#endif
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// The NRF24 radio is never connected in the native test environment
+
+#include "SPI.h"
+
+typedef enum {
+    RF24_PA_MIN = 0,
+    RF24_PA_LOW,
+    RF24_PA_HIGH,
+    RF24_PA_MAX,
+} rf24_pa_dbm_e;
+
+typedef enum {
+    RF24_1MBPS = 0,
+    RF24_2MBPS,
+    RF24_250KBPS,
+} rf24_datarate_e;
+
+typedef enum {
+    RF24_CRC_DISABLED = 0,
+    RF24_CRC_8,
+    RF24_CRC_16,
+} rf24_crclength_e;
+
+class RF24 {
+public:
+    RF24(const int, const int) { }
+    bool begin(SPIClass*) { return false; }
+    bool isChipConnected() { return false; }
+    bool isPVariant() { return false; }
+    void setDataRate(const rf24_datarate_e) { }
+    void setCRCLength(const rf24_crclength_e) { }
+    void setPALevel(const rf24_pa_dbm_e) { }
+    void setAddressWidth(const int) { }
+    void setRetries(const int, const int) { }
+    void setChannel(const uint8_t) { }
+    uint8_t getChannel() { return 0; }
+    void enableDynamicPayloads() { }
+    uint8_t getDynamicPayloadSize() { return 0; }
+    void maskIRQ(const bool, const bool, const bool) { }
+    void openReadingPipe(const int, const uint64_t) { }
+    void openWritingPipe(const uint64_t) { }
+    void startListening() { }
+    void stopListening() { }
+    bool available() { return false; }
+    bool testRPD() { return false; }
+    void flush_rx() { }
+    void read(void*, const uint8_t) { }
+    bool write(const void*, const uint8_t) { return false; }
+};
@@ -0,0 +1,9 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Arduino.h"
+
+class SPIClass {
+public:
+    int8_t pinSS() const { return -1; }
+};
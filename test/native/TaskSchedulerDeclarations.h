@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// Declarations of TaskScheduler used by the sources under test. Tasks are
+// never executed, the tests call the functions of the classes directly.
+
+#include <cstdint>
+#include <functional>
+
+#define TASK_IMMEDIATE 0
+#define TASK_SECOND 1000UL
+#define TASK_MINUTE (60 * TASK_SECOND)
+#define TASK_FOREVER (-1)
+
+typedef std::function<void()> TaskCallback;
+
+class Task {
+public:
+    Task() { }
+    Task(const uint32_t interval, const int32_t iterations, TaskCallback callback)
+        : _interval(interval)
+        , _iterations(iterations)
+        , _callback(callback)
+    {
+    }
+
+    void setInterval(const uint32_t interval) { _interval = interval; }
+    uint32_t getInterval() const { return _interval; }
+    void setIterations(const int32_t iterations) { _iterations = iterations; }
+    void setCallback(TaskCallback callback) { _callback = callback; }
+    bool enable() { return _enabled = true; }
+    bool disable() { return !(_enabled = false); }
+    bool isEnabled() const { return _enabled; }
+    bool restart() { return enable(); }
+    void forceNextIteration() { }
+
+private:
+    uint32_t _interval = 0;
+    int32_t _iterations = 0;
+    TaskCallback _callback;
+    bool _enabled = false;
+};
+
+class Scheduler {
+public:
+    void addTask(Task&) { }
+    bool execute() { return false; }
+};
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Arduino String on top of std::string, only the members used by the libraries
+class String : public std::string {
+public:
+    String() { }
+    String(const char* s)
+        : std::string(s ? s : "")
+    {
+    }
+    String(const std::string& s)
+        : std::string(s)
+    {
+    }
+    String(const char c)
+        : std::string(1, c)
+    {
+    }
+    String(const int value)
+        : std::string(std::to_string(value))
+    {
+    }
+    String(const unsigned int value)
+        : std::string(std::to_string(value))
+    {
+    }
+    String(const long value)
+        : std::string(std::to_string(value))
+    {
+    }
+    String(const unsigned long value)
+        : std::string(std::to_string(value))
+    {
+    }
+    String(const long long value)
+        : std::string(std::to_string(value))
+    {
+    }
+    String(const unsigned long long value)
+        : std::string(std::to_string(value))
+    {
+    }
+    String(const double value, const unsigned int decimals = 2)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        assign(buffer);
+    }
+
+    bool reserve(const size_t size)
+    {
+        std::string::reserve(size);
+        return true;
+    }
+
+    void toLowerCase()
+    {
+        for (auto& c : *this) {
+            c = tolower(c);
+        }
+    }
+
+    long toInt() const
+    {
+        return atol(c_str());
+    }
+
+    String& operator+=(const char* s)
+    {
+        append(s);
+        return *this;
+    }
+
+    String& operator+=(const std::string& s)
+    {
+        append(s);
+        return *this;
+    }
+
+    String& operator+=(const char c)
+    {
+        push_back(c);
+        return *this;
+    }
+
+    friend String operator+(const String& a, const char* b)
+    {
+        String result(a);
+        result.append(b);
+        return result;
+    }
+
+    friend String operator+(const String& a, const String& b)
+    {
+        String result(a);
+        result.append(b);
+        return result;
+    }
+};
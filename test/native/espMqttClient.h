@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+
+namespace espMqttClientTypes {
+
+struct MessageProperties {
+    uint8_t qos;
+    bool dup;
+    bool retain;
+    uint16_t packetId;
+};
+
+}
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// Log output is discarded in the tests, the arguments are still checked against the format
+
+#include <stdio.h>
+
+#define ESP_LOG_DISCARD(tag, format, ...)         \
+    do {                                          \
+        (void)(tag);                              \
+        if (0) {                                  \
+            printf(format, ##__VA_ARGS__);        \
+        }                                         \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_DISCARD(tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_DISCARD(tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_DISCARD(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_DISCARD(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_DISCARD(tag, format, ##__VA_ARGS__)
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// FreeRTOS primitives used by the libraries, mapped to the host threads
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef void* TaskHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffff
+#define portYIELD_FROM_ISR(x) (void)(x)
+
+#ifdef __cplusplus
+
+#include <mutex>
+
+typedef std::recursive_mutex* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new std::recursive_mutex();
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, uint32_t)
+{
+    semaphore->lock();
+    return pdPASS;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    semaphore->unlock();
+    return pdPASS;
+}
+
+inline void xTaskNotifyGive(TaskHandle_t)
+{
+}
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*)
+{
+}
+
+#endif
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <Benchmark.h>
+#include <Hoymiles.h>
+#include <commands/ActivePowerControlCommand.h>
+#include <commands/DevInfoAllCommand.h>
+#include <commands/RealTimeRunDataCommand.h>
+#include <queue/CommandQueue.h>
+#include <algorithm>
+#include <unity.h>
+#include <vector>
+
+// Size of the sites the poll intervals are tuned for
+#define SITE_INVERTER_COUNT 10
+
+static std::shared_ptr<InverterAbstract> inv;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static std::vector<std::shared_ptr<CommandAbstract>> drain(CommandQueue& queue)
+{
+    std::vector<std::shared_ptr<CommandAbstract>> result;
+    while (auto cmd = queue.pop()) {
+        result.push_back(*cmd);
+    }
+    return result;
+}
+
+static void test_higher_priority_is_inserted_in_front()
+{
+    CommandQueue queue;
+    auto current = std::make_shared<RealTimeRunDataCommand>(inv.get());
+    auto stats = std::make_shared<RealTimeRunDataCommand>(inv.get());
+    auto devInfo = std::make_shared<DevInfoAllCommand>(inv.get());
+    auto limit = std::make_shared<ActivePowerControlCommand>(inv.get());
+
+    queue.push(current);
+    queue.push(devInfo);
+    queue.push(stats);
+    queue.push(limit);
+
+    // The first entry is processed by the radio and is never bypassed
+    const auto order = drain(queue);
+    TEST_ASSERT_EQUAL_size_t(4, order.size());
+    TEST_ASSERT_TRUE(order[0] == current);
+    TEST_ASSERT_TRUE(order[1] == limit);
+    TEST_ASSERT_TRUE(order[2] == stats);
+    TEST_ASSERT_TRUE(order[3] == devInfo);
+}
+
+static void test_same_priority_keeps_order()
+{
+    CommandQueue queue;
+    std::vector<std::shared_ptr<CommandAbstract>> expected;
+    for (uint8_t i = 0; i < 10; i++) {
+        expected.push_back(std::make_shared<ActivePowerControlCommand>(inv.get()));
+        queue.push(expected.back());
+    }
+
+    TEST_ASSERT_TRUE(drain(queue) == expected);
+}
+
+static void test_low_priority_is_not_starved()
+{
+    CommandQueue queue;
+    auto current = std::make_shared<RealTimeRunDataCommand>(inv.get());
+    auto devInfo = std::make_shared<DevInfoAllCommand>(inv.get());
+    queue.push(current);
+    queue.push(devInfo);
+
+    for (uint8_t i = 0; i < 20; i++) {
+        queue.push(std::make_shared<ActivePowerControlCommand>(inv.get()));
+    }
+
+    const auto order = drain(queue);
+    const size_t position = std::find(order.begin(), order.end(), devInfo) - order.begin();
+    TEST_ASSERT_EQUAL_size_t(1 + COMMAND_QUEUE_MAX_BYPASS, position);
+}
+
+static void test_queue_benchmark()
+{
+    // Queue content of one poll cycle of a site
+    CommandQueue queue;
+    std::vector<std::shared_ptr<CommandAbstract>> commands;
+    for (uint8_t i = 0; i < SITE_INVERTER_COUNT; i++) {
+        commands.push_back(std::make_shared<RealTimeRunDataCommand>(inv.get()));
+        commands.push_back(std::make_shared<DevInfoAllCommand>(inv.get()));
+    }
+    auto limit = std::make_shared<ActivePowerControlCommand>(inv.get());
+
+    Benchmark::run("CommandQueue push 20 + pop 20", 100000, [&] {
+        for (auto& cmd : commands) {
+            queue.push(cmd);
+        }
+        while (queue.pop()) { }
+    });
+
+    for (auto& cmd : commands) {
+        queue.push(cmd);
+    }
+    Benchmark::run("CommandQueue push high priority (20 queued)", 100000, [&] {
+        queue.push(limit);
+        queue.pop();
+    });
+
+    Benchmark::run("CommandQueue countSimilarCommands (20 queued)", 100000, [&] {
+        Benchmark::doNotOptimize(queue.countSimilarCommands(limit));
+    });
+}
+
+int main()
+{
+    Hoymiles.init();
+
+    // Only used for the queue tests, it is never polled
+    inv = Hoymiles.addInverter("queue", 0x116100000001);
+    inv->setEnablePolling(false);
+    inv->setEnableCommands(false);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_higher_priority_is_inserted_in_front);
+    RUN_TEST(test_same_priority_keeps_order);
+    RUN_TEST(test_low_priority_is_not_starved);
+    RUN_TEST(test_queue_benchmark);
+    return UNITY_END();
+}
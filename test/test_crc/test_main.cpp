@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <Benchmark.h>
+#include <crc.h>
+#include <cstring>
+#include <random>
+#include <unity.h>
+
+// Bitwise implementations as used before the table driven ones, the reference for all results
+
+static uint8_t crc8Bitwise(const uint8_t buf[], const uint8_t len)
+{
+    uint8_t crc = CRC8_INIT;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc16Bitwise(const uint8_t buf[], const uint8_t len, const uint16_t start)
+{
+    uint16_t crc = start;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x0001) ? ((crc >> 1) ^ CRC16_MODBUS_POLYNOM) : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc16nrf24Bitwise(const uint8_t buf[], const uint16_t lenBits, const uint16_t startBit, const uint16_t crcIn)
+{
+    uint16_t crc = crcIn;
+    for (uint16_t bit = startBit; bit < lenBits; bit++) {
+        const uint8_t val = buf[bit >> 3];
+        crc ^= 0x8000 & (val << (8 + (bit & 0x07)));
+        crc = (crc & 0x8000) ? ((crc << 1) ^ CRC16_NRF24_POLYNOM) : (crc << 1);
+    }
+    return crc;
+}
+
+static const uint8_t checkString[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_crc16_check_value()
+{
+    // CRC-16/MODBUS
+    TEST_ASSERT_EQUAL_HEX16(0x4B37, crc16(checkString, sizeof(checkString)));
+}
+
+static void test_crc16nrf24_check_value()
+{
+    // CRC-16/CCITT-FALSE
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16nrf24(checkString, sizeof(checkString) * 8));
+}
+
+static void test_crc8_matches_bitwise()
+{
+    std::mt19937 rng(1);
+    uint8_t buf[255];
+    for (uint16_t len = 0; len < sizeof(buf); len++) {
+        for (auto& b : buf) {
+            b = rng();
+        }
+        TEST_ASSERT_EQUAL_HEX8(crc8Bitwise(buf, len), crc8(buf, len));
+    }
+}
+
+static void test_crc16_matches_bitwise()
+{
+    std::mt19937 rng(2);
+    uint8_t buf[255];
+    for (uint16_t len = 0; len < sizeof(buf); len++) {
+        for (auto& b : buf) {
+            b = rng();
+        }
+        const uint16_t start = rng();
+        TEST_ASSERT_EQUAL_HEX16(crc16Bitwise(buf, len, 0xffff), crc16(buf, len));
+        TEST_ASSERT_EQUAL_HEX16(crc16Bitwise(buf, len, start), crc16(buf, len, start));
+    }
+}
+
+static void test_crc16nrf24_matches_bitwise()
+{
+    // The ESB packets are not byte aligned, check all bit offsets and lengths
+    std::mt19937 rng(3);
+    uint8_t buf[40];
+    for (uint16_t startBit = 0; startBit < 16; startBit++) {
+        for (uint16_t lenBits = startBit; lenBits < sizeof(buf) * 8; lenBits++) {
+            for (auto& b : buf) {
+                b = rng();
+            }
+            const uint16_t crcIn = rng();
+            TEST_ASSERT_EQUAL_HEX16(crc16nrf24Bitwise(buf, lenBits, startBit, crcIn), crc16nrf24(buf, lenBits, startBit, crcIn));
+        }
+    }
+}
+
+static void test_crc_benchmark()
+{
+    // Size of a complete fragment of the NRF24 radio
+    uint8_t buf[27];
+    for (uint8_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = i * 37;
+    }
+
+    const size_t iterations = 1000000;
+    const double table8 = Benchmark::run("crc8 (27 bytes)", iterations, [&] { Benchmark::doNotOptimize(crc8(buf, sizeof(buf))); });
+    const double bitwise8 = Benchmark::run("crc8 bitwise (27 bytes)", iterations, [&] { Benchmark::doNotOptimize(crc8Bitwise(buf, sizeof(buf))); });
+    const double table16 = Benchmark::run("crc16 (27 bytes)", iterations, [&] { Benchmark::doNotOptimize(crc16(buf, sizeof(buf))); });
+    const double bitwise16 = Benchmark::run("crc16 bitwise (27 bytes)", iterations, [&] { Benchmark::doNotOptimize(crc16Bitwise(buf, sizeof(buf), 0xffff)); });
+    const double tableNrf = Benchmark::run("crc16nrf24 (27 bytes)", iterations, [&] { Benchmark::doNotOptimize(crc16nrf24(buf, sizeof(buf) * 8)); });
+    const double bitwiseNrf = Benchmark::run("crc16nrf24 bitwise (27 bytes)", iterations, [&] { Benchmark::doNotOptimize(crc16nrf24Bitwise(buf, sizeof(buf) * 8, 0, 0xffff)); });
+
+    // Only a sanity check, the absolute numbers depend on the host
+    TEST_ASSERT_TRUE(table8 < bitwise8);
+    TEST_ASSERT_TRUE(table16 < bitwise16);
+    TEST_ASSERT_TRUE(tableNrf < bitwiseNrf);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc16_check_value);
+    RUN_TEST(test_crc16nrf24_check_value);
+    RUN_TEST(test_crc8_matches_bitwise);
+    RUN_TEST(test_crc16_matches_bitwise);
+    RUN_TEST(test_crc16nrf24_matches_bitwise);
+    RUN_TEST(test_crc_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,344 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "History.h"
+#include <Benchmark.h>
+#include <Hoymiles.h>
+#include <LittleFS.h>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <unity.h>
+#include <vector>
+
+#include "../../src/History.cpp"
+
+// 2025-01-01
+#define START_TIME 1735689600
+
+#define SAMPLE_INTERVAL 300
+#define SIMULATED_DAYS 40
+#define DC_CHANNELS 4
+
+ConfigurationClass Configuration;
+
+static CONFIG_T config = {};
+
+CONFIG_T const& ConfigurationClass::get()
+{
+    return config;
+}
+
+// Runs the loop of the history at the simulated time
+class TestHistory : public HistoryClass {
+public:
+    using HistoryClass::loop;
+
+    time_t now = 0;
+
+protected:
+    time_t getTime() const override
+    {
+        return now;
+    }
+};
+
+static const std::string fsRoot = "/tmp/opendtu_test_history";
+
+static std::mt19937 rng(1);
+static std::unique_ptr<TestHistory> history;
+
+// Four strings of 400 W with a sine shaped production between 6:00 and 20:00
+static HistorySample_t createSample(const uint32_t time, int32_t* yield)
+{
+    std::normal_distribution<float> noise(0, 5);
+    const float hour = static_cast<float>(time % SECONDS_PER_DAY) / SECONDS_PER_HOUR;
+    const float sun = hour > 6 && hour < 20 ? sinf((hour - 6) / 14 * M_PI) : 0;
+
+    HistorySample_t sample = {};
+    sample.time = time;
+    for (uint8_t c = 0; c < DC_CHANNELS; c++) {
+        sample.dcPower[c] = sun > 0 ? std::max(0L, lroundf((400 * sun + noise(rng)) * 10)) : 0;
+        sample.acPower += sample.dcPower[c] * 95 / 100;
+        yield[c] += sample.dcPower[c] * SAMPLE_INTERVAL / 36000;
+        sample.yieldTotal += yield[c];
+    }
+    return sample;
+}
+
+static uint64_t inverterSerial(const uint8_t index)
+{
+    return 0x116100000000 + index; // HM_4CH
+}
+
+// Stores the raw values of the sample in the statistics of the inverter
+static void setStatistics(const uint8_t index, const HistorySample_t& sample, const int32_t* yield)
+{
+    auto inv = Hoymiles.getInverterByPos(index);
+
+    uint8_t payload[STATISTIC_PACKET_SIZE] = {};
+    for (uint8_t i = 0; i < inv->getByteAssignmentSize(); i++) {
+        const byteAssign_t& b = inv->getByteAssignment()[i];
+        if (b.div == CMD_CALC) {
+            continue;
+        }
+
+        uint32_t raw = 0;
+        if (b.type == TYPE_DC && b.fieldId == FLD_PDC) {
+            raw = sample.dcPower[b.ch];
+        } else if (b.type == TYPE_DC && b.fieldId == FLD_YT) {
+            raw = yield[b.ch];
+        } else if (b.type == TYPE_AC && b.fieldId == FLD_PAC) {
+            raw = sample.acPower;
+        }
+        for (uint8_t n = 0; n < b.num; n++) {
+            payload[b.start + n] = raw >> (8 * (b.num - 1 - n));
+        }
+    }
+
+    StatisticsParser* parser = inv->Statistics();
+    parser->beginAppendFragment();
+    parser->clearBuffer();
+    parser->appendFragment(0, payload, parser->getExpectedByteCount());
+    parser->endAppendFragment();
+    parser->setLastUpdate(millis() + 1);
+}
+
+// Updates the statistics of all inverters and runs the loop once per sample interval
+static void simulate(const uint32_t days, std::vector<HistorySample_t>* recorded, const std::function<void(uint32_t)>& onDayChange = nullptr)
+{
+    int32_t yield[INV_MAX_COUNT][DC_CHANNELS];
+    for (auto& inverter : yield) {
+        std::fill(std::begin(inverter), std::end(inverter), 25000);
+    }
+
+    uint32_t day = 0;
+    for (uint32_t now = START_TIME; now < START_TIME + days * SECONDS_PER_DAY; now += SAMPLE_INTERVAL) {
+        for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+            const HistorySample_t sample = createSample(now, yield[i]);
+            setStatistics(i, sample, yield[i]);
+            if (i == 0 && recorded != nullptr) {
+                recorded->push_back(sample);
+            }
+        }
+
+        history->now = now;
+        history->loop();
+
+        const uint32_t today = now / SECONDS_PER_DAY;
+        if (today != day) {
+            day = today;
+            if (onDayChange) {
+                onDayChange(today);
+            }
+        }
+    }
+}
+
+static void resetHistory(const size_t totalBytes)
+{
+    std::string command = "rm -rf " + fsRoot;
+    TEST_ASSERT_EQUAL(0, system(command.c_str()));
+    LittleFS.setRoot(fsRoot, totalBytes);
+
+    // The loop task is never executed, simulate() calls the loop itself
+    static Scheduler scheduler;
+    history = std::make_unique<TestHistory>();
+    history->init(scheduler);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_sample_round_trip()
+{
+    uint8_t buffer[HISTORY_BLOCK_SIZE];
+    std::uniform_int_distribution<int32_t> value(INT32_MIN, INT32_MAX);
+
+    for (uint32_t run = 0; run < 1000; run++) {
+        // Large values and differences in both directions, at most 5 bytes per varint fit into one block
+        std::vector<HistorySample_t> samples(1 + rng() % (HISTORY_BLOCK_SIZE / ((3 + INV_MAX_CHAN_COUNT) * 5)));
+        uint32_t time = rng();
+        for (auto& sample : samples) {
+            sample = {};
+            time += rng() % 4000;
+            sample.time = time;
+            sample.acPower = run % 2 ? value(rng) : static_cast<int32_t>(rng() % 30000);
+            sample.yieldTotal = value(rng);
+            for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
+                sample.dcPower[c] = run % 2 ? value(rng) : static_cast<int32_t>(rng() % 5000);
+            }
+        }
+
+        size_t len = 0;
+        HistorySample_t previous = {};
+        previous.time = samples[0].time;
+        for (auto& sample : samples) {
+            const size_t written = HistoryClass::encodeSample(buffer + len, sizeof(buffer) - len, sample, previous, INV_MAX_CHAN_COUNT);
+            TEST_ASSERT_GREATER_THAN(0, written);
+            len += written;
+            previous = sample;
+        }
+
+        HistorySample_t decoded = {};
+        decoded.time = samples[0].time;
+        size_t pos = 0;
+        for (auto& sample : samples) {
+            const size_t read = HistoryClass::decodeSample(buffer + pos, len - pos, decoded, INV_MAX_CHAN_COUNT);
+            TEST_ASSERT_GREATER_THAN(0, read);
+            TEST_ASSERT_EQUAL_MEMORY(&sample, &decoded, sizeof(sample));
+            pos += read;
+        }
+        TEST_ASSERT_EQUAL_size_t(len, pos);
+
+        // Incomplete data is detected
+        if (len > 1) {
+            HistorySample_t last = decoded;
+            TEST_ASSERT_EQUAL_size_t(0, HistoryClass::decodeSample(buffer + len - 1, 0, last, INV_MAX_CHAN_COUNT));
+        }
+    }
+}
+
+static void test_encode_into_full_buffer()
+{
+    uint8_t buffer[4];
+    HistorySample_t sample = {};
+    sample.acPower = 1000000;
+    const HistorySample_t previous = {};
+    TEST_ASSERT_EQUAL_size_t(0, HistoryClass::encodeSample(buffer, sizeof(buffer), sample, previous, DC_CHANNELS));
+}
+
+static void test_segments_round_trip_and_write_amplification()
+{
+    // A partition which is large enough for the whole retention
+    resetHistory(64 * 1024 * 1024);
+
+    std::vector<HistorySample_t> recorded;
+    simulate(SIMULATED_DAYS, &recorded);
+
+    // All samples of the first inverter which are still kept
+    const uint32_t today = history->now / SECONDS_PER_DAY;
+    std::vector<HistorySample_t> decoded;
+    for (uint32_t day = today + 1 - HISTORY_SEGMENT_DAYS; day <= today; day++) {
+        File file = LittleFS.open(HistoryClass::getSegmentPath(day), "r");
+        HistoryBlockHeader_t header;
+        uint8_t data[HISTORY_BLOCK_SIZE];
+        while (file && file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)) {
+            TEST_ASSERT_EQUAL_size_t(header.length, file.read(data, header.length));
+            if (header.serial != inverterSerial(0) || header.type != HISTORY_BLOCK_SAMPLES) {
+                continue;
+            }
+
+            HistorySample_t sample = {};
+            sample.time = header.start;
+            size_t pos = 0;
+            while (pos < header.length) {
+                const size_t len = HistoryClass::decodeSample(data + pos, header.length - pos, sample, header.channels);
+                TEST_ASSERT_GREATER_THAN(0, len);
+                decoded.push_back(sample);
+                pos += len;
+            }
+        }
+    }
+
+    // The samples of the current hour are only in RAM
+    HistoryBlockHeader_t header;
+    uint8_t data[HISTORY_BLOCK_SIZE];
+    if (history->getPendingBlock(inverterSerial(0), header, data)) {
+        HistorySample_t sample = {};
+        sample.time = header.start;
+        for (size_t pos = 0, len; pos < header.length; pos += len) {
+            len = HistoryClass::decodeSample(data + pos, header.length - pos, sample, header.channels);
+            TEST_ASSERT_GREATER_THAN(0, len);
+            decoded.push_back(sample);
+        }
+    }
+
+    TEST_ASSERT_GREATER_THAN(0, decoded.size());
+    TEST_ASSERT_LESS_OR_EQUAL(recorded.size(), decoded.size());
+    const size_t offset = recorded.size() - decoded.size();
+    TEST_ASSERT_EQUAL_UINT32(today + 1 - HISTORY_SEGMENT_DAYS, recorded[offset].time / SECONDS_PER_DAY);
+    TEST_ASSERT_EQUAL_MEMORY(&recorded[offset], decoded.data(), decoded.size() * sizeof(HistorySample_t));
+
+    // Old segments were removed, the daily rollups of all finished days are kept
+    uint32_t segments = 0;
+    File dir = LittleFS.open(HISTORY_PATH);
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        segments += String(file.name()).toInt() > 0;
+    }
+    TEST_ASSERT_EQUAL_UINT32(HISTORY_SEGMENT_DAYS, segments);
+    File daily = LittleFS.open(HISTORY_DAILY_FILE, "r");
+    TEST_ASSERT_EQUAL_size_t((SIMULATED_DAYS - 1) * INV_MAX_COUNT * sizeof(HistoryDaily_t), daily.size());
+
+    const double samples = static_cast<double>(recorded.size()) * INV_MAX_COUNT;
+    const double written = LittleFS.writtenBytes();
+    const double programmed = LittleFS.programmedBytes();
+    printf("BENCH %u inverters, %u s interval: %.2f bytes per sample, %.0f bytes per day written, %.0f bytes per day programmed to flash (%.1fx)\n",
+        INV_MAX_COUNT, SAMPLE_INTERVAL, written / samples, written / SIMULATED_DAYS, programmed / SIMULATED_DAYS, programmed / written);
+    printf("BENCH %zu bytes of the filesystem used for %u days\n", LittleFS.usedBytes(), HISTORY_SEGMENT_DAYS);
+
+    // One append per hour for all inverters rewrites the last block of the segment once
+    TEST_ASSERT_LESS_THAN(5 * written, programmed);
+}
+
+static void test_byte_budget()
+{
+    // Too small for the whole retention
+    const size_t totalBytes = 256 * 1024;
+    resetHistory(totalBytes);
+
+    size_t maxUsed = 0;
+    simulate(SIMULATED_DAYS, nullptr, [&](const uint32_t today) {
+        maxUsed = std::max(maxUsed, LittleFS.usedBytes());
+
+        // The current day is never removed
+        TEST_ASSERT_TRUE(LittleFS.exists(HistoryClass::getSegmentPath(today - 1)) || today == START_TIME / SECONDS_PER_DAY);
+    });
+
+    printf("BENCH %zu of %zu bytes used at most\n", maxUsed, totalBytes);
+    TEST_ASSERT_LESS_OR_EQUAL(totalBytes - HISTORY_FS_RESERVE, maxUsed);
+    TEST_ASSERT_TRUE(LittleFS.exists(HISTORY_DAILY_FILE));
+}
+
+static void test_encode_benchmark()
+{
+    int32_t yield[DC_CHANNELS] = {};
+    const HistorySample_t previous = createSample(START_TIME + 12 * SECONDS_PER_HOUR, yield);
+    const HistorySample_t sample = createSample(START_TIME + 12 * SECONDS_PER_HOUR + SAMPLE_INTERVAL, yield);
+    uint8_t buffer[64];
+
+    Benchmark::run("History::encodeSample", 1000000, [&] {
+        Benchmark::doNotOptimize(HistoryClass::encodeSample(buffer, sizeof(buffer), sample, previous, DC_CHANNELS));
+    });
+
+    HistorySample_t decoded = previous;
+    const size_t len = HistoryClass::encodeSample(buffer, sizeof(buffer), sample, previous, DC_CHANNELS);
+    Benchmark::run("History::decodeSample", 1000000, [&] {
+        decoded = previous;
+        Benchmark::doNotOptimize(HistoryClass::decodeSample(buffer, len, decoded, DC_CHANNELS));
+    });
+}
+
+int main()
+{
+    config.History.Enabled = true;
+    config.History.Interval = SAMPLE_INTERVAL;
+
+    Hoymiles.init();
+    for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+        Hoymiles.addInverter("inverter", inverterSerial(i));
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_sample_round_trip);
+    RUN_TEST(test_encode_into_full_buffer);
+    RUN_TEST(test_segments_round_trip_and_write_amplification);
+    RUN_TEST(test_byte_budget);
+    RUN_TEST(test_encode_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "LiveDataJson.h"
+#include <Configuration.h>
+#include <Hoymiles.h>
+#include <cmath>
+#include <random>
+#include <unity.h>
+
+#include "../../src/LiveDataJson.cpp"
+
+#define DAY_SERIAL 0x116100000003 // HM_4CH
+
+// Updates while the inverter produces, otherwise WebApiWsLiveClass resends the unchanged data
+#define POLL_INTERVAL 5
+#define IDLE_INTERVAL 10
+#define SUNRISE (6 * 3600)
+#define SUNSET (20 * 3600)
+
+// Time at which the second client connects
+#define SECOND_CLIENT_CONNECT (12 * 3600)
+
+ConfigurationClass Configuration;
+
+static INVERTER_CONFIG_T inverterConfig = {};
+
+INVERTER_CONFIG_T* ConfigurationClass::getInverterConfig(const uint64_t serial)
+{
+    return serial == DAY_SERIAL ? &inverterConfig : nullptr;
+}
+
+static std::mt19937 rng(1);
+static std::shared_ptr<InverterAbstract> inv;
+
+// Stores the values in the statistics payload at the positions of the byte assignment
+static void setValues(const float pdc, const float temperature, const uint32_t yieldDay)
+{
+    std::uniform_real_distribution<float> noise(-1, 1);
+    const float udc = pdc > 0 ? 33 + noise(rng) * 2 : 0;
+    const float uac = 230 + noise(rng) * 3;
+    const float pac = pdc * 0.96f;
+
+    auto valueOf = [&](const byteAssign_t& b) -> float {
+        switch (b.fieldId) {
+        case FLD_UDC:
+            return udc;
+        case FLD_IDC:
+            return udc > 0 ? pdc / 4 / udc : 0;
+        case FLD_PDC:
+            return pdc / 4;
+        case FLD_YD:
+            return yieldDay / 4;
+        case FLD_YT:
+            return 4000 + yieldDay / 4000.0f;
+        case FLD_UAC:
+            return uac;
+        case FLD_IAC:
+            return pac / uac;
+        case FLD_PAC:
+            return pac;
+        case FLD_F:
+            return 50 + noise(rng) * 0.02f;
+        case FLD_PF:
+            return pac > 0 ? 1 : 0;
+        case FLD_T:
+            return temperature;
+        default:
+            return 0;
+        }
+    };
+
+    uint8_t payload[STATISTIC_PACKET_SIZE] = {};
+    for (uint8_t i = 0; i < inv->getByteAssignmentSize(); i++) {
+        const byteAssign_t& b = inv->getByteAssignment()[i];
+        if (b.div == CMD_CALC) {
+            continue;
+        }
+        const uint32_t raw = lroundf(valueOf(b) * b.div);
+        for (uint8_t n = 0; n < b.num; n++) {
+            payload[b.start + n] = raw >> (8 * (b.num - 1 - n));
+        }
+    }
+
+    StatisticsParser* parser = inv->Statistics();
+    parser->beginAppendFragment();
+    parser->clearBuffer();
+    parser->appendFragment(0, payload, parser->getExpectedByteCount());
+    parser->endAppendFragment();
+}
+
+// Inverter part of the message which WebApiWsLiveClass sends to all clients of /livedata
+static size_t fullMessageSize()
+{
+    JsonDocument root;
+    JsonObject invObject = root.to<JsonObject>();
+
+    LiveDataJson::generateInverterCommonJsonResponse(invObject, inv);
+    LiveDataJson::generateInverterRadioJsonResponse(invObject, inv);
+    LiveDataJson::generateInverterChannelJsonResponse(invObject, inv);
+
+    return measureJson(root);
+}
+
+// Inverter part of the snapshot which WebApiWsLiveClass sends to a new client of /livedata/delta
+static size_t snapshotMessageSize()
+{
+    JsonDocument root;
+    JsonObject invObject = root.to<JsonObject>();
+    JsonObject fieldIds = invObject["ids"].to<JsonObject>();
+
+    LiveDataJson::generateInverterCommonJsonResponse(invObject, inv);
+    LiveDataJson::generateInverterChannelJsonResponse(invObject, inv, &fieldIds);
+
+    return measureJson(root);
+}
+
+static size_t fieldCount()
+{
+    JsonDocument root;
+    JsonObject invObject = root.to<JsonObject>();
+    JsonObject fieldIds = invObject["ids"].to<JsonObject>();
+
+    LiveDataJson::generateInverterChannelJsonResponse(invObject, inv, &fieldIds);
+
+    return fieldIds.size();
+}
+
+static size_t deltaMessage(WsLiveDeltaState_t& state, size_t* fields = nullptr)
+{
+    JsonDocument root;
+    JsonObject invObject = root.to<JsonObject>();
+
+    LiveDataJson::generateInverterDeltaJsonResponse(invObject, inv, state);
+
+    if (fields != nullptr) {
+        *fields = invObject["fields"].size();
+    }
+    return measureJson(root);
+}
+
+void setUp()
+{
+    setValues(800, 35, 2000);
+}
+
+void tearDown()
+{
+}
+
+static void test_delta_contains_changed_fields_only()
+{
+    WsLiveDeltaState_t state;
+    size_t fields;
+
+    deltaMessage(state, &fields);
+    TEST_ASSERT_EQUAL_size_t(fieldCount(), fields);
+
+    deltaMessage(state, &fields);
+    TEST_ASSERT_EQUAL_size_t(0, fields);
+
+    setValues(900, 35, 2000);
+    deltaMessage(state, &fields);
+    TEST_ASSERT_GREATER_THAN(0, fields);
+    TEST_ASSERT_LESS_THAN(fieldCount(), fields);
+}
+
+static void test_delta_after_reset_contains_all_fields()
+{
+    // A client which connects receives the snapshot and the state of all
+    // inverters is reset. A value which returns to the one of the last
+    // update before the next update is therefore still sent to it.
+    WsLiveDeltaState_t state;
+    size_t fields;
+
+    deltaMessage(state, &fields);
+    setValues(900, 35, 2000);
+
+    state.serial = 0;
+    setValues(800, 35, 2000);
+    deltaMessage(state, &fields);
+    TEST_ASSERT_EQUAL_size_t(fieldCount(), fields);
+}
+
+static void test_day_replay_bytes_per_client()
+{
+    // Client A is connected the whole day, client B connects at noon
+    size_t fullA = 0;
+    size_t fullB = 0;
+    size_t deltaA = 0;
+    size_t deltaB = 0;
+    size_t updates = 0;
+
+    WsLiveDeltaState_t state;
+    deltaA += snapshotMessageSize();
+
+    uint32_t yieldDay = 0;
+    bool secondClient = false;
+    std::uniform_real_distribution<float> clouds(0.7f, 1);
+
+    for (uint32_t t = 0; t < 24 * 3600;) {
+        const bool producing = t >= SUNRISE && t < SUNSET;
+        if (producing) {
+            const float pdc = 1600 * sinf(M_PI * (t - SUNRISE) / (SUNSET - SUNRISE)) * clouds(rng);
+            yieldDay += lroundf(pdc * POLL_INTERVAL / 3600);
+            setValues(pdc, 20 + pdc / 60, yieldDay);
+        }
+
+        if (!secondClient && t >= SECOND_CLIENT_CONNECT) {
+            secondClient = true;
+            deltaB += snapshotMessageSize();
+            state.serial = 0;
+        }
+
+        const size_t full = fullMessageSize();
+        const size_t delta = deltaMessage(state);
+        fullA += full;
+        deltaA += delta;
+        if (secondClient) {
+            fullB += full;
+            deltaB += delta;
+        }
+        updates++;
+
+        t += producing ? POLL_INTERVAL : IDLE_INTERVAL;
+    }
+
+    printf("BENCH day replay with %zu updates, bytes per client without totals and hints:\n", updates);
+    printf("BENCH   full:  client A %8zu, client B %8zu\n", fullA, fullB);
+    printf("BENCH   delta: client A %8zu, client B %8zu (%.1f%% of full)\n", deltaA, deltaB, deltaA * 100.0 / fullA);
+
+    TEST_ASSERT_LESS_THAN(fullA, deltaA);
+    TEST_ASSERT_LESS_THAN(fullB, deltaB);
+}
+
+int main()
+{
+    Hoymiles.init();
+    inv = Hoymiles.addInverter("day", DAY_SERIAL);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_delta_contains_changed_fields_only);
+    RUN_TEST(test_delta_after_reset_contains_all_fields);
+    RUN_TEST(test_day_replay_bytes_per_client);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "MqttPublishBatch.h"
+#include <Benchmark.h>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+#include "../../src/MqttPublishBatch.cpp"
+
+// Size of the sites the poll intervals are tuned for
+#define SITE_INVERTER_COUNT 10
+
+// Same size as used by MqttSettingsClass::publishBatch
+#define TOPIC_SIZE (32 + 64)
+
+// Sub topics of a four channel inverter as built by MqttHandleInverterClass
+static const char* const statusSubtopics[] = {
+    "name", "radio/tx_request", "radio/tx_re_request", "radio/rx_success",
+    "radio/rx_fail_nothing", "radio/rx_fail_partial", "radio/rx_fail_corrupt", "radio/rssi",
+    "device/bootloaderversion", "device/fwbuildversion", "device/fwbuilddatetime",
+    "device/hwpartnumber", "device/hwversion", "status/limit_relative",
+    "status/limit_absolute", "status/reachable", "status/producing", "status/last_update",
+};
+
+static const char* const acFields[] = {
+    "voltage", "current", "power", "frequency", "powerfactor", "reactivepower",
+};
+
+static const char* const invFields[] = {
+    "powerdc", "yieldday", "yieldtotal", "temperature", "efficiency",
+};
+
+static const char* const dcFields[] = {
+    "name", "voltage", "current", "power", "yieldday", "yieldtotal", "irradiation",
+};
+
+static std::vector<std::string> bases;
+static std::vector<std::string> fieldSubtopics;
+
+// Replaces the MQTT client, joins the topics like MqttSettingsClass::publishBatch
+static size_t publishedMessages = 0;
+static size_t publishedBytes = 0;
+static size_t publishedBatches = 0;
+
+static void publishBatch(const MqttPublishBatch& batch)
+{
+    char topic[TOPIC_SIZE];
+    for (size_t i = 0; i < batch.size(); i++) {
+        publishedBytes += batch.getTopic(i, topic, sizeof(topic));
+        publishedBytes += strlen(batch.getPayload(i));
+        Benchmark::doNotOptimize(topic);
+    }
+    publishedMessages += batch.size();
+    publishedBatches++;
+}
+
+static MqttPublishBatch batch(publishBatch);
+
+// One publish of MqttHandleInverterClass::loop, all values of all inverters
+static void publishCycle()
+{
+    for (auto& base : bases) {
+        for (auto subtopic : statusSubtopics) {
+            batch.addf(base.c_str(), subtopic, "%d", 4711);
+        }
+        for (auto& subtopic : fieldSubtopics) {
+            batch.addf(base.c_str(), subtopic.c_str(), "%.*f", 1, 230.4f);
+        }
+        batch.publish();
+    }
+}
+
+void setUp()
+{
+    publishedMessages = 0;
+    publishedBytes = 0;
+    publishedBatches = 0;
+}
+
+void tearDown()
+{
+}
+
+static void test_payload_is_trimmed()
+{
+    batch.add("base/", "sub", "  value \n");
+    TEST_ASSERT_EQUAL_size_t(1, batch.size());
+    TEST_ASSERT_EQUAL_STRING("value", batch.getPayload(0));
+
+    char topic[TOPIC_SIZE];
+    TEST_ASSERT_EQUAL_size_t(8, batch.getTopic(0, topic, sizeof(topic)));
+    TEST_ASSERT_EQUAL_STRING("base/sub", topic);
+
+    batch.publish();
+    TEST_ASSERT_EQUAL_size_t(0, batch.size());
+    TEST_ASSERT_EQUAL_size_t(1, publishedMessages);
+}
+
+static void test_full_batch_is_sent()
+{
+    for (size_t i = 0; i < MQTT_BATCH_MAX_MESSAGES + 1; i++) {
+        batch.add("base/", "sub", "1");
+    }
+    TEST_ASSERT_EQUAL_size_t(1, publishedBatches);
+    TEST_ASSERT_EQUAL_size_t(MQTT_BATCH_MAX_MESSAGES, publishedMessages);
+
+    batch.publish();
+    TEST_ASSERT_EQUAL_size_t(MQTT_BATCH_MAX_MESSAGES + 1, publishedMessages);
+
+    // Only one of these payloads fits into the buffer, the batch is sent before the next one is added
+    const std::string payload(MQTT_BATCH_PAYLOAD_SIZE / 2, 'x');
+    for (size_t i = 0; i < 3; i++) {
+        batch.add("base/", "sub", payload.c_str());
+    }
+    TEST_ASSERT_EQUAL_size_t(4, publishedBatches);
+    batch.publish();
+    TEST_ASSERT_EQUAL_size_t(5, publishedBatches);
+}
+
+static void test_publish_cycle_10_inverters()
+{
+    publishCycle();
+    const size_t messages = publishedMessages;
+    const size_t bytes = publishedBytes;
+    const size_t batches = publishedBatches;
+
+    const Benchmark::AllocationCounter counter;
+    Benchmark::run("publish cycle 10 inverters", 1000, publishCycle);
+    const size_t allocations = counter.count();
+
+    printf("BENCH publish cycle: %zu messages, %zu bytes of topics and payloads, %zu batches\n",
+        messages, bytes, batches);
+
+    TEST_ASSERT_EQUAL_size_t(SITE_INVERTER_COUNT * (sizeof(statusSubtopics) / sizeof(statusSubtopics[0]) + fieldSubtopics.size()), messages);
+    TEST_ASSERT_EQUAL_size_t(0, allocations);
+}
+
+int main()
+{
+    for (uint8_t i = 0; i < SITE_INVERTER_COUNT; i++) {
+        bases.push_back("solar/11618000000" + std::to_string(i) + "/");
+    }
+    for (auto field : acFields) {
+        fieldSubtopics.push_back(std::string("0/") + field);
+    }
+    for (auto field : invFields) {
+        fieldSubtopics.push_back(std::string("0/") + field);
+    }
+    for (uint8_t channel = 1; channel <= 4; channel++) {
+        for (auto field : dcFields) {
+            fieldSubtopics.push_back(std::to_string(channel) + "/" + field);
+        }
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_payload_is_trimmed);
+    RUN_TEST(test_full_batch_is_sent);
+    RUN_TEST(test_publish_cycle_10_inverters);
+    return UNITY_END();
+}
@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <Benchmark.h>
+#include <MqttSubscribeParser.h>
+#include <algorithm>
+#include <random>
+#include <unity.h>
+
+// Topic matching of the linear dispatcher (taken from mosquitto), the reference for all results
+
+enum {
+    MOSQ_ERR_SUCCESS = 0,
+    MOSQ_ERR_INVAL = 3,
+};
+
+static int mosquitto_topic_matches_sub(const char* sub, const char* topic, bool* result)
+{
+    size_t spos;
+
+    if (!result)
+        return MOSQ_ERR_INVAL;
+    *result = false;
+
+    if (!sub || !topic || sub[0] == 0 || topic[0] == 0) {
+        return MOSQ_ERR_INVAL;
+    }
+
+    if ((sub[0] == '$' && topic[0] != '$')
+        || (topic[0] == '$' && sub[0] != '$')) {
+
+        return MOSQ_ERR_SUCCESS;
+    }
+
+    spos = 0;
+
+    while (sub[0] != 0) {
+        if (topic[0] == '+' || topic[0] == '#') {
+            return MOSQ_ERR_INVAL;
+        }
+        if (sub[0] != topic[0] || topic[0] == 0) { /* Check for wildcard matches */
+            if (sub[0] == '+') {
+                /* Check for bad "+foo" or "a/+foo" subscription */
+                if (spos > 0 && sub[-1] != '/') {
+                    return MOSQ_ERR_INVAL;
+                }
+                /* Check for bad "foo+" or "foo+/a" subscription */
+                if (sub[1] != 0 && sub[1] != '/') {
+                    return MOSQ_ERR_INVAL;
+                }
+                spos++;
+                sub++;
+                while (topic[0] != 0 && topic[0] != '/') {
+                    if (topic[0] == '+' || topic[0] == '#') {
+                        return MOSQ_ERR_INVAL;
+                    }
+                    topic++;
+                }
+                if (topic[0] == 0 && sub[0] == 0) {
+                    *result = true;
+                    return MOSQ_ERR_SUCCESS;
+                }
+            } else if (sub[0] == '#') {
+                /* Check for bad "foo#" subscription */
+                if (spos > 0 && sub[-1] != '/') {
+                    return MOSQ_ERR_INVAL;
+                }
+                /* Check for # not the final character of the sub, e.g. "#foo" */
+                if (sub[1] != 0) {
+                    return MOSQ_ERR_INVAL;
+                } else {
+                    while (topic[0] != 0) {
+                        if (topic[0] == '+' || topic[0] == '#') {
+                            return MOSQ_ERR_INVAL;
+                        }
+                        topic++;
+                    }
+                    *result = true;
+                    return MOSQ_ERR_SUCCESS;
+                }
+            } else {
+                /* Check for e.g. foo/bar matching foo/+/# */
+                if (topic[0] == 0
+                    && spos > 0
+                    && sub[-1] == '+'
+                    && sub[0] == '/'
+                    && sub[1] == '#') {
+                    *result = true;
+                    return MOSQ_ERR_SUCCESS;
+                }
+
+                /* There is no match at this point, but is the sub invalid? */
+                while (sub[0] != 0) {
+                    if (sub[0] == '#' && sub[1] != 0) {
+                        return MOSQ_ERR_INVAL;
+                    }
+                    spos++;
+                    sub++;
+                }
+
+                /* Valid input, but no match */
+                return MOSQ_ERR_SUCCESS;
+            }
+        } else {
+            /* sub[spos] == topic[tpos] */
+            if (topic[1] == 0) {
+                /* Check for e.g. foo matching foo/# */
+                if (sub[1] == '/'
+                    && sub[2] == '#'
+                    && sub[3] == 0) {
+                    *result = true;
+                    return MOSQ_ERR_SUCCESS;
+                }
+            }
+            spos++;
+            sub++;
+            topic++;
+            if (sub[0] == 0 && topic[0] == 0) {
+                *result = true;
+                return MOSQ_ERR_SUCCESS;
+            } else if (topic[0] == 0 && sub[0] == '+' && sub[1] == 0) {
+                if (spos > 0 && sub[-1] != '/') {
+                    return MOSQ_ERR_INVAL;
+                }
+                spos++;
+                sub++;
+                *result = true;
+                return MOSQ_ERR_SUCCESS;
+            }
+        }
+    }
+    if ((topic[0] != 0 || sub[0] != 0)) {
+        *result = false;
+    }
+    while (topic[0] != 0) {
+        if (topic[0] == '+' || topic[0] == '#') {
+            return MOSQ_ERR_INVAL;
+        }
+        topic++;
+    }
+
+    return MOSQ_ERR_SUCCESS;
+}
+
+static bool referenceMatches(const std::string& sub, const std::string& topic)
+{
+    bool result = false;
+    return mosquitto_topic_matches_sub(sub.c_str(), topic.c_str(), &result) == MOSQ_ERR_SUCCESS && result;
+}
+
+static const espMqttClientTypes::MessageProperties properties = {};
+
+static const char* const levels[] = { "solar", "dtu", "116100000001", "116100000002", "cmd", "status", "limit_persistent_relative", "power", "", "$SYS" };
+
+static std::string randomTopic(std::mt19937& rng, const bool wildcards)
+{
+    const uint8_t depth = 1 + rng() % 5;
+    std::string topic;
+    for (uint8_t i = 0; i < depth; i++) {
+        if (i > 0) {
+            topic += '/';
+        }
+        const uint32_t r = rng() % 14;
+        if (wildcards && r == 10) {
+            topic += '+';
+        } else if (wildcards && r == 11) {
+            topic += '#';
+            break;
+        } else {
+            topic += levels[r % (sizeof(levels) / sizeof(levels[0]))];
+        }
+    }
+    return topic;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_dispatch_matches_reference()
+{
+    std::mt19937 rng(1);
+    MqttSubscribeParser parser;
+    std::vector<std::string> subscriptions;
+    std::vector<size_t> called;
+
+    for (size_t i = 0; i < 300; i++) {
+        // Some topics are subscribed more than once
+        subscriptions.push_back(randomTopic(rng, true));
+        parser.register_callback(subscriptions.back(), 0,
+            [&called, i](const espMqttClientTypes::MessageProperties&, const char*, const uint8_t*, size_t) { called.push_back(i); });
+    }
+
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            // Removes all callbacks of a topic
+            for (size_t i = 0; i < subscriptions.size(); i += 3) {
+                const std::string topic = subscriptions[i];
+                parser.unregister_callback(topic);
+                std::replace(subscriptions.begin(), subscriptions.end(), topic, std::string());
+            }
+        }
+
+        for (uint32_t m = 0; m < 20000; m++) {
+            const std::string topic = randomTopic(rng, false);
+
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < subscriptions.size(); i++) {
+                if (!subscriptions[i].empty() && referenceMatches(subscriptions[i], topic)) {
+                    expected.push_back(i);
+                }
+            }
+
+            called.clear();
+            parser.handle_message(properties, topic.c_str(), nullptr, 0);
+            std::sort(called.begin(), called.end());
+
+            TEST_ASSERT_TRUE_MESSAGE(expected == called, topic.c_str());
+        }
+    }
+}
+
+static void test_wildcards()
+{
+    MqttSubscribeParser parser;
+    uint32_t count = 0;
+    const auto cb = [&count](const espMqttClientTypes::MessageProperties&, const char*, const uint8_t*, size_t) { count++; };
+
+    parser.register_callback("solar/+/cmd/#", 0, cb);
+    parser.register_callback("#", 0, cb);
+
+    parser.handle_message(properties, "solar/116100000001/cmd/power", nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT32(2, count);
+
+    // '#' also matches the parent level
+    count = 0;
+    parser.handle_message(properties, "solar/116100000001/cmd", nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT32(2, count);
+
+    // Wildcards at the first level don't match topics starting with '$'
+    count = 0;
+    parser.handle_message(properties, "$SYS/broker/uptime", nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, count);
+}
+
+static void test_dispatch_benchmark()
+{
+    // Command topics of MqttHandleInverter for 40 inverters and the DTU
+    static const char* const commands[] = {
+        "limit_persistent_relative", "limit_persistent_absolute", "limit_nonpersistent_relative",
+        "limit_nonpersistent_absolute", "power", "restart", "reset_rf_stats"
+    };
+
+    MqttSubscribeParser parser;
+    std::vector<std::string> subscriptions;
+    uint32_t count = 0;
+    const auto cb = [&count](const espMqttClientTypes::MessageProperties&, const char*, const uint8_t*, size_t) { count++; };
+
+    std::vector<std::string> topics;
+    for (uint32_t i = 0; i < 40; i++) {
+        for (auto command : commands) {
+            const std::string topic = "solar/1161000000" + std::to_string(10 + i) + "/cmd/" + command;
+            subscriptions.push_back(topic);
+            topics.push_back(topic);
+        }
+    }
+    subscriptions.push_back("solar/dtu/cmd/#");
+    subscriptions.push_back("solar/+/cmd/restart");
+
+    for (auto& topic : subscriptions) {
+        parser.register_callback(topic, 0, cb);
+    }
+    printf("%zu subscriptions\n", subscriptions.size());
+
+    size_t next = 0;
+    Benchmark::run("MqttSubscribeParser::handle_message", 100000, [&] {
+        parser.handle_message(properties, topics[next++ % topics.size()].c_str(), nullptr, 0);
+    });
+
+    next = 0;
+    Benchmark::run("linear mosquitto_topic_matches_sub", 100000, [&] {
+        const char* topic = topics[next++ % topics.size()].c_str();
+        for (auto& sub : subscriptions) {
+            bool result;
+            if (mosquitto_topic_matches_sub(sub.c_str(), topic, &result) == MOSQ_ERR_SUCCESS && result) {
+                count++;
+            }
+        }
+    });
+
+    // Every message matches its own topic, restart also the wildcard subscription
+    TEST_ASSERT_GREATER_THAN_UINT32(0, count);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dispatch_matches_reference);
+    RUN_TEST(test_wildcards);
+    RUN_TEST(test_dispatch_benchmark);
+    return UNITY_END();
+}
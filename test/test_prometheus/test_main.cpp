@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "PrometheusExporter.h"
+#include <Benchmark.h>
+#include <Configuration.h>
+#include <Hoymiles.h>
+#include <random>
+#include <string>
+#include <unity.h>
+
+#include "../../src/PrometheusExporter.cpp"
+
+// Size of the sites the poll intervals are tuned for
+#define SITE_INVERTER_COUNT 10
+
+// Typical size of the chunks requested by the web server
+#define CHUNK_SIZE 1436
+
+static const uint64_t serials[SITE_INVERTER_COUNT] = {
+    0x112100000001, // HM_1CH
+    0x114100000002, // HM_2CH
+    0x116100000003, // HM_4CH
+    0x112400000004, // HMS_1CH
+    0x114400000006, // HMS_2CH
+    0x116400000007, // HMS_4CH
+    0x136100000008, // HMT_4CH
+    0x138200000009, // HMT_6CH
+    0x116100000010, // HM_4CH
+    0x116400000011, // HMS_4CH
+};
+
+ConfigurationClass Configuration;
+
+static INVERTER_CONFIG_T inverterConfig[SITE_INVERTER_COUNT] = {};
+
+INVERTER_CONFIG_T* ConfigurationClass::getInverterConfig(const uint64_t serial)
+{
+    for (uint8_t i = 0; i < SITE_INVERTER_COUNT; i++) {
+        if (serials[i] == serial) {
+            return &inverterConfig[i];
+        }
+    }
+    return nullptr;
+}
+
+// Fixed values instead of the ESP system information
+class TestExporter : public PrometheusExporter {
+protected:
+    int printSystemMetric(char* line, const size_t size, const uint8_t family) override
+    {
+        return snprintf(line, size, "%s 1\n", _families[family].name);
+    }
+};
+
+static TestExporter exporter;
+
+static std::string scrape(const size_t chunkSize)
+{
+    std::string out;
+    std::vector<uint8_t> buffer(chunkSize);
+    PrometheusExporter::Scrape_t state;
+
+    size_t len;
+    while ((len = exporter.fillChunk(state, buffer.data(), buffer.size())) > 0) {
+        out.append(reinterpret_cast<const char*>(buffer.data()), len);
+    }
+    return out;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_scrape_does_not_allocate()
+{
+    uint8_t buffer[CHUNK_SIZE];
+    size_t bytes = 0;
+    size_t chunks = 0;
+
+    exporter.updateLabels();
+
+    const Benchmark::AllocationCounter counter;
+    PrometheusExporter::Scrape_t state;
+    size_t len;
+    while ((len = exporter.fillChunk(state, buffer, sizeof(buffer))) > 0) {
+        bytes += len;
+        chunks++;
+    }
+    const size_t allocations = counter.count();
+
+    printf("BENCH scrape of %u inverters: %zu bytes in %zu chunks, %zu allocations\n",
+        SITE_INVERTER_COUNT, bytes, chunks, allocations);
+
+    Benchmark::run("scrape 10 inverters", 100, [&] {
+        PrometheusExporter::Scrape_t state;
+        while (exporter.fillChunk(state, buffer, sizeof(buffer)) > 0) {
+        }
+    });
+
+    TEST_ASSERT_EQUAL_size_t(0, allocations);
+    TEST_ASSERT_GREATER_THAN(SITE_INVERTER_COUNT * CHUNK_SIZE / 2, bytes);
+}
+
+static void test_output_is_independent_of_chunk_size()
+{
+    exporter.updateLabels();
+
+    const std::string reference = scrape(4096);
+    TEST_ASSERT_TRUE(reference == scrape(1));
+    TEST_ASSERT_TRUE(reference == scrape(7));
+    TEST_ASSERT_TRUE(reference == scrape(PROMETHEUS_LINE_SIZE));
+}
+
+static void test_every_family_has_one_header()
+{
+    exporter.updateLabels();
+    const std::string out = scrape(CHUNK_SIZE);
+
+    size_t headers = 0;
+    for (size_t pos = out.find("# TYPE "); pos != std::string::npos; pos = out.find("# TYPE ", pos + 1)) {
+        const std::string name = out.substr(pos + 7, out.find(' ', pos + 7) - pos - 7);
+        TEST_ASSERT_TRUE(out.find("# TYPE " + name + " ", pos + 1) == std::string::npos);
+        headers++;
+    }
+    TEST_ASSERT_GREATER_THAN(20, headers);
+}
+
+static void test_all_inverters_are_exported()
+{
+    exporter.updateLabels();
+    const std::string out = scrape(CHUNK_SIZE);
+
+    for (auto serial : serials) {
+        char label[32];
+        snprintf(label, sizeof(label), "serial=\"%012" PRIx64 "\"", serial);
+        TEST_ASSERT_TRUE_MESSAGE(out.find(std::string("opendtu_Power{") + label) != std::string::npos, label);
+        TEST_ASSERT_TRUE_MESSAGE(out.find(std::string("opendtu_PanelInfo{") + label) != std::string::npos, label);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+
+    Hoymiles.init();
+    for (auto serial : serials) {
+        auto inv = Hoymiles.addInverter("inverter", serial);
+
+        uint8_t payload[STATISTIC_PACKET_SIZE];
+        for (auto& b : payload) {
+            b = rng();
+        }
+
+        StatisticsParser* parser = inv->Statistics();
+        parser->beginAppendFragment();
+        parser->clearBuffer();
+        parser->appendFragment(0, payload, parser->getExpectedByteCount());
+        parser->endAppendFragment();
+        parser->setLastUpdate(millis());
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_scrape_does_not_allocate);
+    RUN_TEST(test_output_is_independent_of_chunk_size);
+    RUN_TEST(test_every_family_has_one_header);
+    RUN_TEST(test_all_inverters_are_exported);
+    return UNITY_END();
+}
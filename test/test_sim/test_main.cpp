@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <Benchmark.h>
+#include <Hoymiles.h>
+#include <algorithm>
+#include <commands/ActivePowerControlCommand.h>
+#include <unity.h>
+#include <vector>
+
+// Size of the sites the poll intervals are tuned for
+#define SITE_INVERTER_COUNT 10
+
+#define SIM_DTU_SERIAL 0x199980123456
+
+// Injected errors of the polling runs
+#define SIM_FRAGMENT_LOSS 5
+#define SIM_FRAGMENT_CORRUPTION 5
+
+// Duration of each polling run in ms
+#define SIM_RUN_DURATION 8000
+
+static std::vector<std::shared_ptr<InverterAbstract>> inverters;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Runs the library until the condition is true or the timeout expired, returns the elapsed time in ms
+template <typename F>
+static uint32_t runUntil(F&& condition, const uint32_t timeout)
+{
+    const uint32_t start = millis();
+    while (!condition() && millis() - start < timeout) {
+        Hoymiles.loop();
+        delay(1);
+    }
+    return millis() - start;
+}
+
+static void addInverters(const uint8_t count)
+{
+    while (inverters.size() < count) {
+        inverters.push_back(Hoymiles.addInverter("sim", 0x116180000000 + inverters.size()));
+    }
+}
+
+static void test_limit_latency_in_simulator()
+{
+    addInverters(SITE_INVERTER_COUNT);
+
+    HoymilesRadio* radio = Hoymiles.getRadioSim();
+    uint32_t sumLatency = 0;
+    uint32_t maxLatency = 0;
+    uint32_t sumQueued = 0;
+
+    // Every further limit command would have to wait behind the polls which were already bypassed too often
+    const uint8_t runs = COMMAND_QUEUE_MAX_BYPASS;
+
+    for (uint8_t run = 0; run < runs; run++) {
+        // Wait until the poll of all inverters was enqueued
+        runUntil([&] { return radio->getQueueSize() >= SITE_INVERTER_COUNT; }, 10000);
+        sumQueued += radio->getQueueSize();
+
+        auto iv = inverters[(run * 3) % SITE_INVERTER_COUNT];
+        iv->sendActivePowerControlRequest(50 + run, PowerLimitControlType::RelativNonPersistent);
+
+        const uint32_t latency = runUntil([&] { return iv->SystemConfigPara()->getLastLimitCommandSuccess() != CMD_PENDING; }, 10000);
+        TEST_ASSERT_TRUE(iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_OK);
+
+        sumLatency += latency;
+        maxLatency = std::max(maxLatency, latency);
+    }
+
+    printf("limit to ack latency with %.1f queued commands: %u ms average, %u ms max\n",
+        static_cast<float>(sumQueued) / runs, sumLatency / runs, maxLatency);
+
+    // The radio waits for the complete RX period of every command. A limit command
+    // only waits for the command which is currently processed (at most the 750 ms
+    // of AlarmDataCommand) and its own 2000 ms instead of all queued polls.
+    const uint32_t limitTimeout = ActivePowerControlCommand(inverters[0].get()).getTimeout();
+    TEST_ASSERT_LESS_THAN_UINT32(limitTimeout + 750 + 250, maxLatency);
+}
+
+static void runPolling(const uint8_t count)
+{
+    addInverters(count);
+    for (auto& inv : inverters) {
+        inv->resetRadioStats();
+    }
+
+    HoymilesRadio_Sim* radio = Hoymiles.getRadioSim();
+    radio->setFragmentLoss(SIM_FRAGMENT_LOSS);
+    radio->setFragmentCorruption(SIM_FRAGMENT_CORRUPTION);
+
+    const uint32_t duration = runUntil([] { return false; }, SIM_RUN_DURATION);
+
+    // All requests of a poll (statistics, alarm log, limit, device info, grid profile) and the successful statistics requests
+    uint32_t requests = 0;
+    uint32_t retransmits = 0;
+    uint32_t success = 0;
+    uint32_t polls = 0;
+    for (auto& inv : inverters) {
+        const RetransmitHistogram_t& histogram = inv->getRetransmitHistogram();
+        requests += histogram.getTotal();
+        retransmits += histogram.getSum();
+        success += inv->RadioStats.RxSuccess;
+        polls += inv->getRttHistogram(CommandType::RealTimeRunData).getTotal();
+    }
+
+    printf("BENCH %u inverters, %u%% loss, %u%% corruption: %.2f statistics polls/s, %.2f requests/s, %.2f retransmits/request, %.1f%% successful\n",
+        count, SIM_FRAGMENT_LOSS, SIM_FRAGMENT_CORRUPTION,
+        polls * 1000.0f / duration, requests * 1000.0f / duration,
+        requests > 0 ? static_cast<float>(retransmits) / requests : 0,
+        requests > 0 ? success * 100.0f / requests : 0);
+
+    TEST_ASSERT_TRUE(polls > 0);
+    TEST_ASSERT_TRUE(retransmits > 0);
+    TEST_ASSERT_TRUE(success > 0);
+
+    radio->setFragmentLoss(0);
+    radio->setFragmentCorruption(0);
+}
+
+static void test_polling_10_inverters()
+{
+    runPolling(10);
+}
+
+static void test_polling_25_inverters()
+{
+    runPolling(25);
+}
+
+static void test_polling_50_inverters()
+{
+    runPolling(50);
+}
+
+int main()
+{
+    Hoymiles.init();
+    Hoymiles.initSim();
+    Hoymiles.getRadioSim()->setDtuSerial(SIM_DTU_SERIAL);
+    Hoymiles.getRadioSim()->setSeed(1);
+
+    // Poll as fast as the radio is able to
+    Hoymiles.setPollInterval(0);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_limit_latency_in_simulator);
+    RUN_TEST(test_polling_10_inverters);
+    RUN_TEST(test_polling_25_inverters);
+    RUN_TEST(test_polling_50_inverters);
+    return UNITY_END();
+}
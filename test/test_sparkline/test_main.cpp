@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "SparklineBuffer.h"
+#include <Benchmark.h>
+#include <algorithm>
+#include <random>
+#include <unity.h>
+#include <vector>
+
+#include "../../src/SparklineBuffer.cpp"
+
+static std::mt19937 rng(1);
+
+static SparklineBuffer sparkline;
+
+// All buckets appended since the last clear, the reference for the pyramid
+static std::vector<SparklineBucket_t> appended;
+
+static void append(const SparklineBucket_t& bucket)
+{
+    sparkline.append(bucket);
+    appended.push_back(bucket);
+}
+
+static SparklineBucket_t randomBucket()
+{
+    std::uniform_real_distribution<float> value(-1000, 1000);
+    std::uniform_real_distribution<float> spread(0, 100);
+
+    SparklineBucket_t bucket;
+    bucket.avg = value(rng);
+    bucket.min = bucket.avg - spread(rng);
+    bucket.max = bucket.avg + spread(rng);
+    return bucket;
+}
+
+// Merges the base buckets [lo, hi) one by one like the points are defined
+static SparklineBucket_t bruteForce(const uint32_t lo, const uint32_t hi)
+{
+    SparklineBucket_t result = appended[lo];
+    double sum = 0;
+    for (uint32_t i = lo; i < hi; i++) {
+        result.min = std::min(result.min, appended[i].min);
+        result.max = std::max(result.max, appended[i].max);
+        sum += appended[i].avg;
+    }
+    result.avg = sum / (hi - lo);
+    return result;
+}
+
+static void checkResample(const uint16_t points)
+{
+    const uint32_t count = appended.size();
+    const uint32_t first = count - std::min<uint32_t>(count, SPARKLINE_CAPACITY);
+
+    SparklineBucket_t out[SPARKLINE_CAPACITY];
+    const uint16_t filled = sparkline.resample(out, points);
+
+    uint16_t expected = 0;
+    for (uint16_t point = 0; point < points; point++) {
+        const uint32_t lo = first + static_cast<uint32_t>(point) * SPARKLINE_CAPACITY / points;
+        const uint32_t hi = std::min<uint32_t>(first + static_cast<uint32_t>(point + 1) * SPARKLINE_CAPACITY / points, count);
+        if (lo >= count) {
+            break;
+        }
+        expected++;
+
+        const SparklineBucket_t reference = bruteForce(lo, hi);
+        TEST_ASSERT_EQUAL_FLOAT(reference.min, out[point].min);
+        TEST_ASSERT_EQUAL_FLOAT(reference.max, out[point].max);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, reference.avg, out[point].avg);
+    }
+    TEST_ASSERT_EQUAL_UINT16(expected, filled);
+}
+
+void setUp()
+{
+    sparkline.clear();
+    appended.clear();
+}
+
+void tearDown()
+{
+}
+
+static void test_append_wraps_around()
+{
+    for (uint32_t i = 0; i < 3 * SPARKLINE_CAPACITY + 5; i++) {
+        SparklineBucket_t bucket = { static_cast<float>(i), static_cast<float>(i), static_cast<float>(i) };
+        append(bucket);
+        TEST_ASSERT_EQUAL_UINT16(std::min<uint32_t>(i + 1, SPARKLINE_CAPACITY), sparkline.size());
+    }
+
+    // One point per base bucket returns the newest buckets, the oldest first
+    SparklineBucket_t out[SPARKLINE_CAPACITY];
+    TEST_ASSERT_EQUAL_UINT16(SPARKLINE_CAPACITY, sparkline.resample(out, SPARKLINE_CAPACITY));
+    for (uint16_t i = 0; i < SPARKLINE_CAPACITY; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(2 * SPARKLINE_CAPACITY + 5 + i, out[i].avg);
+    }
+
+    sparkline.clear();
+    TEST_ASSERT_EQUAL_UINT16(0, sparkline.size());
+    TEST_ASSERT_EQUAL_UINT16(0, sparkline.resample(out, SPARKLINE_CAPACITY));
+}
+
+static void test_resample_against_brute_force()
+{
+    std::uniform_int_distribution<uint32_t> fill(1, 5 * SPARKLINE_CAPACITY);
+    std::uniform_int_distribution<uint16_t> width(1, SPARKLINE_CAPACITY);
+
+    for (uint32_t run = 0; run < 200; run++) {
+        setUp();
+        const uint32_t count = fill(rng);
+        for (uint32_t i = 0; i < count; i++) {
+            append(randomBucket());
+        }
+
+        for (uint8_t n = 0; n < 10; n++) {
+            checkResample(width(rng));
+        }
+    }
+}
+
+static void test_resample_every_width_at_every_offset()
+{
+    // All alignments of the window to the pyramid, partially and completely filled
+    for (uint32_t i = 0; i < 2 * SPARKLINE_CAPACITY; i++) {
+        append(randomBucket());
+        for (uint16_t points = 1; points <= SPARKLINE_CAPACITY; points++) {
+            checkResample(points);
+        }
+    }
+}
+
+static void test_resample_benchmark()
+{
+    for (uint32_t i = 0; i < 3 * SPARKLINE_CAPACITY; i++) {
+        append(randomBucket());
+    }
+
+    const SparklineBucket_t bucket = randomBucket();
+    Benchmark::run("SparklineBuffer::append", 1000000, [&] {
+        sparkline.append(bucket);
+    });
+
+    SparklineBucket_t out[SPARKLINE_CAPACITY];
+    Benchmark::run("SparklineBuffer::resample 128 points", 100000, [&] {
+        Benchmark::doNotOptimize(sparkline.resample(out, SPARKLINE_CAPACITY));
+    });
+    Benchmark::run("SparklineBuffer::resample 37 points", 100000, [&] {
+        Benchmark::doNotOptimize(sparkline.resample(out, 37));
+    });
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_append_wraps_around);
+    RUN_TEST(test_resample_against_brute_force);
+    RUN_TEST(test_resample_every_width_at_every_offset);
+    RUN_TEST(test_resample_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <Benchmark.h>
+#include <SpscRingBuffer.h>
+#include <ThreadSafeQueue.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <types.h>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Fills the fragment with data derived from the sequence number
+static void makeFragment(fragment_t& fragment, const uint32_t sequence)
+{
+    fragment.len = 1 + sequence % MAX_RF_PAYLOAD_SIZE;
+    for (uint8_t i = 0; i < MAX_RF_PAYLOAD_SIZE; i++) {
+        fragment.fragment[i] = static_cast<uint8_t>(sequence >> (8 * (i % 4))) ^ i;
+    }
+}
+
+static void test_capacity()
+{
+    SpscRingBuffer<uint32_t, 8> buffer;
+    TEST_ASSERT_TRUE(buffer.empty());
+
+    for (uint32_t i = 0; i < buffer.capacity(); i++) {
+        TEST_ASSERT_TRUE(buffer.push(i));
+    }
+    TEST_ASSERT_TRUE(buffer.full());
+    TEST_ASSERT_FALSE(buffer.push(8));
+    TEST_ASSERT_EQUAL_size_t(8, buffer.size());
+
+    uint32_t value;
+    for (uint32_t i = 0; i < buffer.capacity(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(i, buffer.front());
+        TEST_ASSERT_TRUE(buffer.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+    }
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_FALSE(buffer.pop(value));
+}
+
+static void test_wrap_around()
+{
+    SpscRingBuffer<uint32_t, 4> buffer;
+    uint32_t value;
+    for (uint32_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(buffer.push(i));
+        TEST_ASSERT_TRUE(buffer.push(i + 1000));
+        TEST_ASSERT_TRUE(buffer.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+        TEST_ASSERT_EQUAL_UINT32(i + 1000, buffer.front());
+        buffer.pop();
+    }
+    TEST_ASSERT_TRUE(buffer.empty());
+}
+
+static void test_producer_consumer_stress()
+{
+    // Same type and capacity as the radio RX buffers
+    static SpscRingBuffer<fragment_t, 32> buffer;
+    const uint32_t count = 2000000;
+
+    // Starting and ending the threads allocates, only the transfer itself is counted
+    std::atomic<bool> start = { false };
+    std::atomic<uint32_t> running = { 0 };
+    std::atomic<uint32_t> finished = { 0 };
+
+    uint32_t dropped = 0;
+    std::thread producer([&] {
+        running++;
+        while (!start) {
+            std::this_thread::yield();
+        }
+        fragment_t fragment;
+        for (uint32_t sequence = 0; sequence < count; sequence++) {
+            makeFragment(fragment, sequence);
+            while (!buffer.push(fragment)) {
+                // The radio drops the fragment, here it is retried to check the order
+                dropped++;
+                std::this_thread::yield();
+            }
+        }
+        finished++;
+    });
+
+    uint32_t errors = 0;
+    std::thread consumer([&] {
+        running++;
+        while (!start) {
+            std::this_thread::yield();
+        }
+        fragment_t fragment;
+        fragment_t expected;
+        for (uint32_t sequence = 0; sequence < count;) {
+            if (!buffer.pop(fragment)) {
+                std::this_thread::yield();
+                continue;
+            }
+            makeFragment(expected, sequence);
+            if (fragment.len != expected.len || memcmp(fragment.fragment, expected.fragment, sizeof(expected.fragment)) != 0) {
+                errors++;
+            }
+            sequence++;
+        }
+        finished++;
+    });
+
+    while (running < 2) {
+        std::this_thread::yield();
+    }
+    const Benchmark::AllocationCounter counter;
+    start = true;
+    while (finished < 2) {
+        std::this_thread::yield();
+    }
+    const size_t allocations = counter.count();
+
+    producer.join();
+    consumer.join();
+
+    printf("%u fragments transferred, producer found the buffer full %u times\n", count, dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_EQUAL_size_t(0, allocations);
+}
+
+static void test_queue_benchmark()
+{
+    fragment_t fragment;
+    makeFragment(fragment, 1);
+
+    SpscRingBuffer<fragment_t, 32> ring;
+    Benchmark::run("SpscRingBuffer push + pop", 1000000, [&] {
+        ring.push(fragment);
+        ring.pop(fragment);
+    });
+
+    ThreadSafeQueue<fragment_t> queue;
+    Benchmark::run("ThreadSafeQueue push + pop", 1000000, [&] {
+        queue.push(fragment);
+        fragment = queue.front();
+        queue.pop();
+    });
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_capacity);
+    RUN_TEST(test_wrap_around);
+    RUN_TEST(test_producer_consumer_stress);
+    RUN_TEST(test_queue_benchmark);
+    return UNITY_END();
+}
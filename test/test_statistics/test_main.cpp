@@ -0,0 +1,324 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <Benchmark.h>
+#include <Hoymiles.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <crc.h>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <unity.h>
+
+struct Model_t {
+    const char* name;
+    uint64_t serial;
+};
+
+// One serial of every supported model
+static const Model_t models[] = {
+    { "HM_1CH", 0x112100000001 },
+    { "HM_2CH", 0x114100000002 },
+    { "HM_4CH", 0x116100000003 },
+    { "HMS_1CH", 0x112400000004 },
+    { "HMS_1CHv2", 0x112500000005 },
+    { "HMS_2CH", 0x114400000006 },
+    { "HMS_4CH", 0x116400000007 },
+    { "HMT_4CH", 0x136100000008 },
+    { "HMT_6CH", 0x138200000009 },
+    { "HERF_1CH", 0x284100000010 },
+    { "HERF_2CH", 0x282100000011 },
+    { "HERF_4CH", 0x280100000012 },
+};
+
+// Size of the sites the poll intervals are tuned for
+#define SITE_INVERTER_COUNT 10
+
+static std::mt19937 rng(1);
+
+static void fillPayload(StatisticsParser& parser, const uint8_t* payload)
+{
+    parser.beginAppendFragment();
+    parser.clearBuffer();
+    parser.appendFragment(0, payload, parser.getExpectedByteCount());
+    parser.endAppendFragment();
+}
+
+static void randomPayload(uint8_t* payload)
+{
+    for (uint8_t i = 0; i < STATISTIC_PACKET_SIZE; i++) {
+        payload[i] = rng();
+    }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_all_models_are_created()
+{
+    for (auto& model : models) {
+        auto inv = Hoymiles.getInverterBySerial(model.serial);
+        TEST_ASSERT_NOT_NULL_MESSAGE(inv.get(), model.name);
+        TEST_ASSERT_NOT_NULL_MESSAGE(inv->getStatisticsDecoder(), model.name);
+    }
+}
+
+static void test_field_lookup_matches_linear_scan()
+{
+    for (auto& model : models) {
+        auto inv = Hoymiles.getInverterBySerial(model.serial);
+        StatisticsParser* stats = inv->Statistics();
+        const byteAssign_t* assignment = inv->getByteAssignment();
+        const uint8_t size = inv->getByteAssignmentSize();
+
+        for (uint8_t t = 0; t < TYPE_CNT; t++) {
+            for (uint8_t c = 0; c < CH_CNT; c++) {
+                for (uint8_t f = 0; f < FLD_CNT; f++) {
+                    const ChannelType_t type = static_cast<ChannelType_t>(t);
+                    const ChannelNum_t channel = static_cast<ChannelNum_t>(c);
+                    const FieldId_t fieldId = static_cast<FieldId_t>(f);
+
+                    const byteAssign_t* expected = nullptr;
+                    for (uint8_t i = 0; i < size; i++) {
+                        if (assignment[i].type == type && assignment[i].ch == channel && assignment[i].fieldId == fieldId) {
+                            expected = &assignment[i];
+                            break;
+                        }
+                    }
+
+                    TEST_ASSERT_TRUE_MESSAGE(expected == stats->getAssignmentByChannelField(type, channel, fieldId), model.name);
+                    TEST_ASSERT_TRUE_MESSAGE((expected != nullptr) == stats->hasChannelFieldValue(type, channel, fieldId), model.name);
+                }
+            }
+        }
+    }
+}
+
+static void test_channel_maps_match_byte_assignment()
+{
+    for (auto& model : models) {
+        auto inv = Hoymiles.getInverterBySerial(model.serial);
+        StatisticsParser* stats = inv->Statistics();
+        const byteAssign_t* assignment = inv->getByteAssignment();
+        const uint8_t size = inv->getByteAssignmentSize();
+
+        TEST_ASSERT_EQUAL_MESSAGE(TYPE_CNT, stats->getChannelTypes().size(), model.name);
+
+        for (auto& type : stats->getChannelTypes()) {
+            // Channels in the order of their first appearance
+            std::vector<ChannelNum_t> expected;
+            for (uint8_t i = 0; i < size; i++) {
+                if (assignment[i].type == type && std::find(expected.begin(), expected.end(), assignment[i].ch) == expected.end()) {
+                    expected.push_back(assignment[i].ch);
+                }
+            }
+
+            const auto channels = stats->getChannelsByType(type);
+            TEST_ASSERT_EQUAL_MESSAGE(expected.size(), channels.size(), model.name);
+            TEST_ASSERT_TRUE_MESSAGE(std::equal(expected.begin(), expected.end(), channels.begin()), model.name);
+        }
+    }
+}
+
+static void test_decoder_matches_generic_parser()
+{
+    uint8_t payload[STATISTIC_PACKET_SIZE];
+
+    for (auto& model : models) {
+        auto inv = Hoymiles.getInverterBySerial(model.serial);
+        const byteAssign_t* assignment = inv->getByteAssignment();
+        const uint8_t size = inv->getByteAssignmentSize();
+
+        StatisticsParser generic;
+        generic.setByteAssignment(assignment, size);
+        StatisticsParser specialized;
+        specialized.setByteAssignment(assignment, size, inv->getStatisticsDecoder());
+
+        for (uint8_t c = 0; c < CH_CNT; c++) {
+            const uint16_t maxPower = c * 100;
+            generic.setStringMaxPower(c, maxPower);
+            specialized.setStringMaxPower(c, maxPower);
+        }
+
+        for (uint16_t run = 0; run < 1000; run++) {
+            // Offsets are applied to the decoded values and change the calculated ones
+            if (run % 10 == 0) {
+                for (uint8_t i = 0; i < size; i++) {
+                    const float offset = static_cast<float>(rng() % 2000) / 10 - 100;
+                    generic.setChannelFieldOffset(assignment[i].type, assignment[i].ch, assignment[i].fieldId, offset);
+                    specialized.setChannelFieldOffset(assignment[i].type, assignment[i].ch, assignment[i].fieldId, offset);
+                }
+            }
+
+            randomPayload(payload);
+            fillPayload(generic, payload);
+            fillPayload(specialized, payload);
+
+            for (uint8_t i = 0; i < size; i++) {
+                const float expected = generic.getChannelFieldValue(assignment[i].type, assignment[i].ch, assignment[i].fieldId);
+                const float actual = specialized.getChannelFieldValue(assignment[i].type, assignment[i].ch, assignment[i].fieldId);
+
+                // The values have to be bit identical, not only close
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&expected, &actual, sizeof(float), model.name);
+            }
+        }
+    }
+}
+
+static void test_snapshot_is_consistent_during_updates()
+{
+    StatisticsParser* stats = Hoymiles.getInverterBySerial(models[0].serial)->Statistics();
+    std::atomic<bool> stop = { false };
+
+    std::thread writer([&] {
+        uint8_t payload[STATISTIC_PACKET_SIZE];
+        uint8_t value = 0;
+        while (!stop) {
+            // All bytes of a frame are equal, so all raw values of one snapshot have to match
+            memset(payload, ++value, sizeof(payload));
+            fillPayload(*stats, payload);
+        }
+    });
+
+    // First and last field of the HM_1CH payload
+    const byteAssign_t* udc = stats->getAssignmentByChannelField(TYPE_DC, CH0, FLD_UDC);
+    const byteAssign_t* pf = stats->getAssignmentByChannelField(TYPE_AC, CH0, FLD_PF);
+    uint32_t inconsistent = 0;
+    StatisticsSnapshot snapshot;
+    for (uint32_t i = 0; i < 200000; i++) {
+        stats->getSnapshot(snapshot);
+        const uint32_t rawUdc = lroundf(snapshot.getChannelFieldValue(TYPE_DC, CH0, FLD_UDC) * udc->div);
+        const uint32_t rawPf = lroundf(snapshot.getChannelFieldValue(TYPE_AC, CH0, FLD_PF) * pf->div);
+        if (rawUdc != rawPf) {
+            inconsistent++;
+        }
+    }
+
+    stop = true;
+    writer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, inconsistent);
+}
+
+// Reads every field of every channel like the MQTT, websocket and Prometheus publishers do
+static size_t readAllFields(StatisticsParser* stats, StatisticsSnapshot& snapshot, char* buffer, const size_t size)
+{
+    size_t len = 0;
+    stats->getSnapshot(snapshot);
+    for (auto& type : stats->getChannelTypes()) {
+        for (auto& channel : stats->getChannelsByType(type)) {
+            for (uint8_t f = 0; f < FLD_CNT; f++) {
+                const FieldId_t fieldId = static_cast<FieldId_t>(f);
+                if (!stats->hasChannelFieldValue(type, channel, fieldId)) {
+                    continue;
+                }
+                len += snprintf(buffer, size, "%s %s %.*f",
+                    stats->getChannelFieldName(type, channel, fieldId),
+                    stats->getChannelFieldUnit(type, channel, fieldId),
+                    stats->getChannelFieldDigits(type, channel, fieldId),
+                    snapshot.getChannelFieldValue(type, channel, fieldId));
+            }
+        }
+    }
+    return len;
+}
+
+static void test_publish_cycle_does_not_allocate()
+{
+    StatisticsSnapshot snapshot;
+    char buffer[64];
+
+    const Benchmark::AllocationCounter counter;
+    for (uint8_t i = 0; i < SITE_INVERTER_COUNT; i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        Benchmark::doNotOptimize(readAllFields(inv->Statistics(), snapshot, buffer, sizeof(buffer)));
+    }
+    TEST_ASSERT_EQUAL_size_t(0, counter.count());
+}
+
+static void test_statistics_benchmark()
+{
+    StatisticsParser* stats = Hoymiles.getInverterBySerial(0x116100000003)->Statistics();
+
+    Benchmark::run("getChannelFieldValue", 1000000, [&] {
+        Benchmark::doNotOptimize(stats->getChannelFieldValue(TYPE_DC, CH4, FLD_YT));
+    });
+
+    Benchmark::run("hasChannelFieldValue (missing field)", 1000000, [&] {
+        Benchmark::doNotOptimize(stats->hasChannelFieldValue(TYPE_DC, CH4, FLD_IAC_3));
+    });
+
+    StatisticsSnapshot snapshot;
+    Benchmark::run("getSnapshot (HM_4CH)", 1000000, [&] {
+        stats->getSnapshot(snapshot);
+        Benchmark::doNotOptimize(snapshot);
+    });
+
+    char buffer[64];
+    Benchmark::run("read all fields of 10 inverters", 10000, [&] {
+        for (uint8_t i = 0; i < SITE_INVERTER_COUNT; i++) {
+            Benchmark::doNotOptimize(readAllFields(Hoymiles.getInverterByPos(i)->Statistics(), snapshot, buffer, sizeof(buffer)));
+        }
+    });
+}
+
+static void test_decode_benchmark()
+{
+    uint8_t payload[STATISTIC_PACKET_SIZE];
+    randomPayload(payload);
+
+    for (auto& model : models) {
+        auto inv = Hoymiles.getInverterBySerial(model.serial);
+
+        StatisticsParser generic;
+        generic.setByteAssignment(inv->getByteAssignment(), inv->getByteAssignmentSize());
+        StatisticsParser specialized;
+        specialized.setByteAssignment(inv->getByteAssignment(), inv->getByteAssignmentSize(), inv->getStatisticsDecoder());
+
+        char name[64];
+        snprintf(name, sizeof(name), "decode %s generic", model.name);
+        Benchmark::run(name, 100000, [&] { fillPayload(generic, payload); });
+        snprintf(name, sizeof(name), "decode %s specialized", model.name);
+        Benchmark::run(name, 100000, [&] { fillPayload(specialized, payload); });
+    }
+}
+
+static void test_rx_fragment_benchmark()
+{
+    auto inv = Hoymiles.getInverterBySerial(0x116100000003);
+
+    // Main command, serial of the inverter and the DTU, fragment id, 16 bytes of payload and CRC8
+    uint8_t fragment[MAX_RF_PAYLOAD_SIZE] = { 0x95, 0x61, 0x00, 0x00, 0x03, 0x61, 0x00, 0x00, 0x03, 0x01 };
+    const uint8_t len = 27;
+    fragment[len - 1] = crc8(fragment, len - 1);
+
+    Benchmark::run("addRxFragment", 1000000, [&] {
+        inv->addRxFragment(fragment, len, -60);
+    });
+    inv->clearRxFragmentBuffer();
+}
+
+int main()
+{
+    Hoymiles.init();
+    for (auto& model : models) {
+        Hoymiles.addInverter(model.name, model.serial);
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_all_models_are_created);
+    RUN_TEST(test_field_lookup_matches_linear_scan);
+    RUN_TEST(test_channel_maps_match_byte_assignment);
+    RUN_TEST(test_decoder_matches_generic_parser);
+    RUN_TEST(test_snapshot_is_consistent_during_updates);
+    RUN_TEST(test_publish_cycle_does_not_allocate);
+    RUN_TEST(test_statistics_benchmark);
+    RUN_TEST(test_decode_benchmark);
+    RUN_TEST(test_rx_fragment_benchmark);
+    return UNITY_END();
+}
@@ -9,6 +9,11 @@ export interface CountryDef {
 export interface DtuConfig {
     serial: string;
     pollinterval: number;
+    adaptivepoll: boolean;
+    pollinterval_min: number;
+    pollinterval_max: number;
+    history_enabled: boolean;
+    history_interval: number;
     nrf_enabled: boolean;
     nrf_palevel: number;
     cmt_enabled: boolean;
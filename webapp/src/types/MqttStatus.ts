@@ -7,6 +7,10 @@ export interface MqttStatus {
     mqtt_topic: string;
     mqtt_publish_interval: number;
     mqtt_clean_session: boolean;
+    mqtt_payload_mode: number;
+    mqtt_onchange_enabled: boolean;
+    mqtt_onchange_maxage: number;
+    mqtt_onchange_deadband: number;
     mqtt_retain: boolean;
     mqtt_tls: boolean;
     mqtt_root_ca_cert_info: string;